@@ -48,6 +48,8 @@ typedef enum {
                                                             Callback should end and release any resources used when it's done. */
     connector_request_id_remote_config_session_cancel,  /**< Requesting callback to abort and cancel any query or set remote configuration request.
                                                             Callback should stop and release any resources used */
+    connector_request_id_remote_config_group_query,    /**< requesting callback to query all elements of a configuration group instance at once.
+                                                            Only used when CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS is defined */
 #if defined DOCUMENT_LEGACY_COMMANDS
     connector_request_id_remote_config_do_command,     /**< requesting callback to process a do_command command */
     connector_request_id_remote_config_reboot,         /**< requesting callback to process a reboot command */
@@ -327,6 +329,7 @@ typedef struct {
 * -# @ref connector_request_id_remote_config_action_start
 * -# @ref connector_request_id_remote_config_group_start
 * -# @ref connector_request_id_remote_config_group_process
+* -# @ref connector_request_id_remote_config_group_query
 * -# @ref connector_request_id_remote_config_group_end
 * -# @ref connector_request_id_remote_config_action_end
 * -# @ref connector_request_id_remote_config_session_end
@@ -354,7 +357,9 @@ typedef struct {
                                         to Device Cloud if an error is encountered.
                                         Note: this string cannot be altered until next callback call.
                                       */
-      connector_element_value_t * element_value; /**< Pointer to memory where callback writes the element value */
+      connector_element_value_t * element_value; /**< Pointer to memory where callback writes the element value.
+                                                      For @ref connector_request_id_remote_config_group_query it points to
+                                                      an array indexed by element id with an entry for every element of the group */
   } response;                        /**< Callback writes compare_matches to skip response for the group/element, error hint if error is encountered or the value of the element */
 } connector_remote_config_t;
 /**
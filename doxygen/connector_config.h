@@ -82,6 +82,24 @@
  */
 #define CONNECTOR_FIRMWARE_SERVICE
 
+/**
+ * When defined, Cloud Connector streams @ref fw_image_data "firmware image data" through a queue of this many blocks.
+ * Each binary block is copied into the queue and acknowledged to Device Cloud right away, and the
+ * @ref connector_request_id_firmware_download_data callback is called for the queued blocks on later
+ * connector_step() calls. A callback that returns @ref connector_callback_busy while it writes to flash then
+ * no longer stops the EDP receive; the receive only waits when the queue is full.
+ * A block the callback rejects aborts the download, even though it has already been acknowledged.
+ * The @ref connector_request_id_firmware_download_complete callback is called once all queued blocks are written.
+ *
+ * If not defined, each block is passed to the callback as it is received.
+ *
+ * @note Each queue entry uses about @ref MSG_MAX_RECV_PACKET_SIZE bytes of RAM in the firmware facility.
+ * @note This define is only used when @ref CONNECTOR_FIRMWARE_SERVICE is defined.
+ *
+ * @see connector_get_firmware_download_stats()
+ */
+#define CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE   4
+
 /**
  * When defined, Cloud Connector includes the @ref zlib "compression" support used with the
  * @ref data_service.
@@ -111,6 +129,54 @@
  */
 #define CONNECTOR_COMPRESSION
 
+/**
+ * Number of zlib streams Cloud Connector keeps initialized for reuse when @ref CONNECTOR_COMPRESSION
+ * is defined. A compressed session takes a stream from this pool instead of allocating a new window
+ * and hash table every time. Streams needed above this number are allocated and released on demand.
+ *
+ * When @ref CONNECTOR_NO_MALLOC is defined this is the total number of streams, so it also bounds
+ * the number of compressed sessions that can run at the same time. The default is 2.
+ *
+ * @code
+ * #define CONNECTOR_COMPRESSION_STREAMS    2
+ * @endcode
+ *
+ * @see @ref CONNECTOR_COMPRESSION_MEMORY_LEVEL
+ */
+#define CONNECTOR_COMPRESSION_STREAMS    2
+
+/**
+ * zlib memLevel (1 to 9) used for deflate streams when @ref CONNECTOR_COMPRESSION is defined.
+ * Each step down halves the deflate hash and pending buffers at some cost in compression ratio.
+ * The compressed format does not change, so Device Cloud is not affected. The default is 8.
+ *
+ * @code
+ * #define CONNECTOR_COMPRESSION_MEMORY_LEVEL    8
+ * @endcode
+ *
+ * @see @ref CONNECTOR_COMPRESSION_STREAMS
+ */
+#define CONNECTOR_COMPRESSION_MEMORY_LEVEL    8
+
+/**
+ * Preset deflate dictionary shared with Device Cloud, as a string literal. When defined together with
+ * @ref CONNECTOR_COMPRESSION, Cloud Connector announces it in the messaging capabilities and, if Device Cloud
+ * announces it back, primes every compressed data service, file system and RCI stream with it. Small
+ * payloads that repeat the same words, like data point CSV or RCI replies, then compress much better.
+ *
+ * The dictionary is identified on the wire by its adler32, so Device Cloud must hold the same bytes.
+ * Put the most frequent strings at the end. Not defined by default.
+ *
+ * @code
+ * #define CONNECTOR_COMPRESSION_DICTIONARY "DATA,TIMESTAMP,QUALITY,DESCRIPTION,LOCATION,DATATYPE,UNITS,FORWARDTO,STREAMID\n"
+ * @endcode
+ *
+ * @note Short messages (UDP and SMS) have no capability exchange and are still compressed without a dictionary.
+ *
+ * @see @ref CONNECTOR_COMPRESSION
+ */
+#define CONNECTOR_COMPRESSION_DICTIONARY "DATA,TIMESTAMP,QUALITY,DESCRIPTION,LOCATION,DATATYPE,UNITS,FORWARDTO,STREAMID\n"
+
 /**
  * If defined, Cloud Connector includes the @ref data_service.
  * To disable the @ref data_service feature, comment this line out in connector_config.h:
@@ -149,6 +215,28 @@
 */
 #define CONNECTOR_DATA_POINTS
 
+/**
+ * Maximum number of @ref connector_initiate_data_point and @ref connector_initiate_data_point_binary
+ * requests per transport accepted by connector_initiate_action() and waiting for Cloud Connector to
+ * start their sessions. Queued requests are started in order, as many per connector_step() as
+ * @ref CONNECTOR_MSG_MAX_TRANSACTION or the short message session limit allow. When the queue is full
+ * connector_initiate_action() returns @ref connector_service_busy. The default is 4.
+ *
+ * @see @ref data_point
+ * @see @ref CONNECTOR_MEMORY_BARRIER
+ */
+#define CONNECTOR_DATA_POINT_QUEUE_SIZE    4
+
+/**
+ * Full memory barrier used by the data point queue, which is filled by the thread calling
+ * connector_initiate_action() and drained by the thread running Cloud Connector. It defaults to
+ * __sync_synchronize() with gcc compatible compilers. Other compilers get no barrier, which is only
+ * safe when both threads run on the same core; define it here for a multi-core target.
+ *
+ * @see @ref CONNECTOR_DATA_POINT_QUEUE_SIZE
+ */
+#define CONNECTOR_MEMORY_BARRIER()    __sync_synchronize()
+
 /**
  * If defined, Cloud Connector includes the @ref file_system.
  * To enable the @ref file_system feature, uncomment this line in connector_config.h:
@@ -200,6 +288,43 @@
  */
 #define CONNECTOR_NO_MALLOC_RCI_MAXIMUM_CONTENT_LENGTH    256
 
+/**
+ * If defined, a query of every element of a group instance is answered by a single
+ * @ref rci_group_query_batch callback that fills the values of all elements at once, instead of
+ * one @ref rci_group_query callback per element. This defines the largest number of elements
+ * a group may have to be queried this way; larger groups, set commands and queries with a
+ * compare_to attribute still use one callback per element.
+ *
+ * The value array is part of the RCI session data, so each element adds the size of a
+ * connector_element_value_t to it.
+ *
+ * @code
+ * #define CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS    32
+ * @endcode
+ *
+ * @see @ref CONNECTOR_RCI_SERVICE
+ */
+#define CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS    32
+
+/**
+ * If defined, Cloud Connector remembers a fingerprint of the last reported value of each state
+ * element and answers a query_state carrying a <b><i>since</i></b> attribute with only the elements
+ * that changed after the query that returned that token. Every such response carries a new
+ * token in place of the attribute; a token of zero or one the device does not know gets the
+ * full state. This defines the number of state elements tracked, counting every element of every
+ * instance of the state groups in descriptor order; elements past that are always reported.
+ *
+ * The values are still retrieved through @ref rci_group_query, only the response shrinks.
+ * Each entry adds 8 bytes to the Cloud Connector data.
+ *
+ * @code
+ * #define CONNECTOR_RCI_STATE_TRACKING_ENTRIES    64
+ * @endcode
+ *
+ * @see @ref CONNECTOR_RCI_SERVICE
+ */
+#define CONNECTOR_RCI_STATE_TRACKING_ENTRIES    64
+
 /**
 * If defined, Cloud Connector includes the @ref cli_support.
 * To disable the @ref cli_support feature, comment this line out in connector_config.h:
@@ -240,20 +365,48 @@
  */
 #define CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH   256
 
+/**
+ * Number of interrupted file transfers the @ref file_system remembers. When a get or put session
+ * ends with a @ref file_system_session_error "session error", for example because the connection
+ * to Device Cloud dropped, Cloud Connector keeps the path and the offset the transfer had reached.
+ * These checkpoints are kept across reconnects.
+ *
+ * A later request for the same path that starts at or before that offset is treated as a resume:
+ *  -# A get is only served if the file still has the size and last modified time it had when the
+ *     interrupted get started. Otherwise it fails with an invalid offset error, so Device Cloud
+ *     never joins two versions of a file.
+ *  -# A put is only accepted if the file still holds all the bytes written before the break.
+ *
+ * Offsets are chosen by Device Cloud, so a request starting at offset 0 always transfers the
+ * whole file and simply replaces the checkpoint. Checking a resume costs one extra
+ * @ref file_system_stat "stat" callback, and every get makes that callback when this is defined.
+ * Not defined by default.
+ *
+ * @code
+ * #define CONNECTOR_FILE_SYSTEM_CHECKPOINTS   4
+ * @endcode
+ *
+ * @see @ref CONNECTOR_FILE_SYSTEM
+ */
+#define CONNECTOR_FILE_SYSTEM_CHECKPOINTS   4
+
 /**
  * When defined, Cloud Connector private library does not use dynamic memory allocations and
  * static memory buffers are used instead. This eliminates the possibility of memory fragmentation.
  *
  * When no dynamic RAM option is used, @ref 
- * CONNECTOR_MSG_MAX_TRANSACTION should be defined and it must
- * be less or equal to 32. The default is 1. 
+ * CONNECTOR_MSG_MAX_TRANSACTION should be defined. The default is 1. 
  *  
  * When no dynamic RAM option is used, @ref 
- * CONNECTOR_NO_MALLOC_MAX_SEND_SESSIONS should be defined and 
- * it must be less or equal to 32. The default is 1. 
+ * CONNECTOR_NO_MALLOC_MAX_SEND_SESSIONS should be defined. The default is 1. 
  *
  * @note If using @ref rci_support, then @ref CONNECTOR_NO_MALLOC_RCI_MAXIMUM_CONTENT_LENGTH must be defined.
  *
+ * connector_init() uses a single built-in static buffer pool. To run several handles in one
+ * process, give each handle its own pool of connector_static_arena_size() bytes with
+ * connector_init_static(). connector_get_static_pool_stats() reports the high water mark
+ * and allocation failures of each pool.
+ *
  * To enable no dynamic RAM feature, uncomment this line in connector_config.h:
  *
  * @code
@@ -273,7 +426,7 @@
  * CONNECTOR_TRANSPORT_TCP "TCP transport" if @ref 
  * CONNECTOR_NO_MALLOC is defined. 
  *  
- * The default is 1. Must be less or equal to 32.
+ * The default is 1.
  *  
  * If @ref CONNECTOR_NO_MALLOC is not defined, the number of
  * simultaneous send data sessions is unlimited.
@@ -902,6 +1055,30 @@
  */
 #define MSG_RECV_WINDOW_SIZE         (4 * MSG_MAX_RECV_PACKET_SIZE)
 
+/**
+ * This macro is for TCP transport optimization only. When defined, this value is the largest incoming window that the
+ * Messaging facility advertises. Each session starts with @ref MSG_RECV_WINDOW_SIZE and resizes its window on every ACK
+ * to about twice what Device Cloud delivers in a measured round trip, so high latency links are not stalled waiting for
+ * ACKs. The limit is shared between the sessions that are receiving at the same time and the window never drops below
+ * @ref MSG_RECV_WINDOW_SIZE. Defining it equal to MSG_RECV_WINDOW_SIZE keeps a fixed window.
+ * If not set the default value of 16 times MSG_MAX_RECV_PACKET_SIZE is used.
+ *
+ * @see @ref MSG_RECV_WINDOW_SIZE
+ */
+#define MSG_RECV_WINDOW_MAX          (16 * MSG_MAX_RECV_PACKET_SIZE)
+
+/**
+ * This macro is for TCP transport optimization only. When defined, this value is the size of the ring that
+ * Cloud Connector reads the TCP stream into. Each @ref connector_request_id_network_receive "receive callback" is
+ * offered all the free space in the ring so several EDP messages can be read at once, and messages are handed to
+ * the facilities directly from the ring without being copied.
+ * If not set the default value of 2 times MSG_MAX_RECV_PACKET_SIZE is used. It must not be smaller than
+ * MSG_MAX_RECV_PACKET_SIZE; a value close to the socket receive buffer size lets a single callback drain it.
+ *
+ * @see @ref MSG_MAX_RECV_PACKET_SIZE
+ */
+#define EDP_RECEIVE_RING_SIZE        (2 * MSG_MAX_RECV_PACKET_SIZE)
+
 /**
 * @}
 */
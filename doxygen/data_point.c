@@ -76,7 +76,7 @@
  * </tr>
  * <tr>
  *   <th>@endhtmlonly @ref connector_service_busy @htmlonly</th>
- *   <td>Previous binary data point is not yet processed</td>
+ *   <td>@endhtmlonly @ref CONNECTOR_DATA_POINT_QUEUE_SIZE @htmlonly data point requests for this transport are not yet processed</td>
  * </tr>
  * </table>
  * @endhtmlonly
@@ -283,7 +283,7 @@
  * </tr>
  * <tr>
  *   <th>@endhtmlonly @ref connector_service_busy @htmlonly</th>
- *   <td>Previous multiple data request is not yet processed</td>
+ *   <td>@endhtmlonly @ref CONNECTOR_DATA_POINT_QUEUE_SIZE @htmlonly data point requests for this transport are not yet processed</td>
  * </tr>
  * </table>
  * @endhtmlonly
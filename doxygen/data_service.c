@@ -77,6 +77,8 @@
  *        <li><b><i>path</i></b> is Device Cloud file path where data will be stored (shouldn't be stack variable) </li>
  *        <li><b><i>content_type</i></b> is "text/plain", "text/xml", "application/json", etc (shouldn't be stack variable) </li>
  *        <li><b><i>option</i></b>, is to inform Device Connector on what to do with the data </li>
+ *        <li><b><i>priority</i></b>, how this send shares the TCP connection with other sessions: connector_data_service_send_priority_normal (0),
+ *                                    connector_data_service_send_priority_interactive or connector_data_service_send_priority_bulk </li>
  *        <li><b><i>response_required</i></b>, set to connector_true if the response is needed </li>
  *        <li><b><i>request_id</i></b>, pointer to where to store the session's Request ID. This value is saved by Cloud Connector after a successful connector_initiate_action()
  *                                      and might be used for @endhtmlonly @ref initiate_session_cancel "canceling the session" @htmlonly. <b>Only valid for SM</b>. Set to NULL if cancel is not going to be used. </li>
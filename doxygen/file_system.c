@@ -446,6 +446,12 @@
  * } 
  *
  * @endcode
+ *
+ * @note When @ref CONNECTOR_COMPRESSION is not defined and the TCP transport implements the
+ * @ref send_file "Send File" network callback, a file get skips this callback for every chunk
+ * but the last one: Cloud Connector writes the message framing and the network callback sends
+ * the chunk straight from the file handle, for example with sendfile(). The file is sized with
+ * @ref file_system_lseek "lseek" before the transfer and must not shrink while it is sent.
  * <br />  
  *
  * @section file_system_write   Write File Data
@@ -90,12 +90,19 @@
  * 
  * @section fs_sample_hash_support File Hash Values Support
  *
- * By default the file system sample does not support file hash values. MD5 support can be enabled using the following define:
+ * By default the file system sample returns CRC32 hash values, computed with zlib's crc32(). MD5 support can be enabled using the following define:
  *
  * -DAPP_ENABLE_MD5=true
  *
  * When MD5 support is enabled the sample uses MD5_Init(), MD5_Update(), and MD5_Final() functions
- * from the openssl library.
+ * from the openssl library, and answers @ref connector_file_system_hash_best with MD5 unless
+ * APP_FILE_HASH_BEST_IS_CRC32 is defined.
+ *
+ * Hashes are computed by file_hash.c on a worker thread: app_process_file_hash() returns
+ * @ref connector_callback_busy until the value is ready. When a directory is listed the worker starts
+ * hashing its regular files right away, ahead of the listing. Values are cached per device, inode, size
+ * and modification time, so unchanged files are not read again. Define APP_FILE_HASH_CACHE_PATH to keep
+ * the cache in a file across restarts.
  * <br /><br />
  * 
  * @section running Running
@@ -349,6 +356,11 @@
  *  <td>platforms/<i>my_platform</i></td>
  * </tr>
  * <tr>
+ *  <th>file_hash.c</th>
+ *  <td>Cached file hash values, computed on a worker thread</td>
+ *  <td>platforms/<i>my_platform</i></td>
+ * </tr>
+ * <tr>
  *  <th>os.c</th>
  *  <td>Operating system calls</td>
  *  <td>platforms/<i>my_platform</i></td>
@@ -330,6 +330,11 @@
  * }
  * @endcode
  *
+ * When @ref CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE is defined, blocks are acknowledged when they are queued and
+ * this callback is called for them afterwards, so it can return @ref connector_callback_busy while a flash write
+ * is in progress without holding up the receive of the next blocks. connector_get_firmware_download_stats() reports
+ * how long the receive, write and verify phases of a download took.
+ *
  * @section fw_complete Firmware Download Complete
  *
  * Callback is called when Device Cloud is done sending all image data. This callback tells Cloud Connector
@@ -9,7 +9,11 @@
  *
  *  -# @ref open
  *  -# @ref send
+ *  -# @ref send_vector
+ *  -# @ref send_file
+ *  -# @ref send_batch
  *  -# @ref receive
+ *  -# @ref receive_batch
  *  -# @ref close
  * <br /><br />
  *
@@ -34,6 +38,12 @@
  *
  * The callback is responsible of setting up any socket options for TCP and UDP transports.
  *
+ * The callback must not block while the Device Cloud name is resolved. The Linux platform sample resolves
+ * names in a background thread (network_dns.c), keeps the answer for its DNS time-to-live and returns
+ * @ref connector_callback_busy until the answer arrives. When the name has both IPv6 and IPv4 addresses,
+ * @ref app_network_tcp_open() starts a connection to each address in turn, 250 milliseconds apart, and keeps
+ * the first one that connects.
+ *
  * This callback is trapped in application.c, in the @b Sample section of @ref AppStructure "Public Application Framework"
  * and implemented in the @b Platform function:
  * <ul>
@@ -181,6 +191,206 @@
  * @endhtmlonly
  * <br /><br />
  *
+ * @section send_vector Send Vector
+ *
+ * Optional callback called to send several buffers to Device Cloud with one call, so EDP
+ * frames that are queued together leave in a single system call (writev() or sendmsg())
+ * instead of one @ref send per frame. This function must not block and may send fewer
+ * bytes than the sum of all fragments; bytes_used is counted across the fragments in order.
+ *
+ * It is only used for @ref connector_class_id_network_tcp. If the callback returns
+ * @ref connector_callback_unrecognized, Cloud Connector stops asking and sends each
+ * fragment with the @ref send callback.
+ *
+ * This callback is implemented in the @b Platform function app_network_tcp_send_vector()
+ * in network_tcp.c and network_tcp_ssl.c.
+ * <br />
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_network_tcp @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_network_send_vector @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>data</th>
+ * <td>Pointer to @endhtmlonly @ref connector_network_send_vector_t "connector_network_send_vector_t" @htmlonly structure
+ *        <ul>
+ *          <li><b><i>handle</i></b> - [In] @endhtmlonly @ref connector_network_handle_t "Network handle" @htmlonly </li>
+ *          <li><b><i>vector</i></b> - [In] Fragments to send, each with a buffer and a length </li>
+ *          <li><b><i>vector_count</i></b> - [In] Number of fragments </li>
+ *          <li><b><i>bytes_used</i></b> - [OUT] Total number of bytes sent </li>
+ *        </ul>
+ * </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_continue @htmlonly</td>
+ * <td>Callback successfully sent data to Device Cloud</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_busy @htmlonly</td>
+ * <td>Callback could not send data due to temporary unavailability of resources. It needs to be called again to send data</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_unrecognized @htmlonly</td>
+ * <td>Gather writes are not supported; Cloud Connector uses the @endhtmlonly @ref send @htmlonly callback instead</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_error @htmlonly</td>
+ * <td>Callback was unable to send data due to irrecoverable communications error.
+ *     Cloud Connector will @endhtmlonly @ref close "close" @htmlonly the network handle</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_abort @htmlonly</td>
+ * <td>Callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br /><br />
+ *
+ * @section send_file Send File
+ *
+ * Optional callback called to send a region of an open file to Device Cloud without copying it
+ * through Cloud Connector, for example with sendfile() or splice(). Cloud Connector queues the
+ * EDP and messaging headers as a normal @ref send and then asks for the file bytes, which start
+ * at the current position of the file handle returned by the @ref file_system_open "file system open"
+ * callback. This function must not block and may send fewer bytes than requested; the file position
+ * must advance by bytes_used.
+ *
+ * It is only used for @ref connector_class_id_network_tcp file system gets when @ref CONNECTOR_COMPRESSION
+ * is not defined. Cloud Connector first calls it with bytes_available set to zero to check that it is
+ * supported; returning @ref connector_callback_unrecognized keeps the buffered @ref file_system_read "read"
+ * path, which is what a TLS transport must do.
+ *
+ * This callback is implemented in the @b Platform function app_network_tcp_send_file()
+ * in network_tcp.c.
+ * <br />
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_network_tcp @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_network_send_file @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>data</th>
+ * <td>Pointer to @endhtmlonly @ref connector_network_send_file_t "connector_network_send_file_t" @htmlonly structure
+ *        <ul>
+ *          <li><b><i>handle</i></b> - [In] @endhtmlonly @ref connector_network_handle_t "Network handle" @htmlonly </li>
+ *          <li><b><i>file_handle</i></b> - [In] @endhtmlonly @ref connector_filesystem_file_handle_t "File handle" @htmlonly to send from </li>
+ *          <li><b><i>bytes_available</i></b> - [In] Number of bytes to send from the current file position, zero to check for support </li>
+ *          <li><b><i>bytes_used</i></b> - [OUT] Number of bytes sent </li>
+ *        </ul>
+ * </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_continue @htmlonly</td>
+ * <td>Callback successfully sent file data to Device Cloud. Sending no bytes for a non-empty request means the file
+ *     ended early and Cloud Connector closes the connection</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_busy @htmlonly</td>
+ * <td>Callback could not send data due to temporary unavailability of resources. It needs to be called again to send data</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_unrecognized @htmlonly</td>
+ * <td>Only valid for the zero byte check; file data is then read with the file system read callback</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_error @htmlonly</td>
+ * <td>Callback was unable to send data due to irrecoverable communications error.
+ *     Cloud Connector will @endhtmlonly @ref close "close" @htmlonly the network handle</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_abort @htmlonly</td>
+ * <td>Callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br /><br />
+ *
+ * @section send_batch Send Batch
+ *
+ * Optional callback called to send several short message datagrams to Device Cloud with one call
+ * (for example sendmmsg()). Each session builds its next segment in place, in front of its payload,
+ * and Cloud Connector queues the segments of all active sessions, up to SM_SEND_BATCH_SIZE (8 by
+ * default), before handing them to this callback. This function must not block and may send fewer
+ * datagrams than requested; datagrams_sent is counted from the first datagram.
+ *
+ * It is only used for @ref connector_class_id_network_udp. If the callback returns
+ * @ref connector_callback_unrecognized, Cloud Connector stops asking and sends each
+ * datagram with the @ref send callback.
+ *
+ * This callback is implemented in the @b Platform function app_network_udp_send_batch()
+ * in network_udp.c.
+ * <br />
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_network_udp @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_network_send_batch @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>data</th>
+ * <td>Pointer to @endhtmlonly @ref connector_network_send_batch_t "connector_network_send_batch_t" @htmlonly structure
+ *        <ul>
+ *          <li><b><i>handle</i></b> - [In] @endhtmlonly @ref connector_network_handle_t "Network handle" @htmlonly </li>
+ *          <li><b><i>datagram</i></b> - [In] List of datagrams, each one a buffer and its length </li>
+ *          <li><b><i>datagram_count</i></b> - [In] Number of datagrams in the list </li>
+ *          <li><b><i>datagrams_sent</i></b> - [OUT] Number of datagrams sent </li>
+ *        </ul>
+ * </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_continue @htmlonly</td>
+ * <td>Callback successfully sent datagrams to Device Cloud</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_busy @htmlonly</td>
+ * <td>Callback could not send data due to temporary unavailability of resources. It needs to be called again to send data</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_unrecognized @htmlonly</td>
+ * <td>Callback is not implemented; datagrams are sent one at a time with the @endhtmlonly @ref send @htmlonly callback</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_error @htmlonly</td>
+ * <td>Callback was unable to send data due to irrecoverable communications error.
+ *     Cloud Connector will @endhtmlonly @ref close "close" @htmlonly the network handle</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_abort @htmlonly</td>
+ * <td>Callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br /><br />
+ *
  * @section receive Receive
  *
  * Callback called to receive a specified number of data bytes from
@@ -251,6 +461,73 @@
  * @endhtmlonly
  * <br /><br />
  *
+ * @section receive_batch Receive Batch
+ *
+ * Optional callback called to receive several short message datagrams from Device Cloud with one call
+ * (for example recvmmsg()). The buffer is split in slots of one transport MTU each, SM_RECV_BATCH_SIZE
+ * (4 by default) of them, and the callback stores one datagram per slot. Cloud Connector processes every
+ * datagram it gets back, reassembling multipart messages, before it asks for more. This function must not block.
+ *
+ * It is only used for @ref connector_class_id_network_udp. If the callback returns
+ * @ref connector_callback_unrecognized, Cloud Connector stops asking and reads each
+ * datagram with the @ref receive callback.
+ *
+ * This callback is implemented in the @b Platform function app_network_udp_receive_batch()
+ * in network_udp.c.
+ * <br />
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_network_udp @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_network_receive_batch @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>data</th>
+ * <td>Pointer to @endhtmlonly @ref connector_network_receive_batch_t "connector_network_receive_batch_t" @htmlonly structure
+ *        <ul>
+ *          <li><b><i>handle</i></b> - [In] @endhtmlonly @ref connector_network_handle_t "Network handle" @htmlonly </li>
+ *          <li><b><i>buffer</i></b> - [In] Pointer to the first slot </li>
+ *          <li><b><i>slot_size</i></b> - [In] Number of bytes available in each slot </li>
+ *          <li><b><i>slot_count</i></b> - [In] Number of slots </li>
+ *          <li><b><i>bytes_used</i></b> - [OUT] Number of bytes received in each filled slot </li>
+ *          <li><b><i>slots_used</i></b> - [OUT] Number of slots filled </li>
+ *        </ul>
+ * </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_continue @htmlonly</td>
+ * <td>Callback successfully received datagrams from Device Cloud</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_busy @htmlonly</td>
+ * <td>Callback has no datagram ready and needs to be called back again</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_unrecognized @htmlonly</td>
+ * <td>Callback is not implemented; datagrams are read one at a time with the @endhtmlonly @ref receive @htmlonly callback</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_error @htmlonly</td>
+ * <td>Callback was unable to receive data due to irrecoverable communications error.
+ *     Cloud Connector will @endhtmlonly @ref close "close" @htmlonly the network handle</td>
+ * </tr>
+ * <tr>
+ * <td>@endhtmlonly @ref connector_callback_abort @htmlonly</td>
+ * <td>Callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br /><br />
+ *
  * @section close Close
  *
  * Application callback request to close a network handle
@@ -29,6 +29,13 @@
  *
  * This callback is called to establish SSL connection between Cloud Connector and Device Cloud.
  * Callback is responsible to setup any socket options and SSL specific initial settings.
+ *
+ * The sample creates one SSL_CTX on the first connect, loads the CA certificate into it once and
+ * keeps it for the life of the process. It only negotiates TLS 1.2 or newer. The session (or TLS 1.3
+ * ticket) handed out by each Device Cloud host is kept, so reconnects and redirects resume it with an
+ * abbreviated handshake instead of a full one. The duration of the last handshake and whether it was
+ * resumed are available through app_ssl_get_handshake(); the @ref connect_on_ssl sample prints them from
+ * its @ref status_tcp "TCP status" callback when communication starts.
  * 
  * This callback is trapped in application.c, in the @b Sample section of @ref AppStructure "Public Application Framework"
  * and implemented in the @b Platform function app_network_tcp_open() in network_tcp_ssl.c.
@@ -98,8 +105,8 @@
  * typedef struct
  * {
  *    int sfd;
- *    SSL_CTX * ctx;
  *    SSL * ssl;
+ *    int session_slot;
  * } app_ssl_t;
  *
  * static connector_callback_status_t app_network_tcp_open(connector_network_open_t * const data)
@@ -109,18 +116,11 @@
  *     // create socket fd, set socket option for keep alive and no delay
  *     // connect to CONNECTOR_SSL_PORT on Device Cloud
  *
- *    SSL_library_init();
- *    OpenSSL_add_all_algorithms();
- *    SSL_load_error_strings();
- *    ssl_ptr->sfd = fd;
- *    ssl_ptr->ctx = SSL_CTX_new(TLSv1_client_method());    
- *    if (ssl_ptr->ctx == NULL)
- *    {
- *        ERR_print_errors_fp(stderr);
- *        goto error;
- *    } 
+ *    // created once: TLS_client_method(), CA certificate, client session cache callback
+ *    SSL_CTX * const ctx = app_ssl_get_context();
  *
- *    ssl_ptr->ssl = SSL_new(ssl_ptr->ctx);
+ *    ssl_ptr->sfd = fd;
+ *    ssl_ptr->ssl = SSL_new(ctx);
  *    if (ssl_ptr->ssl == NULL)
  *    {
  *        ERR_print_errors_fp(stderr);
@@ -128,16 +128,12 @@
  *    }
  *
  *    SSL_set_fd(ssl_ptr->ssl, ssl_ptr->sfd);
+ *    SSL_set_tlsext_host_name(ssl_ptr->ssl, data->device_cloud.url);
+ *
+ *    // resume the session last used with this host
+ *    if (cached_session != NULL)
+ *        SSL_set_session(ssl_ptr->ssl, cached_session);
  *
- *    ret = SSL_CTX_load_verify_locations(ctx, APP_SSL_CA_CERT_PATH, NULL);
- *    if (ret != 1) 
- *    {
- *        APP_DEBUG("Failed to load CA cert [%d]\n", ret);
- *        ERR_print_errors_fp(stderr);
- *        goto error;
- *    }
- *    
- *    SSL_set_options(ssl_ptr->ssl, SSL_OP_ALL);
  *    if (SSL_connect(ssl_ptr->ssl) <= 0)
  *    {
  *        ERR_print_errors_fp(stderr);
@@ -168,8 +164,9 @@
  * @section ssl_send Send
  *
  * Callback is called to send data to Device Cloud over SSL connection. This function must not block.
- * If it encounters EAGAIN or EWOULDBLOCK error it must return @ref connector_callback_busy and Cloud Connector will
- * continue calling this function.
+ * If SSL_write() fails with SSL_ERROR_WANT_WRITE or SSL_ERROR_WANT_READ it must return @ref connector_callback_busy
+ * and Cloud Connector will continue calling this function. The sample sets SSL_MODE_ENABLE_PARTIAL_WRITE and
+ * SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER, because the retry may pass a longer buffer that starts with the same data.
  *
  * This callback is trapped in application.c, in the @b Sample section of @ref AppStructure "Public Application Framework"
  * and implemented in the @b Platform function @ref app_network_tcp_send() in network_tcp.c.
@@ -227,16 +224,30 @@
  * {
  *     connector_callback_status_t status = connector_callback_continue;
  *     app_ssl_t * const ssl_ptr = data->handle;
- *     int const bytes_sent = SSL_write(ssl_ptr->ssl, data->buffer, data->bytes_available);
+ *     int bytes_sent;
  *
- *     if (bytes_sent <= 0)
+ *     ERR_clear_error();
+ *     bytes_sent = SSL_write(ssl_ptr->ssl, data->buffer, (int)data->bytes_available);
+ *     if (bytes_sent > 0)
  *     {
- *         // call SSL_get_error() to find out exact cause
- *         APP_DEBUG("SSL_write failed %d\n", bytes_sent);
- *         status = connector_callback_error;
+ *         data->bytes_used = (size_t) bytes_sent;
+ *     }
+ *     else
+ *     {
+ *         data->bytes_used = 0;
+ *         switch (SSL_get_error(ssl_ptr->ssl, bytes_sent))
+ *         {
+ *         case SSL_ERROR_WANT_WRITE:
+ *             // wait for the socket to become writable before calling again
+ *         case SSL_ERROR_WANT_READ:
+ *             status = connector_callback_busy;
+ *             break;
+ *         default:
+ *             APP_DEBUG("SSL_write failed %d\n", bytes_sent);
+ *             status = connector_callback_error;
+ *             break;
+ *         }
  *     }
- * 
- *     data->bytes_used = (size_t) bytes_sent;
  * 
  *     return status;
  * }
@@ -245,14 +256,14 @@
  * @section ssl_receive Receive
  *
  * Callback is called to receive a specified number of bytes of data from the Device
- * Cloud.  This function must not block.
+ * Cloud.  This function must not block: the socket is non-blocking after the handshake and
+ * SSL_read() is called directly, without select(). SSL_ERROR_WANT_READ and SSL_ERROR_WANT_WRITE
+ * both return @ref connector_callback_busy. The linux run platform also asks app_os_yield() to
+ * wait for the socket to become writable after SSL_ERROR_WANT_WRITE.
  *
  * This callback is trapped in application.c, in the @b Sample section of @ref AppStructure "Public Application Framework"
  * and implemented in the @b Platform function @ref app_network_tcp_receive() in network_tcp_ssl.c.
  *
- * @note In the multithreaded model (connector_run()) this is the point where the ICC
- * will relinquish control of the CPU.
- *
  * @htmlonly
  * <table class="apitable">
  * <tr> <th colspan="2" class="title">Arguments</th> </tr> 
@@ -306,46 +317,32 @@
  * {
  *     connector_callback_status_t status = connector_callback_continue;
  *     app_ssl_t * const ssl_ptr = data->handle;
- *     int bytes_read = 0;
+ *     int bytes_read;
  *
- *     if (SSL_pending(ssl_ptr->ssl) == 0)
+ *     ERR_clear_error();
+ *     bytes_read = SSL_read(ssl_ptr->ssl, data->buffer, (int)data->bytes_available);
+ *     if (bytes_read > 0)
  *     {
- *         int ready;
- *         struct timeval timeout;
- *         fd_set read_set;
- *
- *         timeout.tv_sec = read_data->timeout;
- *         timeout.tv_usec = 0;
- *
- *         FD_ZERO(&read_set);
- *         FD_SET(ssl_ptr->sfd, &read_set);
- *
- *         // Blocking point for Cloud Connector
- *         ready = select(ssl_ptr->sfd + 1, &read_set, NULL, NULL, &timeout);
- *         if (ready == 0)
+ *         data->bytes_used = (size_t)bytes_read;
+ *     }
+ *     else
+ *     {
+ *         data->bytes_used = 0;
+ *         switch (SSL_get_error(ssl_ptr->ssl, bytes_read))
  *         {
+ *         case SSL_ERROR_WANT_WRITE:
+ *             // wait for the socket to become writable before calling again
+ *         case SSL_ERROR_WANT_READ:
  *             status = connector_callback_busy;
- *             goto done;
- *         }
- *
- *         if (ready < 0)
- *         {
- *            APP_DEBUG("app_network_receive: select failed\n");
- *            goto done;
+ *             break;
+ *         default:
+ *             // EOF on input: the connection was closed.
+ *             APP_DEBUG("SSL_read failed %d\n", bytes_read);
+ *             status = connector_callback_error;
+ *             break;
  *         }
  *     }
  *
- *     bytes_read = SSL_read(ssl_ptr->ssl, data->buffer, data->bytes_available);
- *     if (bytes_read <= 0)
- *     {
- *         // EOF on input: the connection was closed.
- *         APP_DEBUG("SSL_read failed %d\n", bytes_read);
- *         status = connector_callback_error;
- *     }
- * 
- *     data->bytes_used = (size_t)bytes_read;
- *
- * done:
  *     return status;
  * }
  *
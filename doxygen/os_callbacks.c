@@ -10,8 +10,10 @@
  *  -# @ref malloc
  *  -# @ref free
  *  -# @ref uptime
+ *  -# @ref uptime_in_milliseconds
  *  -# @ref yield
  *  -# @ref reboot
+ *  -# @ref wakeup
  * <br /><br />
  *
  * @section malloc malloc
@@ -290,6 +292,70 @@
  * @endcode
  * <br />
  *
+ * @section uptime_in_milliseconds System Uptime in Milliseconds
+ * This callback is called to return system up time in milliseconds from a monotonic
+ * clock. Cloud Connector runs its keepalive, short message session timeout and
+ * reconnect timers from this clock, so it must not jump when the wall clock is adjusted.
+ * The value may wrap around; only differences between two values are used.
+ *
+ * If the callback returns @ref connector_callback_unrecognized, Cloud Connector stops
+ * calling it and uses the @ref uptime callback in seconds instead.
+ *
+ * @see app_os_get_system_time_in_milliseconds()
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_operating_system @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_os_system_up_time_in_milliseconds @htmlonly</td>
+ * </tr>
+ *     <th>data</th>
+ *     <td>Pointer to @endhtmlonly @ref connector_os_system_up_time_in_milliseconds_t "connector_os_system_up_time_in_milliseconds_t" @htmlonly structure
+ *        <ul>
+ *          <li><b><i>sys_uptime_in_milliseconds</i></b> - [OUT] Returned system up time in milliseconds </li>
+ *        </ul>
+ *      </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_continue @htmlonly</th>
+ * <td>Callback successfully returned the system time</td>
+ * </tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_unrecognized @htmlonly</th>
+ * <td>Callback is not implemented, system up time in seconds is used</td>
+ * </tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_abort @htmlonly</th>
+ * <td>Error occurred and callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br />
+ *
+ * Example:
+ *
+ * @code
+ *
+ * connector_callback_status_t os_get_system_time_in_milliseconds(connector_os_system_up_time_in_milliseconds_t * const data)
+ * {
+ *      struct timespec present_time;
+ *
+ *      clock_gettime(CLOCK_MONOTONIC, &present_time);
+ *      data->sys_uptime_in_milliseconds = (unsigned long) present_time.tv_sec * 1000 + present_time.tv_nsec / 1000000;
+ *
+ *     return connector_callback_continue;
+ * }
+ * @endcode
+ * <br />
+ *
  * @section yield Yield
  * This callback is called to relinquish control in the @ref threading "multi-threaded" connector_run() model.
  *
@@ -323,6 +389,10 @@
  *           <li> @endhtmlonly @ref connector_pending @htmlonly </li>
  *           <li> @endhtmlonly @ref connector_active @htmlonly </li>
  *      </ul>
+ *   When status is @endhtmlonly @ref connector_idle @htmlonly, timeout_in_milliseconds is the time until
+ *   the next Cloud Connector timer (keepalive, SM receive timeout or reconnect) is due, or
+ *   @endhtmlonly @ref CONNECTOR_YIELD_WAIT_FOREVER @htmlonly when no timer is pending. The callback may
+ *   block up to this time waiting for the network sockets or a @endhtmlonly @ref wakeup @htmlonly callback.
  *  </td>
  * </tr>
  * <tr> <th colspan="2" class="title">Return Values</th> </tr>
@@ -348,8 +418,10 @@
  *
  *      if (data->status == connector_idle)
  *      {
- *          unsigned int const timeout_in_microseconds =  1000000;
- *          usleep(timeout_in_microseconds);
+ *          int const timeout = (data->timeout_in_milliseconds == CONNECTOR_YIELD_WAIT_FOREVER) ? -1 : (int)data->timeout_in_milliseconds;
+ *          struct epoll_event events[8];
+ *
+ *          epoll_wait(epoll_fd, events, 8, timeout);
  *      }
  *
  *     return connector_callback_continue;
@@ -400,6 +472,59 @@
  * }
  *
  * @endcode
+ * <br />
+ *
+ * @section wakeup Wakeup
+ *
+ * Callback is called from connector_initiate_action() when a request is accepted, in the
+ * application thread. It wakes up the connector_run() thread blocked in the @ref yield callback
+ * so the new request is processed without waiting for the yield timeout.
+ *
+ * This callback is optional; @ref connector_callback_unrecognized is accepted when the
+ * @ref yield callback does not block.
+ *
+ * @see app_os_wakeup()
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_operating_system @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_os_wakeup @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>data</th>
+ * <td> N/A </td>
+ * </tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_continue @htmlonly</th>
+ * <td>Callback signaled the connector_run() thread</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ * <br />
+ *
+ * Example:
+ *
+ * @code
+ *
+ * connector_callback_status_t os_wakeup(void)
+ * {
+ *     uint64_t const value = 1;
+ *
+ *     write(wakeup_fd, &value, sizeof value);
+ *
+ *     return connector_callback_continue;
+ * }
+ *
+ * @endcode
  *
  * @htmlinclude terminate.html
  */
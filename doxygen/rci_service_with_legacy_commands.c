@@ -19,6 +19,7 @@
  *  -# @ref rci_group_start
  *  -# @ref rci_group_set
  *  -# @ref rci_group_query
+ *  -# @ref rci_group_query_batch
  *  -# @ref rci_group_end
  *  -# @ref rci_action_end
  *  -# @ref rci_session_end
@@ -51,6 +52,7 @@
  * @note Cloud Connector calls step 3 to 5 repeatedly for each configuration group.
  * @note The request from the Cloud may include several actions for a single session, then Cloud Connector calls step 2 to 6 repeatedly for each action.
  * @note See @ref rci_support under Configuration to enable or disable remote configuration.
+ * @note See @ref CONNECTOR_RCI_STATE_TRACKING_ENTRIES to have state queries return only the elements that changed.
  * @note See RCI tool for generating remote configuration source and header files.
  * @note If remote configuration file specifies IPv4 type (see @ref rci_tool), @ref connector_snprintf must be implemented. See @ref snprintf_routine.
  *
@@ -756,6 +758,86 @@
  * }
  * @endcode
  *
+ * @section rci_group_query_batch   Query all elements of a configuration group
+ *
+ * When @ref CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS is defined, this callback is called instead of
+ * @ref rci_group_query when Device Cloud queries every element of a configuration group instance, the
+ * group has at most @ref CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS elements and no compare_to attribute
+ * is given. The callback returns the values of all elements of the group instance in one call.
+ *
+ * If the callback sets <b><i>error_id</i></b>, Cloud Connector ignores the returned values and
+ * calls @ref rci_group_query for each element of the group instance instead.
+ *
+ * @htmlonly
+ * <table class="apitable">
+ * <tr> <th colspan="2" class="title">Arguments</th> </tr>
+ * <tr><th class="subtitle">Name</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>class_id</th>
+ * <td>@endhtmlonly @ref connector_class_id_remote_config @htmlonly</td>
+ * </tr>
+ * <tr>
+ * <th>request_id</th>
+ * <td>@endhtmlonly @ref connector_request_id_remote_config_group_query @htmlonly</td>
+ * </tr>
+ * <tr>
+ *   <th>data</th>
+ *   <td> Pointer to @endhtmlonly connector_remote_config_t @htmlonly structure:
+ *     <dl><dt><i>user_context</i></dt>
+ *         <dd> - Pointer to callback's context returned from previous callback.
+ *                Callback may write its own context which will be passed back to
+ *                 subsequent callback.</dd>
+ *         <dt><i>action</i></dt>
+ *         <dd> - the @endhtmlonly @ref connector_remote_action_query @htmlonly </dd>
+ *         <dt><i>attribute</i></dt>
+ *         <dd> - Same as @endhtmlonly @ref rci_group_query @htmlonly. compare_to is always
+ *                @endhtmlonly @ref rci_query_setting_attribute_compare_to_none @htmlonly.</dd>
+ *         <dt><i>group</i></dt>
+ *         <dd> - type, id and index of the configuration group instance to be queried.</dd>
+ *         <dt><i>element</i></dt><dd>Not applicable</dd>
+ *         <dt><i>error_id</i></dt>
+ *         <dd> - Callback writes error enumeration value generated by @endhtmlonly @ref rci_tool @htmlonly if
+ *                     error is encountered.</dd>
+ *         <dt><i>response</i></dt>
+ *         <dd><dl>
+ *             <dt><i>compare_matches</i></dt><dd>Not applicable</dd>
+ *             <dt><i>error_hint</i></dt><dd>Not applicable</dd>
+ *             <dt><i>element_value</i></dt>
+ *             <dd> - Pointer to an array of @endhtmlonly @ref connector_element_value_t @htmlonly
+ *                    indexed by the element enumeration number. Callback writes the value of every
+ *                    element of the group, as described in @endhtmlonly @ref rci_group_query @htmlonly.
+ *                    Returned strings cannot be altered until the @endhtmlonly @ref rci_group_end @htmlonly callback.</dd>
+ *         </dl></dd>
+ *     </dl>
+ * </td></tr>
+ * <tr> <th colspan="2" class="title">Return Values</th> </tr>
+ * <tr><th class="subtitle">Values</th> <th class="subtitle">Description</th></tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_continue @htmlonly</th>
+ * <td>Callback successfully queried the configuration group or error has occurred</td>
+ * </tr>
+ * <tr>
+ * <th>@endhtmlonly @ref connector_callback_abort @htmlonly</th>
+ * <td>Callback aborted Cloud Connector</td>
+ * </tr>
+ * </table>
+ * @endhtmlonly
+ *
+ * Example:
+ *
+ * @code
+ * static connector_callback_status_t app_process_group_query(connector_remote_config_t * const data)
+ * {
+ *     remote_config_session_t * session_ptr = data->user_context;
+ *     keepalive_data_t * const keepalive_ptr = session_ptr->group_context;
+ *
+ *     data->response.element_value[connector_setting_keepalive_rx].integer_unsigned_value = keepalive_ptr->rx_keepalive_current;
+ *     data->response.element_value[connector_setting_keepalive_tx].integer_unsigned_value = keepalive_ptr->tx_keepalive_current;
+ *
+ *     return connector_callback_continue;
+ * }
+ * @endcode
+ *
  * @section rci_group_end   End of a configuration group
  *
  * Callback is called indicating Cloud Connector is done processing a configuration group.
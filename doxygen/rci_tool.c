@@ -143,6 +143,10 @@
  * when including "connector_api.h" so there is no need to include any other file.
  * Finally, note that this structure saves the Firmware Version, Device Type and Vendor ID used when calling the tool and these values will be checked if
  * @ref CONNECTOR_DEBUG is defined to avoid a missmatch between the Descriptor uploaded to Device Cloud and the one used by Cloud Connector.
+ *
+ * The structure also holds a hash of the descriptor contents, computed by the tool when it generates the descriptors. Cloud Connector
+ * returns this hash in response to an RCI query_descriptor request, so Device Cloud can tell whether it already has the descriptors a device
+ * uses without fetching them again. Firmware versions that share the same descriptors share the same hash.
  * 
  * @section rci_tool_file   Input Configuration File
  *
@@ -72,7 +72,8 @@ CFLAGS += -iquote$(PLATFORM_DIR)""",
     # Include all Application, Platform, and Private source.  
     #If Platform not needed, not included.
     'SRCS'                    : "SRCS = $(APP_SRCS) $(PLATFORM_SRCS) $(PRIVATE_SRCS)",
-    # LIBS to include, -pthread will be added if 'run' type.  
+    # LIBS to include, -lresolv and -lpthread will be added if the sample
+    # uses the linux network callbacks (network_dns.c resolves in a thread).
     # connect_on_ssl adds '-lssl', file_system adds APP_ENABLE_MD5 if.
     'LIBS'                    : "LIBS = -lc -lz",
     # Where to find iDigi private code.
@@ -144,9 +145,9 @@ PLATFORM = template"""
     subs['APP_SRCS'] = 'APP_SRCS = ' + ' '.join([ re.sub(r'\.c$', '.c', f) \
         for f in app_src ])
 
-    # Add -lpthread as a linked library if this is a run sample.
-    if (dvt_test or mode == 'run') and sample not in LINK_SAMPLES:
-        subs['LIBS'] += ' -lpthread' 
+    # Add -lresolv and -lpthread for the threaded DNS resolver in network_dns.c.
+    if sample not in LINK_SAMPLES:
+        subs['LIBS'] += ' -lresolv -lpthread'
 
     if sample == 'connect_on_ssl' and 'network_ssl.c' not in app_src:
         # Add network_ssl.c to PLATFORM_SRCS and -lssl to LIBS.
@@ -177,11 +178,13 @@ PLATFORM = template"""
         # Add file_system.c to PLATFORM_SRCS.  -lcrypto if APP_ENABLE_MD5
         # passed.
         subs['PLATFORM_SRCS'] += " $(PLATFORM_DIR)/file_system.c"
+        subs['PLATFORM_SRCS'] += " $(PLATFORM_DIR)/file_hash.c"
 
     if sample == 'fs_os_abort' and 'file_system.c' not in app_src:
         # Add file_system.c to PLATFORM_SRCS.  -lcrypto if APP_ENABLE_MD5
         # passed.
         subs['PLATFORM_SRCS'] += " $(PLATFORM_DIR)/file_system.c"
+        subs['PLATFORM_SRCS'] += " $(PLATFORM_DIR)/file_hash.c"
 
     if sample == 'file_system' or sample == 'file_system_dir_cov':
         if dvt_test:
@@ -46,6 +46,12 @@
 #endif
 #endif
 
+#if (defined CONNECTOR_DATA_POINT_QUEUE_SIZE)
+#if (CONNECTOR_DATA_POINT_QUEUE_SIZE < 1)
+    #error "Invalid CONNECTOR_DATA_POINT_QUEUE_SIZE value in connector_config.h"
+#endif
+#endif
+
 #if (defined CONNECTOR_MSG_MAX_TRANSACTION)
 #if (CONNECTOR_MSG_MAX_TRANSACTION < 0 || CONNECTOR_MSG_MAX_TRANSACTION > CONNECTOR_MAX_TRANSACTIONS_LIMIT)
     #error "Invalid CONNECTOR_MSG_MAX_TRANSACTION value in connector_config.h"
@@ -60,6 +66,18 @@
 #endif
 #endif
 
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+#if CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS < 1
+    #error "Invalid CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS, it must be at least 1"
+#endif
+#endif
+
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+#if CONNECTOR_RCI_STATE_TRACKING_ENTRIES < 1
+    #error "Invalid CONNECTOR_RCI_STATE_TRACKING_ENTRIES, it must be at least 1"
+#endif
+#endif
+
 #endif
 
 #if (defined CONNECTOR_TRANSPORT_UDP)
@@ -87,3 +105,7 @@
 #if (defined CONNECTOR_FILE_SYSTEM) && (CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH > MSG_MAX_SEND_PACKET_SIZE - 46)
 #error "CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH exceeds the size defined for messaging facility"
 #endif
+
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS) && (CONNECTOR_FILE_SYSTEM_CHECKPOINTS < 1)
+#error "CONNECTOR_FILE_SYSTEM_CHECKPOINTS must be at least 1"
+#endif
@@ -51,6 +51,10 @@ STATIC connector_status_t connector_stop_callback(connector_data_t * const conne
 STATIC connector_status_t get_config_connect_status(connector_data_t * const connector_ptr, connector_request_id_config_t const request_id, connector_config_connect_type_t * const config_ptr);
 #endif
 
+#if (defined CONNECTOR_COMPRESSION)
+#include "connector_zlib.h"
+#endif
+
 #if (defined CONNECTOR_DATA_POINTS)
 #include "connector_data_point.h"
 #endif
@@ -241,9 +245,9 @@ STATIC void abort_connector(connector_data_t * const connector_ptr)
     }
 }
 
-connector_handle_t connector_init(connector_callback_t const callback, void * const context)
+STATIC connector_handle_t connector_init_data(void * const handle, connector_callback_t const callback, void * const context)
 {
-    connector_data_t * connector_handle = NULL;
+    connector_data_t * connector_handle = handle;
     connector_status_t status;
 
 #if (defined CONNECTOR_SW_DESCRIPTION)
@@ -252,19 +256,7 @@ connector_handle_t connector_init(connector_callback_t const callback, void * co
     connector_debug_line("Cloud Connector v%s", CONNECTOR_SW_VERSION);
 #endif
 
-    {
-        void * handle;
-
-#if (defined CONNECTOR_NO_MALLOC)
-        status = malloc_data_buffer(NULL, sizeof *connector_handle, named_buffer_id(connector_data), &handle);
-#else
-        status = malloc_cb(callback, sizeof *connector_handle, &handle, context);
-#endif
-
-        COND_ELSE_GOTO(status == connector_working, done);
-        memset(handle, 0x00, sizeof *connector_handle); /* Init structure, all pointers to NULL */
-        connector_handle = handle;
-    }
+    memset(handle, 0x00, sizeof *connector_handle); /* Init structure, all pointers to NULL */
 
     connector_handle->callback = callback;
     connector_handle->context = context;
@@ -385,9 +377,6 @@ connector_handle_t connector_init(connector_callback_t const callback, void * co
 #if (defined CONNECTOR_MULTIPLE_TRANSPORTS)
     connector_handle->first_running_network = (connector_network_type_t) 0;
 #endif
-#if (defined CONNECTOR_DATA_POINTS)
-    connector_handle->process_csv = connector_true;
-#endif
 
     goto done;
 
@@ -399,6 +388,104 @@ done:
     return connector_handle;
 }
 
+connector_handle_t connector_init(connector_callback_t const callback, void * const context)
+{
+    connector_handle_t connector_handle = NULL;
+    void * handle;
+    connector_status_t status;
+
+#if (defined CONNECTOR_NO_MALLOC)
+    status = malloc_data_buffer(NULL, sizeof(connector_data_t), named_buffer_id(connector_data), &handle);
+#else
+    status = malloc_cb(callback, sizeof(connector_data_t), &handle, context);
+#endif
+
+    COND_ELSE_GOTO(status == connector_working, done);
+    connector_handle = connector_init_data(handle, callback, context);
+
+done:
+    return connector_handle;
+}
+
+#if (defined CONNECTOR_NO_MALLOC)
+size_t connector_static_arena_size(void)
+{
+    return sizeof(connector_static_mem_t);
+}
+
+connector_handle_t connector_init_static(connector_callback_t const callback, void * const context, void * const arena, size_t const arena_size)
+{
+    connector_handle_t connector_handle = NULL;
+    void * handle;
+    connector_status_t status;
+
+    ASSERT_GOTO(arena != NULL, done);
+    if (arena_size < sizeof(connector_static_mem_t))
+    {
+        connector_debug_line("connector_init_static: arena size %lu is less than %lu", (unsigned long)arena_size, (unsigned long)sizeof(connector_static_mem_t));
+        goto done;
+    }
+
+    /* Clear all maps; the handle is allocated from the start of its own arena */
+    memset(arena, 0x00, sizeof(connector_static_mem_t));
+    status = malloc_data_buffer((connector_data_t *)arena, sizeof(connector_data_t), named_buffer_id(connector_data), &handle);
+    COND_ELSE_GOTO(status == connector_working, done);
+    ASSERT(handle == arena);
+
+    connector_handle = connector_init_data(handle, callback, context);
+
+done:
+    return connector_handle;
+}
+
+connector_status_t connector_get_static_pool_stats(connector_handle_t const handle, connector_static_pool_t const pool, connector_static_pool_stats_t * const stats)
+{
+    connector_status_t result = connector_init_error;
+    connector_data_t * const connector_ptr = handle;
+
+    ASSERT_GOTO(handle != NULL, done);
+    ASSERT_GOTO(stats != NULL, done);
+    ASSERT_GOTO(pool < connector_static_pool_count, done);
+
+    {
+        connector_static_mem_t const * const static_mem = get_static_mem(connector_ptr);
+
+        *stats = static_mem->pool_stats[pool];
+        stats->size = static_pool_size(pool);
+    }
+    result = connector_success;
+
+done:
+    return result;
+}
+#endif
+
+#if (defined CONNECTOR_FIRMWARE_SERVICE)
+connector_status_t connector_get_firmware_download_stats(connector_handle_t const handle, connector_firmware_download_stats_t * const stats)
+{
+    connector_status_t result = connector_init_error;
+    connector_data_t * const connector_ptr = handle;
+
+    ASSERT_GOTO(handle != NULL, done);
+    ASSERT_GOTO(stats != NULL, done);
+
+    {
+        connector_firmware_data_t const * const fw_ptr = get_facility_data(connector_ptr, E_MSG_FAC_FW_NUM);
+
+        if (fw_ptr == NULL)
+        {
+            result = connector_unavailable;
+            goto done;
+        }
+        *stats = fw_ptr->timing.stats;
+    }
+    result = connector_success;
+
+done:
+    return result;
+}
+#endif
+
 
 connector_status_t connector_step(connector_handle_t const handle)
 {
@@ -434,6 +521,9 @@ connector_status_t connector_step(connector_handle_t const handle)
                 connector_debug_line("connector_step: free Cloud Connector");
 #if (defined CONNECTOR_RCI_SERVICE && !defined CONNECTOR_NO_MALLOC)
                 free_rci_internal_data(connector_ptr);
+#endif
+#if (defined CONNECTOR_COMPRESSION)
+                zlib_pool_free(connector_ptr);
 #endif
                 free_data_buffer(connector_ptr, named_buffer_id(connector_data), connector_ptr);
                 goto done;
@@ -512,6 +602,31 @@ done:
     return result;
 }
 
+STATIC unsigned long connector_next_timeout(connector_data_t * const connector_ptr)
+{
+    unsigned long timeout = CONNECTOR_YIELD_WAIT_FOREVER;
+    unsigned long uptime;
+
+    if (connector_ptr->stop.state != connector_state_running || get_system_time_in_milliseconds(connector_ptr, &uptime) != connector_working)
+    {
+        timeout = 0;
+        goto done;
+    }
+
+#if (defined CONNECTOR_TRANSPORT_TCP)
+    edp_next_timeout(connector_ptr, uptime, &timeout);
+#endif
+#if (defined CONNECTOR_TRANSPORT_UDP)
+    sm_next_timeout(&connector_ptr->sm_udp, uptime, &timeout);
+#endif
+#if (defined CONNECTOR_TRANSPORT_SMS)
+    sm_next_timeout(&connector_ptr->sm_sms, uptime, &timeout);
+#endif
+
+done:
+    return timeout;
+}
+
 connector_status_t connector_run(connector_handle_t const handle)
 {
     connector_status_t rc;
@@ -521,7 +636,9 @@ connector_status_t connector_run(connector_handle_t const handle)
 
         if (rc == connector_idle || rc == connector_working || rc == connector_pending || rc == connector_active || rc == connector_success)
         {
-            if (yield_process(handle, rc) != connector_working)
+            unsigned long const timeout_in_milliseconds = (rc == connector_idle) ? connector_next_timeout(handle) : 0;
+
+            if (yield_process(handle, rc, timeout_in_milliseconds) != connector_working)
             {
                 abort_connector(handle);
                 rc = connector_success;
@@ -631,6 +748,9 @@ connector_status_t connector_initiate_action(connector_handle_t const handle, co
         }
     }
 done:
+    if (result == connector_success)
+        wakeup_process(connector_ptr);
+
     return result;
 }
 
@@ -581,9 +581,7 @@ STATIC connector_status_t edp_redirect_process(connector_data_t * const connecto
                 edp_set_edp_state(connector_ptr, edp_communication_send_version);
 
                 connector_ptr->edp_data.send_packet.packet_buffer.in_use = connector_false;
-                connector_ptr->edp_data.receive_packet.packet_buffer.in_use = connector_false;
-                connector_ptr->edp_data.receive_packet.packet_buffer.next = NULL;
-                connector_ptr->edp_data.receive_packet.free_packet_buffer = &connector_ptr->edp_data.receive_packet.packet_buffer;
+                tcp_init_receive_packet(connector_ptr);
             }
             else if (result != connector_pending && result != connector_abort)
             {
@@ -62,21 +62,49 @@ static size_t const internal_dp4d_path_strlen = sizeof internal_dp4d_path - 1;
 static char const dp4d_path_prefix[] = "DataPoint/";
 static size_t const dp4d_path_prefix_strlen = sizeof dp4d_path_prefix - 1;
 
-static connector_request_data_point_t const * data_point_pending = NULL;
-static connector_request_data_point_binary_t const * data_point_binary_pending = NULL;
+/* head and tail run over twice the queue size so a full queue differs from an empty one */
+#define DP_QUEUE_RANGE          (2 * CONNECTOR_DATA_POINT_QUEUE_SIZE)
+#define dp_queue_count(queue)   (((queue)->tail + DP_QUEUE_RANGE - (queue)->head) % DP_QUEUE_RANGE)
+#define dp_queue_next(value)    (((value) + 1) % DP_QUEUE_RANGE)
+#define dp_queue_index(value)   ((value) % CONNECTOR_DATA_POINT_QUEUE_SIZE)
+
+/* Only connector_initiate_action() adds entries, so a queue with room stays that way until it adds one. */
+STATIC connector_bool_t dp_queue_has_room(connector_data_t * const connector_ptr, connector_transport_t const transport)
+{
+    connector_dp_queue_t * const queue = &connector_ptr->dp_queue[transport];
+
+    return connector_bool(dp_queue_count(queue) < CONNECTOR_DATA_POINT_QUEUE_SIZE);
+}
+
+STATIC connector_status_t dp_queue_add(connector_data_t * const connector_ptr, connector_transport_t const transport, void const * const request, connector_dp_request_type_t const type)
+{
+    connector_status_t result = connector_service_busy;
+    connector_dp_queue_t * const queue = &connector_ptr->dp_queue[transport];
+
+    if (dp_queue_has_room(connector_ptr, transport))
+    {
+        unsigned int const tail = queue->tail;
+        unsigned int const index = dp_queue_index(tail);
+
+        /* the head read above must not let the entry be written before connector_step() released it */
+        CONNECTOR_MEMORY_BARRIER();
+        queue->entry[index].request = request;
+        queue->entry[index].type = type;
+        /* publish the entry to connector_step() */
+        CONNECTOR_MEMORY_BARRIER();
+        queue->tail = dp_queue_next(tail);
+        result = connector_success;
+    }
+
+    return result;
+}
 
-STATIC connector_status_t dp_initiate_data_point(connector_request_data_point_t const * const dp_ptr)
+STATIC connector_status_t dp_initiate_data_point(connector_data_t * const connector_ptr, connector_request_data_point_t const * const dp_ptr)
 {
     connector_status_t result = connector_invalid_data;
 
     ASSERT_GOTO(dp_ptr != NULL, error);
 
-    if (data_point_pending != NULL)
-    {
-        result = connector_service_busy;
-        goto error;
-    }
-
     if (dp_ptr->stream == NULL)
     {
         connector_debug_line("dp_initiate_data_point: NULL data stream");
@@ -88,25 +116,18 @@ STATIC connector_status_t dp_initiate_data_point(connector_request_data_point_t
         goto error;
     }
 
-    data_point_pending = dp_ptr;
-    result = connector_success;
+    result = dp_queue_add(connector_ptr, dp_ptr->transport, dp_ptr, dp_request_csv);
 
 error:
     return result;
 }
 
-STATIC connector_status_t dp_initiate_data_point_binary(connector_request_data_point_binary_t const * const bp_ptr)
+STATIC connector_status_t dp_initiate_data_point_binary(connector_data_t * const connector_ptr, connector_request_data_point_binary_t const * const bp_ptr)
 {
     connector_status_t result = connector_invalid_data;
 
     ASSERT_GOTO(bp_ptr != NULL, error);
 
-    if (data_point_binary_pending != NULL)
-    {
-        result = connector_service_busy;
-        goto error;
-    }
-
     if (bp_ptr->path == NULL)
     {
         connector_debug_line("dp_initiate_data_point_binary: NULL data point path");
@@ -119,8 +140,7 @@ STATIC connector_status_t dp_initiate_data_point_binary(connector_request_data_p
         goto error;
     }
 
-    data_point_binary_pending = bp_ptr;
-    result = connector_success;
+    result = dp_queue_add(connector_ptr, bp_ptr->transport, bp_ptr, dp_request_binary);
 
 error:
     return result;
@@ -199,40 +219,42 @@ STATIC connector_status_t dp_cancel_session(connector_data_t * const connector_p
 {
     connector_status_t status = connector_working;
     connector_bool_t cancel_all = connector_bool(request_id == NULL);
+    size_t transport;
 
-    if (data_point_binary_pending != NULL)
+    for (transport = 0; transport < ARRAY_SIZE(connector_ptr->dp_queue); transport++)
     {
-        connector_bool_t const has_request_id = connector_bool(data_point_binary_pending->request_id != NULL);
-        connector_bool_t const matching_request = connector_bool(has_request_id && *data_point_binary_pending->request_id == *request_id);
+        connector_dp_queue_t * const queue = &connector_ptr->dp_queue[transport];
+        unsigned int position;
 
-        if (cancel_all || matching_request)
+        for (position = queue->head; position != queue->tail; position = dp_queue_next(position))
         {
-            if (session == NULL)
-            {
-                status = dp_inform_status(connector_ptr, connector_request_id_data_point_binary_status, data_point_binary_pending->transport, data_point_binary_pending->user_context, connector_session_error_cancel);
-                if (status != connector_working)
-                  goto done;
-            }
-            data_point_binary_pending = NULL;
-        }
-    }
+            unsigned int const index = dp_queue_index(position);
+            void const * const request = queue->entry[index].request;
+            connector_bool_t const is_binary = connector_bool(queue->entry[index].type == dp_request_binary);
+            connector_request_data_point_t const * const dp_ptr = request;
+            connector_request_data_point_binary_t const * const bp_ptr = request;
+            uint32_t const * const pending_request_id = is_binary ? bp_ptr->request_id : dp_ptr->request_id;
 
-    if (data_point_pending != NULL)
-    {
-        connector_bool_t const pending_dp_has_request_id = connector_bool(data_point_pending->request_id != NULL);
-        connector_bool_t const matching_request = connector_bool(pending_dp_has_request_id && *data_point_pending->request_id == *request_id);
+            if (request == NULL)
+                continue;
 
-        if (cancel_all || matching_request)
-        {
-            if (session == NULL)
+            if (cancel_all || (pending_request_id != NULL && *pending_request_id == *request_id))
             {
-                status = dp_inform_status(connector_ptr, connector_request_id_data_point_status, data_point_pending->transport, data_point_pending->user_context, connector_session_error_cancel);
-                if (status != connector_working)
-                  goto done;
+                if (session == NULL)
+                {
+                    if (is_binary)
+                        status = dp_inform_status(connector_ptr, connector_request_id_data_point_binary_status, bp_ptr->transport, bp_ptr->user_context, connector_session_error_cancel);
+                    else
+                        status = dp_inform_status(connector_ptr, connector_request_id_data_point_status, dp_ptr->transport, dp_ptr->user_context, connector_session_error_cancel);
+                    if (status != connector_working)
+                        goto done;
+                }
+                /* skipped by dp_process_request() */
+                queue->entry[index].request = NULL;
             }
-            data_point_pending = NULL;
         }
     }
+
 done:
     return status;
 }
@@ -271,6 +293,25 @@ STATIC connector_status_t dp_send_message(connector_data_t * const connector_ptr
                                           uint32_t * request_id, unsigned long timeout_in_seconds)
 {
     connector_status_t result;
+#if (defined CONNECTOR_SHORT_MESSAGE)
+    connector_sm_data_t * sm_ptr = NULL;
+
+    switch (transport)
+    {
+    #if (defined CONNECTOR_TRANSPORT_UDP)
+        case connector_transport_udp:
+            sm_ptr = &connector_ptr->sm_udp;
+            break;
+    #endif
+    #if (defined CONNECTOR_TRANSPORT_SMS)
+        case connector_transport_sms:
+            sm_ptr = &connector_ptr->sm_sms;
+            break;
+    #endif
+        default:
+            break;
+    }
+#endif
 
     dp_info->header.transport = transport;
     dp_info->header.user_context = dp_info;
@@ -279,9 +320,21 @@ STATIC connector_status_t dp_send_message(connector_data_t * const connector_ptr
     dp_info->header.timeout_in_seconds = timeout_in_seconds;
     dp_info->header.content_type = NULL;
     dp_info->header.option = connector_data_service_send_option_overwrite;
+    dp_info->header.priority = connector_data_service_send_priority_normal;
     dp_info->header.request_id = request_id;
 
+#if (defined CONNECTOR_SHORT_MESSAGE)
+    /* the request_id was assigned when the data point was queued, see sm_initiate_action() */
+    if (sm_ptr != NULL)
+        sm_ptr->pending.pending_internal = connector_true;
+#endif
+
     result = connector_initiate_action(connector_ptr, connector_initiate_send_data, &dp_info->header);
+
+#if (defined CONNECTOR_SHORT_MESSAGE)
+    if (sm_ptr != NULL)
+        sm_ptr->pending.pending_internal = connector_false;
+#endif
     switch (result)
     {
         case connector_init_error:
@@ -394,33 +447,32 @@ done:
 STATIC connector_status_t dp_process_request(connector_data_t * const connector_ptr, connector_transport_t const transport)
 {
     connector_status_t result = connector_idle;
+    connector_dp_queue_t * const queue = &connector_ptr->dp_queue[transport];
 
-    if (connector_ptr->process_csv)
+    while (dp_queue_count(queue) > 0)
     {
-        if ((data_point_pending != NULL) && (data_point_pending->transport == transport))
+        unsigned int const index = dp_queue_index(queue->head);
+        void const * request;
+
+        /* read the entry only after the tail that published it */
+        CONNECTOR_MEMORY_BARRIER();
+        request = queue->entry[index].request;
+
+        if (request != NULL)
         {
-            result = dp_process_csv(connector_ptr, data_point_pending);
-            if (result != connector_pending)
-            {
-                connector_ptr->process_csv = connector_false;
-                data_point_pending = NULL;
-                goto done;
-            }
+            result = (queue->entry[index].type == dp_request_binary) ? dp_process_binary(connector_ptr, request) : dp_process_csv(connector_ptr, request);
+            if (result == connector_pending)
+                break;
         }
-    }
-    else
-    {
-        connector_ptr->process_csv = connector_true;
-    }
 
-    if ((data_point_binary_pending != NULL) && (data_point_binary_pending->transport == transport))
-    {
-        result = dp_process_binary(connector_ptr, data_point_binary_pending);
-        if (result != connector_pending)
-            data_point_binary_pending = NULL;
+        /* release the entry to connector_initiate_action() */
+        CONNECTOR_MEMORY_BARRIER();
+        queue->head = dp_queue_next(queue->head);
+
+        if (request != NULL)
+            break;
     }
 
-done:
     return result;
 }
 
@@ -895,6 +895,21 @@ STATIC connector_status_t data_service_put_request_init(connector_data_t * const
     ds_ptr->request_type = connector_request_id_data_service_send_data;
     session->service_context = ds_ptr;
 
+    switch (send_ptr->priority)
+    {
+    case connector_data_service_send_priority_interactive:
+        session->schedule.priority = msg_priority_interactive;
+        break;
+
+    case connector_data_service_send_priority_bulk:
+        session->schedule.priority = msg_priority_bulk;
+        break;
+
+    default:
+        /* keep the class msg_create_session() gave the send */
+        break;
+    }
+
     goto done;
 
 error:
@@ -62,6 +62,11 @@
 #define CONNECTOR_TRANSPORT_RECONNECT_AFTER     30
 #endif
 
+#define CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS  (CONNECTOR_TRANSPORT_RECONNECT_AFTER * UINT32_C(1000))
+
+/* connect_at is set to uptime + CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS */
+#define is_reconnect_due(uptime, connect_at)    connector_bool(((uptime) - ((connect_at) - CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS)) >= CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS)
+
 typedef enum {
 #if (defined CONNECTOR_TRANSPORT_TCP)
     connector_network_tcp,
@@ -156,6 +161,10 @@ typedef enum {
 
 struct connector_data;
 
+#if (defined CONNECTOR_COMPRESSION)
+#include "connector_zlib_def.h"
+#endif
+
 #if (defined CONNECTOR_TRANSPORT_TCP)
 #include "connector_edp_def.h"
 #endif
@@ -164,6 +173,91 @@ struct connector_data;
 #include "connector_sm_def.h"
 #endif
 
+#if (defined CONNECTOR_FILE_SYSTEM) && (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+/* Where an interrupted file system get or put stopped. The table lives in connector_data_t,
+ * so it outlives the EDP connection and is checked by the next request for the same path.
+ */
+typedef enum
+{
+    fs_checkpoint_free,
+    fs_checkpoint_active,
+    fs_checkpoint_saved
+} connector_fs_checkpoint_state_t;
+
+typedef struct
+{
+    char path[CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH];
+    connector_file_offset_t file_size;
+    connector_file_offset_t offset;
+    uint32_t last_modified;
+    uint8_t opcode;
+    connector_fs_checkpoint_state_t state;
+} connector_fs_checkpoint_entry_t;
+
+typedef struct
+{
+    connector_fs_checkpoint_entry_t entry[CONNECTOR_FILE_SYSTEM_CHECKPOINTS];
+    unsigned int evict;
+} connector_fs_checkpoint_t;
+#endif
+
+#if (defined CONNECTOR_RCI_SERVICE) && (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+/* Fingerprint of the last reported value of each state element, and the generation it last
+ * changed in. Kept in connector_data_t since the RCI parser data is freed after every session.
+ */
+typedef struct
+{
+    uint32_t fingerprint;
+    uint32_t changed;
+} connector_rci_tracking_entry_t;
+
+typedef struct
+{
+    uint32_t base;
+    uint32_t generation;
+    connector_rci_tracking_entry_t entry[CONNECTOR_RCI_STATE_TRACKING_ENTRIES];
+} connector_rci_tracking_t;
+#endif
+
+#if (defined CONNECTOR_DATA_POINTS)
+#if !(defined CONNECTOR_DATA_POINT_QUEUE_SIZE)
+#define CONNECTOR_DATA_POINT_QUEUE_SIZE     4
+#endif
+
+/* Data point requests accepted by connector_initiate_action() and waiting for
+ * connector_step() to start their send data session, one ring per transport.
+ * connector_initiate_action() only writes an entry and then advances tail;
+ * connector_step() only reads the entry at head and then advances head.
+ * The indices are volatile and each side issues CONNECTOR_MEMORY_BARRIER()
+ * between the entry and the index it hands over to the other thread.
+ */
+#if !(defined CONNECTOR_MEMORY_BARRIER)
+#if (defined __GNUC__)
+#define CONNECTOR_MEMORY_BARRIER()  __sync_synchronize()
+#else
+/* no barrier known: both threads must run on the same core */
+#define CONNECTOR_MEMORY_BARRIER()
+#endif
+#endif
+
+typedef enum
+{
+    dp_request_csv,
+    dp_request_binary
+} connector_dp_request_type_t;
+
+typedef struct
+{
+    struct
+    {
+        void const * request;
+        connector_dp_request_type_t type;
+    } entry[CONNECTOR_DATA_POINT_QUEUE_SIZE];
+    unsigned int volatile head;
+    unsigned int volatile tail;
+} connector_dp_queue_t;
+#endif
+
 typedef struct connector_data {
 
     uint8_t device_id[DEVICE_ID_LENGTH];
@@ -198,6 +292,7 @@ typedef struct connector_data {
 
     connector_callback_t callback;
     connector_status_t error_code;
+    connector_bool_t uptime_in_seconds_only;
 
 #if (defined CONNECTOR_TRANSPORT_UDP || defined CONNECTOR_TRANSPORT_SMS)
     uint32_t last_request_id;
@@ -218,10 +313,21 @@ typedef struct connector_data {
 #if (defined CONNECTOR_RCI_SERVICE)
     connector_remote_config_data_t const * rci_data;
     struct rci * rci_internal_data;
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+    connector_rci_tracking_t rci_tracking;
+#endif
 #endif
 
 #if (defined CONNECTOR_DATA_POINTS)
-    connector_bool_t process_csv;
+    connector_dp_queue_t dp_queue[connector_transport_all];
+#endif
+
+#if (defined CONNECTOR_COMPRESSION)
+    connector_zlib_pool_t zlib_pool;
+#endif
+
+#if (defined CONNECTOR_FILE_SYSTEM) && (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+    connector_fs_checkpoint_t fs_checkpoint;
 #endif
 
     struct {
@@ -188,17 +188,17 @@ connector_status_t connector_edp_step(connector_data_t * const connector_ptr)
             if (connector_ptr->edp_data.connect_at == 0)
             {
                 connector_debug_line("Waiting %d second before reconnecting TCP transport", CONNECTOR_TRANSPORT_RECONNECT_AFTER);
-                result = get_system_time(connector_ptr, &connector_ptr->edp_data.connect_at);
+                result = get_system_time_in_milliseconds(connector_ptr, &connector_ptr->edp_data.connect_at);
                 if (result != connector_working)
                     goto done;
-                connector_ptr->edp_data.connect_at += CONNECTOR_TRANSPORT_RECONNECT_AFTER;
+                connector_ptr->edp_data.connect_at += CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS;
             } else {
                 unsigned long int uptime;
 
-                result = get_system_time(connector_ptr, &uptime);
+                result = get_system_time_in_milliseconds(connector_ptr, &uptime);
                 if (result != connector_working)
                     goto done;
-                if (uptime >= connector_ptr->edp_data.connect_at)
+                if (is_reconnect_due(uptime, connector_ptr->edp_data.connect_at))
                     edp_set_active_state(connector_ptr, connector_transport_open);
             }
             break;
@@ -293,6 +293,34 @@ done:
     return result;
 }
 
+STATIC void edp_next_timeout(connector_data_t * const connector_ptr, unsigned long const uptime, unsigned long * const timeout)
+{
+    switch (edp_get_active_state(connector_ptr))
+    {
+    case connector_transport_send:
+    case connector_transport_receive:
+        /* Rx keepalive, see tcp_rx_keepalive_process() */
+        next_timeout_update(uptime, connector_ptr->edp_data.keepalive.last_rx_sent_time, GET_RX_KEEPALIVE_INTERVAL(connector_ptr) * UINT32_C(1000), timeout);
+
+        /* Tx keepalive, see tcp_receive_buffer() */
+        if (GET_TX_KEEPALIVE_INTERVAL(connector_ptr) > 0 && connector_ptr->edp_data.keepalive.last_tx_received_time != 0)
+        {
+            unsigned long const wait_count = connector_ptr->edp_data.keepalive.miss_tx_count + UINT32_C(1);
+            unsigned long const max_timeout = GET_TX_KEEPALIVE_INTERVAL(connector_ptr) * wait_count * UINT32_C(1000);
+
+            next_timeout_update(uptime, connector_ptr->edp_data.keepalive.last_tx_received_time, max_timeout, timeout);
+        }
+        break;
+
+    case connector_transport_wait_for_reconnect:
+        next_timeout_update(uptime, connector_ptr->edp_data.connect_at - CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS, CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS, timeout);
+        break;
+
+    default:
+        break;
+    }
+}
+
 connector_status_t edp_initiate_action(connector_data_t * const connector_ptr, connector_initiate_request_t const request, void const * const request_data)
 {
     connector_status_t result = connector_init_error;
@@ -392,10 +420,10 @@ connector_status_t edp_initiate_action(connector_data_t * const connector_ptr, c
         switch (request)
         {
             case connector_initiate_data_point:
-                result = dp_initiate_data_point(request_data);
+                result = dp_initiate_data_point(connector_ptr, request_data);
                 break;
             case connector_initiate_data_point_binary:
-                result = dp_initiate_data_point_binary(request_data);
+                result = dp_initiate_data_point_binary(connector_ptr, request_data);
                 break;
             /* default: */
             case connector_initiate_transport_start:
@@ -40,10 +40,30 @@
 #define MSG_RECV_WINDOW_SIZE        (4 * DEFAULT_BUFFER_SIZE)
 #endif
 
+#if !(defined MSG_RECV_WINDOW_MAX)
+#define MSG_RECV_WINDOW_MAX         (16 * DEFAULT_BUFFER_SIZE)
+#endif
+
+#if !(defined EDP_SEND_QUEUE_SIZE)
+#define EDP_SEND_QUEUE_SIZE         4
+#endif
+
+#if !(defined EDP_RECEIVE_RING_SIZE)
+#define EDP_RECEIVE_RING_SIZE       (2 * MSG_MAX_RECV_PACKET_SIZE)
+#endif
+
+#if (EDP_RECEIVE_RING_SIZE < MSG_MAX_RECV_PACKET_SIZE)
+#error "EDP_RECEIVE_RING_SIZE must be at least MSG_MAX_RECV_PACKET_SIZE"
+#endif
+
 #if (MSG_RECV_WINDOW_SIZE <= MSG_MAX_SEND_PACKET_SIZE)
 #error "MSG_RECV_WINDOW_SIZE must be bigger than MSG_MAX_SEND_PACKET_SIZE"
 #endif
 
+#if (MSG_RECV_WINDOW_MAX < MSG_RECV_WINDOW_SIZE)
+#error "MSG_RECV_WINDOW_MAX must not be smaller than MSG_RECV_WINDOW_SIZE"
+#endif
+
 #define EDP_MT_VERSION      2
 
 #define DEVICE_TYPE_LENGTH  32
@@ -136,13 +156,31 @@ struct connector_data;
 
 typedef connector_status_t (* send_complete_cb_t)(struct connector_data * const connector_ptr, uint8_t const * const packet, connector_status_t const status, void * const user_data);
 
+typedef struct {
+    uint8_t * ptr;
+    size_t bytes_sent;
+    size_t total_length;
+    send_complete_cb_t complete_cb;
+    void * user_data;
+    /* optional file region sent right after the buffer */
+    struct {
+        connector_filesystem_file_handle_t handle;
+        size_t length;
+    } file;
+} edp_send_frame_t;
+
+typedef enum {
+    edp_send_file_unknown,
+    edp_send_file_supported,
+    edp_send_file_unsupported
+} edp_send_file_support_t;
+
 typedef struct connector_buffer {
-    /* this buffer must be FIRST field in the structure
-     * since this is used between network interface
-     * and all facilities and facilities release the buffer
-     * by returning the pointer of the buffer.
+    /* points to the EDP header of a received frame. The frame is
+     * a slice of the receive ring and stays valid until the buffer
+     * is released by tcp_release_receive_packet().
      */
-    uint8_t buffer[MSG_MAX_RECV_PACKET_SIZE];
+    uint8_t * buffer;
     struct connector_buffer * next;
     connector_bool_t    in_use;
 } connector_buffer_t;
@@ -209,24 +247,26 @@ typedef struct connector_edp_data {
             uint8_t buffer[MSG_MAX_SEND_PACKET_SIZE];
             connector_bool_t in_use;
         } packet_buffer;
-        uint8_t * ptr;
-        size_t bytes_sent;
-        size_t total_length;
-        send_complete_cb_t complete_cb;
-        void * user_data;
+        /* frames waiting to be sent, oldest at head */
+        edp_send_frame_t frame[EDP_SEND_QUEUE_SIZE];
+        unsigned int head;
+        unsigned int count;
+        connector_bool_t vector_unsupported;
+        edp_send_file_support_t send_file;
     } send_packet;
 
     struct {
+        /* raw stream from Device Cloud. start is the first byte still
+         * referenced (a frame held by a facility or unparsed data),
+         * head is the next byte to parse and tail the end of data read.
+         */
+        uint8_t ring[EDP_RECEIVE_RING_SIZE];
+        size_t start;
+        size_t head;
+        size_t tail;
         connector_buffer_t packet_buffer;
         connector_buffer_t * free_packet_buffer;
-        connector_buffer_t * data_packet;
-        uint8_t * ptr;
-        int index;
         unsigned int timeout;
-        uint16_t  packet_type;
-        uint16_t  packet_length;
-        size_t bytes_received;
-        size_t total_length;
     } receive_packet;
 
     struct {
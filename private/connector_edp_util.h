@@ -47,16 +47,12 @@ STATIC void edp_reset_initial_data(connector_data_t * const connector_ptr)
     connector_ptr->edp_data.keepalive.last_tx_received_time = 0;
     connector_ptr->edp_data.keepalive.miss_tx_count = 0;
 
-    connector_ptr->edp_data.send_packet.total_length = 0;
-    connector_ptr->edp_data.send_packet.bytes_sent = 0;
-    connector_ptr->edp_data.send_packet.ptr = NULL;
-    connector_ptr->edp_data.send_packet.complete_cb = NULL;
-
-    connector_ptr->edp_data.receive_packet.total_length = 0;
-    connector_ptr->edp_data.receive_packet.bytes_received = 0;
-    connector_ptr->edp_data.receive_packet.index = 0;
-    connector_ptr->edp_data.receive_packet.ptr = NULL;
-    connector_ptr->edp_data.receive_packet.data_packet = NULL;
+    connector_ptr->edp_data.send_packet.head = 0;
+    connector_ptr->edp_data.send_packet.count = 0;
+
+    connector_ptr->edp_data.receive_packet.start = 0;
+    connector_ptr->edp_data.receive_packet.head = 0;
+    connector_ptr->edp_data.receive_packet.tail = 0;
     connector_ptr->edp_data.receive_packet.timeout = MAX_RECEIVE_TIMEOUT_IN_SECONDS;
     connector_ptr->edp_data.close_status = (connector_close_status_t)0;
 
@@ -66,10 +62,11 @@ STATIC void edp_reset_initial_data(connector_data_t * const connector_ptr)
 
 STATIC connector_bool_t is_valid_timing_limit(connector_data_t * const connector_ptr, unsigned long const start, unsigned long const limit)
 {
+    /* start and limit are in milliseconds */
     unsigned long elapsed = start;
     connector_bool_t rc = connector_false;
 
-    if (get_system_time(connector_ptr, &elapsed) == connector_working)
+    if (get_system_time_in_milliseconds(connector_ptr, &elapsed) == connector_working)
     {
         elapsed -= start;
         rc = (elapsed < limit) ? connector_true : connector_false;
@@ -22,6 +22,7 @@
 #define FS_IS_REG_FLAG           0x02
 #define FS_IS_LARGE_FLAG         0x02
 #define FS_LS_SINGLE_FILE        0x10
+#define FS_GET_DIRECT_FLAG       0x20
 #define FS_ERROR_INTERNAL_FLAG   0x40
 #define FS_SESSION_ERROR_CALLED  0x80
 
@@ -105,6 +106,9 @@ typedef struct
     connector_status_t status;
     fs_state_t state;
     uint8_t flags;
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+    connector_fs_checkpoint_entry_t * checkpoint;
+#endif
 
 } fs_context_t;
 
@@ -129,6 +133,10 @@ typedef struct
 #define FsIsLsSingleFile(context)   FsIsBitSet(context->flags, FS_LS_SINGLE_FILE)
 #define FsSetLsSingleFile(context)  FsBitSet(context->flags, FS_LS_SINGLE_FILE)
 
+#define FsIsGetDirect(context)   FsIsBitSet(context->flags, FS_GET_DIRECT_FLAG)
+#define FsSetGetDirect(context)  FsBitSet(context->flags, FS_GET_DIRECT_FLAG)
+#define FsClearGetDirect(context) FsBitClear(context->flags, FS_GET_DIRECT_FLAG)
+
 #define FsHasInternalError(context) FsIsBitSet(context->flags, FS_ERROR_INTERNAL_FLAG)
 #define FsSetInternalError(context, error) {FsBitSet(context->flags,FS_ERROR_INTERNAL_FLAG); context->errnum.internal=error;}
 
@@ -865,6 +873,230 @@ done:
     return status;
 }
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+STATIC connector_fs_checkpoint_entry_t * fs_checkpoint_find(connector_data_t * const connector_ptr,
+                                                           fs_opcode_t const opcode,
+                                                           char const * const path)
+{
+    connector_fs_checkpoint_entry_t * checkpoint = NULL;
+    size_t i;
+
+    for (i = 0; i < CONNECTOR_FILE_SYSTEM_CHECKPOINTS; i++)
+    {
+        connector_fs_checkpoint_entry_t * const entry = &connector_ptr->fs_checkpoint.entry[i];
+
+        if ((entry->state == fs_checkpoint_saved) && (entry->opcode == opcode) && (strcmp(entry->path, path) == 0))
+        {
+            checkpoint = entry;
+            break;
+        }
+    }
+
+    return checkpoint;
+}
+
+/* Ties the transfer to a checkpoint: the one an earlier attempt left behind, a free one
+   or else the saved one that is next in turn. Transfers find none while all are active. */
+STATIC void fs_checkpoint_claim(connector_data_t * const connector_ptr,
+                                fs_context_t * const context,
+                                char const * const path,
+                                connector_fs_checkpoint_entry_t * checkpoint)
+{
+    connector_fs_checkpoint_t * const table = &connector_ptr->fs_checkpoint;
+    size_t const path_len = strlen(path);
+    size_t i;
+
+    if (path_len >= sizeof checkpoint->path)
+    {
+        if (checkpoint != NULL)
+            checkpoint->state = fs_checkpoint_free;
+        checkpoint = NULL;
+        goto done;
+    }
+
+    for (i = 0; (checkpoint == NULL) && (i < CONNECTOR_FILE_SYSTEM_CHECKPOINTS); i++)
+    {
+        if (table->entry[i].state == fs_checkpoint_free)
+            checkpoint = &table->entry[i];
+    }
+
+    for (i = 0; (checkpoint == NULL) && (i < CONNECTOR_FILE_SYSTEM_CHECKPOINTS); i++)
+    {
+        connector_fs_checkpoint_entry_t * const entry = &table->entry[table->evict];
+
+        table->evict = (table->evict + 1) % CONNECTOR_FILE_SYSTEM_CHECKPOINTS;
+        if (entry->state == fs_checkpoint_saved)
+            checkpoint = entry;
+    }
+
+    if (checkpoint == NULL)
+        goto done;
+
+    memcpy(checkpoint->path, path, path_len + 1);
+    checkpoint->opcode = (uint8_t)context->opcode;
+    checkpoint->offset = context->data.f.offset;
+    checkpoint->file_size = 0;
+    checkpoint->last_modified = 0;
+    checkpoint->state = fs_checkpoint_active;
+
+done:
+    context->checkpoint = checkpoint;
+}
+
+STATIC connector_status_t fs_checkpoint_stat(connector_data_t * const connector_ptr,
+                                             msg_service_request_t * const service_request,
+                                             fs_context_t * const context,
+                                             char const * const path,
+                                             connector_file_system_stat_t * const data)
+{
+    data->path = path;
+    data->hash_algorithm.requested = connector_file_system_hash_none;
+    data->statbuf.file_size = 0;
+    data->statbuf.last_modified = 0;
+    data->statbuf.flags = connector_file_system_file_type_none;
+
+    return fs_call_user(connector_ptr,
+                        service_request,
+                        context,
+                        connector_request_id_file_system_stat,
+                        data);
+}
+
+/* A get that starts inside the range an interrupted get already sent is a resume. It is
+   only served while the file still has the size and modification time it had back then,
+   anything else would splice two versions of the file together. */
+STATIC connector_status_t fs_checkpoint_get_start(connector_data_t * const connector_ptr,
+                                                  msg_service_request_t * const service_request,
+                                                  fs_context_t * const context,
+                                                  char const * const path)
+{
+    connector_status_t status = connector_working;
+    connector_file_system_stat_t data;
+    connector_fs_checkpoint_entry_t * checkpoint;
+
+    if (FsGetState(context) >= fs_state_stat)
+        goto done;
+
+    status = fs_checkpoint_stat(connector_ptr, service_request, context, path, &data);
+    if (status == connector_pending)
+        goto done;
+
+    if (!FsOperationSuccess(status, context))
+        goto done;
+
+    checkpoint = fs_checkpoint_find(connector_ptr, fs_get_request_opcode, path);
+    if ((checkpoint != NULL) && (context->data.f.offset != 0) && (context->data.f.offset <= checkpoint->offset))
+    {
+        if ((checkpoint->file_size != data.statbuf.file_size) || (checkpoint->last_modified != data.statbuf.last_modified))
+        {
+            connector_debug_line("fs_checkpoint_get_start: %s changed since the interrupted get", path);
+            checkpoint->state = fs_checkpoint_free;
+            FsSetInternalError(context, fs_error_invalid_offset);
+            goto done;
+        }
+    }
+
+    fs_checkpoint_claim(connector_ptr, context, path, checkpoint);
+    if (context->checkpoint != NULL)
+    {
+        context->checkpoint->file_size = data.statbuf.file_size;
+        context->checkpoint->last_modified = data.statbuf.last_modified;
+    }
+    FsSetState(context, fs_state_stat);
+
+done:
+    return status;
+}
+
+/* A put resuming an interrupted one needs the bytes written before the break to still be in the file */
+STATIC connector_status_t fs_checkpoint_put_start(connector_data_t * const connector_ptr,
+                                                  msg_service_request_t * const service_request,
+                                                  fs_context_t * const context,
+                                                  char const * const path)
+{
+    connector_status_t status = connector_working;
+    connector_fs_checkpoint_entry_t * checkpoint;
+
+    if (FsGetState(context) >= fs_state_stat)
+        goto done;
+
+    checkpoint = fs_checkpoint_find(connector_ptr, fs_put_request_opcode, path);
+    if ((checkpoint != NULL) && (context->data.f.offset != 0) && (context->data.f.offset <= checkpoint->offset))
+    {
+        connector_file_system_stat_t data;
+
+        status = fs_checkpoint_stat(connector_ptr, service_request, context, path, &data);
+        if (status == connector_pending)
+            goto done;
+
+        if (!FsOperationSuccess(status, context))
+            goto done;
+
+        if ((data.statbuf.file_size < context->data.f.offset) || (data.statbuf.flags != connector_file_system_file_type_is_reg))
+        {
+            connector_debug_line("fs_checkpoint_put_start: %s lost the data of the interrupted put", path);
+            checkpoint->state = fs_checkpoint_free;
+            FsSetInternalError(context, fs_error_invalid_offset);
+            goto done;
+        }
+    }
+
+    fs_checkpoint_claim(connector_ptr, context, path, checkpoint);
+    FsSetState(context, fs_state_stat);
+
+done:
+    return status;
+}
+
+/* Called on a session error, keeps how far the transfer got for the next attempt */
+STATIC void fs_checkpoint_save(fs_context_t * const context)
+{
+    connector_fs_checkpoint_entry_t * const checkpoint = context->checkpoint;
+
+    if ((checkpoint == NULL) || (checkpoint->state != fs_checkpoint_active))
+        goto done;
+
+    switch (context->opcode)
+    {
+        case fs_get_request_opcode:
+            checkpoint->offset = context->data.f.offset + context->data.f.bytes_done;
+            break;
+
+        case fs_put_request_opcode:
+            checkpoint->offset = context->data.f.offset;
+            checkpoint->file_size = context->data.f.offset;
+            break;
+
+        default:
+            ASSERT(connector_false);
+            break;
+    }
+
+    if (checkpoint->offset == 0)
+    {
+        checkpoint->state = fs_checkpoint_free;
+        goto done;
+    }
+
+    checkpoint->state = fs_checkpoint_saved;
+    connector_debug_line("fs_checkpoint_save: %s interrupted at offset %lu", checkpoint->path, (unsigned long)checkpoint->offset);
+
+done:
+    return;
+}
+
+/* Transfers that finished, or failed without a session error, leave nothing to resume */
+STATIC void fs_checkpoint_release(fs_context_t * const context)
+{
+    connector_fs_checkpoint_entry_t * const checkpoint = context->checkpoint;
+
+    if ((checkpoint != NULL) && (checkpoint->state == fs_checkpoint_active))
+        checkpoint->state = fs_checkpoint_free;
+
+    context->checkpoint = NULL;
+}
+#endif
+
 STATIC size_t parse_file_path(fs_context_t * const context,
                               void const * const path_ptr,
                               size_t const buffer_size)
@@ -943,9 +1175,18 @@ STATIC connector_status_t process_file_get_request(connector_data_t * const conn
         char const * path = service_data->data_ptr;
         path += FS_OPCODE_BYTES;
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+        status = fs_checkpoint_get_start(connector_ptr, service_request, context, path);
+        if (FsGetState(context) != fs_state_stat)
+            goto done;
+#endif
         status = call_file_open_user(connector_ptr, service_request, context, path, CONNECTOR_FILE_O_RDONLY);
     }
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+done:
+#endif
+
     return status;
 }
 
@@ -974,6 +1215,19 @@ STATIC connector_status_t set_file_position(connector_data_t * const connector_p
             goto done;
         }
 
+        if (FsIsGetDirect(context))
+        {
+            /* direct chunks are sent blindly, so never ask for more than the file holds.
+               Files reporting no size (e.g. under /proc) are read the usual way. */
+            connector_file_offset_t const file_left = ret - context->data.f.offset;
+            uint32_t const file_left32 = (uint32_t)file_left;
+
+            if (ret == 0)
+                FsClearGetDirect(context);
+            else if (((connector_file_offset_t)file_left32 == file_left) && (file_left32 < context->data.f.data_length))
+                context->data.f.data_length = file_left32;
+        }
+
         FsSetState(context, fs_state_lseek1);
         status = call_file_lseek_user(connector_ptr, service_request, context, context->data.f.offset, connector_file_system_seek_set, &ret);
         if (FsOperationSuccess(status, context) && ret == -1)
@@ -1066,7 +1320,10 @@ STATIC connector_status_t process_file_get_response(connector_data_t * const con
         {
            if (FsGetState(context) < fs_state_lseek)
            {
-               if (context->data.f.offset != 0)
+               if ((FsGetState(context) < fs_state_lseek1) && MsgIsDirectData(service_data->flags))
+                   FsSetGetDirect(context);
+
+               if ((context->data.f.offset != 0) || FsIsGetDirect(context))
                {
                     status = set_file_position(connector_ptr, service_request, context);
                     if (status == connector_pending)
@@ -1084,6 +1341,18 @@ STATIC connector_status_t process_file_get_response(connector_data_t * const con
         /* bytes to read in this callback */
         bytes_to_read = MIN_VALUE(buffer_size, context->data.f.data_length - context->data.f.bytes_done);
 
+        /* Let the transport send all but the last chunk straight from the file.
+           The last one is read here, so the file is closed only after every
+           direct chunk went out. */
+        if (FsIsGetDirect(context) && MsgIsDirectData(service_data->flags) &&
+            (bytes_to_read < (context->data.f.data_length - context->data.f.bytes_done)))
+        {
+            service_data->direct_handle = context->handle.file;
+            service_data->direct_bytes = bytes_to_read;
+            bytes_read = bytes_to_read;
+            bytes_to_read = 0;
+        }
+
         while (bytes_to_read > 0)
         {
             size_t cnt = bytes_to_read;
@@ -1251,6 +1520,14 @@ STATIC connector_status_t process_file_put_request(connector_data_t * const conn
                 char const * path = service_data->data_ptr;
                 path += FS_OPCODE_BYTES;
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+                status = fs_checkpoint_put_start(connector_ptr, service_request, context, path);
+                if (status == connector_pending)
+                    goto done;
+
+                if (FsGetState(context) != fs_state_stat)
+                    goto close_file;
+#endif
                 if (FsNeedTrunc(context))
                 {
                     if (context->data.f.offset == 0)
@@ -1731,6 +2008,10 @@ STATIC connector_status_t allocate_file_context(connector_data_t * const connect
     context->state = fs_state_none;
     context->status = connector_working;
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+    context->checkpoint = NULL;
+#endif
+
     if (opcode != fs_ls_request_opcode)
     {
         context->data.f.bytes_done = 0;
@@ -1763,6 +2044,10 @@ STATIC connector_status_t file_system_request_callback(connector_data_t * const
             }
             session->service_context = context;
             context->opcode = opcode;
+
+            /* whole file transfers must not hold up listings and removals */
+            session->schedule.priority = ((opcode == fs_get_request_opcode) || (opcode == fs_put_request_opcode)) ?
+                                         msg_priority_bulk : msg_priority_interactive;
         }
     }
     else
@@ -1862,6 +2147,9 @@ STATIC connector_status_t file_system_free_callback(connector_data_t * const con
 
     if (context != NULL)
     {
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+        fs_checkpoint_release(context);
+#endif
         status = free_data_buffer(connector_ptr, named_buffer_id(msg_service), context);
     }
 
@@ -1936,6 +2224,10 @@ STATIC connector_status_t file_system_session_error_callback(connector_data_t *
                                         connector_request_id_file_system_closedir :
                                         connector_request_id_file_system_close;
 
+#if (defined CONNECTOR_FILE_SYSTEM_CHECKPOINTS)
+        fs_checkpoint_save(context);
+#endif
+
         status = call_file_close_user(connector_ptr, service_request, context, fs_request_id);
         if (status == connector_pending)
             goto done;
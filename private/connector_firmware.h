@@ -91,14 +91,49 @@ enum fw_target_list{
 static size_t const target_list_header_size = field_named_data(fw_target_list, opcode, size);
 static size_t const target_list_size = record_bytes(fw_target_list);
 
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+#if (CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE < 1)
+#error "CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE must be at least 1"
+#endif
+
+/* image data of a binary block message that is acknowledged but not yet
+ * accepted by the connector_request_id_firmware_download_data callback.
+ */
+typedef struct {
+    uint32_t offset;
+    size_t length;
+    uint8_t data[MSG_MAX_RECV_PACKET_SIZE - PACKET_EDP_FACILITY_SIZE];
+} fw_queued_block_t;
+#endif
+
 typedef struct {
     connector_data_t * connector_ptr;
     unsigned long last_fw_keepalive_sent_time;
+    unsigned long last_callback_time;
+
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    struct {
+        fw_queued_block_t block[CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE];
+        unsigned int head;
+        unsigned int count;
+        connector_bool_t abort_pending;
+        connector_firmware_status_t abort_status;
+    } queue;
+#endif
+
+    struct {
+        /* start time of the running phases, 0 when not running */
+        unsigned long receive_start;
+        unsigned long write_start;
+        unsigned long verify_start;
+        connector_firmware_download_stats_t stats;
+    } timing;
 
     size_t desc_length;
     size_t spec_length;
     size_t  response_size;
     connector_bool_t send_busy;
+    connector_bool_t response_queued;
     connector_bool_t update_started;
     connector_bool_t fw_keepalive_start;
     connector_firmware_info_t target_info;
@@ -124,11 +159,12 @@ STATIC connector_status_t get_fw_config(connector_firmware_data_t * const fw_ptr
         request_id.firmware_request = fw_request_id;
         status = connector_callback(connector_ptr->callback, connector_class_id_firmware, request_id, data, connector_ptr->context);
 
-        if (get_system_time(connector_ptr, &end_time_stamp) != connector_working)
+        if (get_system_time_in_milliseconds(connector_ptr, &end_time_stamp) != connector_working)
         {
             result = connector_abort;
             goto done;
         }
+        fw_ptr->last_callback_time = end_time_stamp;
 
         switch (status)
         {
@@ -151,7 +187,7 @@ STATIC connector_status_t get_fw_config(connector_firmware_data_t * const fw_ptr
          * Check whether we need to send target list message
          * to keep connection alive.
          */
-        fw_ptr->fw_keepalive_start = ((end_time_stamp - fw_ptr->last_fw_keepalive_sent_time) >= FW_TARGET_LIST_MSG_INTERVAL_IN_SECONDS) ? connector_true : connector_false;
+        fw_ptr->fw_keepalive_start = ((end_time_stamp - fw_ptr->last_fw_keepalive_sent_time) >= (FW_TARGET_LIST_MSG_INTERVAL_IN_SECONDS * UINT32_C(1000))) ? connector_true : connector_false;
     }
     else
     {
@@ -162,6 +198,66 @@ done:
     return result;
 }
 
+STATIC connector_status_t fw_phase_start(connector_firmware_data_t * const fw_ptr, unsigned long * const start_time)
+{
+    connector_status_t result = connector_working;
+
+    if (*start_time == 0)
+    {
+        result = get_system_time_in_milliseconds(fw_ptr->connector_ptr, start_time);
+    }
+    return result;
+}
+
+STATIC void fw_phase_end(connector_firmware_data_t * const fw_ptr, unsigned long * const start_time, unsigned long * const elapsed)
+{
+    /* last_callback_time is the time the phase's last callback returned */
+    if (*start_time != 0)
+    {
+        *elapsed += fw_ptr->last_callback_time - *start_time;
+        *start_time = 0;
+    }
+}
+
+STATIC connector_status_t fw_write_block(connector_firmware_data_t * const fw_ptr, connector_firmware_download_data_t * const download_data)
+{
+    connector_status_t result;
+
+    result = fw_phase_start(fw_ptr, &fw_ptr->timing.write_start);
+    if (result != connector_working)
+    {
+        result = connector_abort;
+        goto done;
+    }
+
+    result = get_fw_config(fw_ptr, connector_request_id_firmware_download_data, download_data);
+    if (result != connector_pending)
+    {
+        fw_phase_end(fw_ptr, &fw_ptr->timing.write_start, &fw_ptr->timing.stats.write_ms);
+    }
+
+done:
+    return result;
+}
+
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+STATIC void fw_flush_queue(connector_firmware_data_t * const fw_ptr)
+{
+    fw_ptr->queue.head = 0;
+    fw_ptr->queue.count = 0;
+    fw_ptr->timing.write_start = 0;
+}
+
+STATIC void fw_reset_queue(connector_firmware_data_t * const fw_ptr)
+{
+    fw_flush_queue(fw_ptr);
+    fw_ptr->queue.abort_pending = connector_false;
+}
+#else
+#define fw_flush_queue(fw_ptr)
+#define fw_reset_queue(fw_ptr)
+#endif
+
 STATIC fw_abort_status_t get_abort_status_code(connector_firmware_status_t const status)
 {
     fw_abort_status_t code;
@@ -219,13 +315,27 @@ enum fw_abort {
 
 #define FW_ABORT_HEADER_SIZE    record_bytes(fw_abort)
 
+STATIC connector_status_t fw_response_sent(connector_data_t * const connector_ptr, uint8_t const * const packet,
+                                           connector_status_t const status, void * const user_data)
+{
+    connector_firmware_data_t * const fw_ptr = user_data;
+
+    UNUSED_PARAMETER(connector_ptr);
+    UNUSED_PARAMETER(packet);
+    UNUSED_PARAMETER(status);
+
+    fw_ptr->response_queued = connector_false;
+    return connector_working;
+}
+
 STATIC connector_status_t send_fw_message(connector_firmware_data_t * const fw_ptr)
 {
 
     connector_status_t result;
 
-    result = tcp_initiate_send_facility_packet(fw_ptr->connector_ptr, fw_ptr->response_buffer, fw_ptr->response_size, E_MSG_FAC_FW_NUM, NULL, NULL);
+    result = tcp_initiate_send_facility_packet(fw_ptr->connector_ptr, fw_ptr->response_buffer, fw_ptr->response_size, E_MSG_FAC_FW_NUM, fw_response_sent, fw_ptr);
     fw_ptr->send_busy = (result == connector_pending) ? connector_true : connector_false;
+    fw_ptr->response_queued = (result == connector_working) ? connector_true : connector_false;
     return result;
 
 }
@@ -264,6 +374,7 @@ STATIC connector_status_t send_fw_abort(connector_firmware_data_t * const fw_ptr
     if (fw_ptr->target_info.target_number == target)
     {
         fw_ptr->update_started = connector_false;
+        fw_flush_queue(fw_ptr);
     }
     return result;
 
@@ -538,13 +649,102 @@ error:
         {
             fw_ptr->update_started = connector_true;
             fw_ptr->target_info.target_number = download_request.target_number;
+            fw_reset_queue(fw_ptr);
+            memset(&fw_ptr->timing, 0x00, sizeof fw_ptr->timing);
+        }
+
+    }
+
+done:
+    return result;
+}
+
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+STATIC connector_status_t fw_write_queued_blocks(connector_firmware_data_t * const fw_ptr)
+{
+    connector_status_t result = connector_working;
+
+    /* hand queued blocks to the callback in order until it is busy. A block
+     * that fails ends the update right away; its ack has already been sent
+     * so fw_process() tells Device Cloud with an abort message once
+     * response_buffer is free.
+     */
+    while (fw_ptr->queue.count > 0)
+    {
+        fw_queued_block_t const * const block = &fw_ptr->queue.block[fw_ptr->queue.head];
+        connector_firmware_download_data_t download_data;
+
+        download_data.target_number = fw_ptr->target_info.target_number;
+        download_data.image.offset = block->offset;
+        download_data.image.data = block->data;
+        download_data.image.bytes_used = block->length;
+        download_data.status = connector_firmware_status_success;
+
+        result = fw_write_block(fw_ptr, &download_data);
+        if (result == connector_pending)
+        {
+            result = connector_working;
+            break;
+        }
+        if (result != connector_working)
+        {
+            break;
+        }
+
+        if (download_data.status != connector_firmware_status_success)
+        {
+            fw_flush_queue(fw_ptr);
+            fw_ptr->update_started = connector_false;
+            fw_ptr->queue.abort_pending = connector_true;
+            fw_ptr->queue.abort_status = download_data.status;
+            break;
         }
 
+        fw_ptr->queue.head = (fw_ptr->queue.head + 1) % CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE;
+        fw_ptr->queue.count--;
+    }
+
+    return result;
+}
+
+STATIC connector_status_t fw_queue_block(connector_firmware_data_t * const fw_ptr, connector_firmware_download_data_t * const download_data)
+{
+    connector_status_t result = connector_working;
+
+    if (download_data->image.bytes_used > sizeof fw_ptr->queue.block[0].data)
+    {
+        download_data->status = connector_firmware_status_invalid_data;
+        goto done;
+    }
+
+    if (fw_ptr->queue.count == CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    {
+        /* queue is full: hold the message (and with it the EDP receive)
+         * until the callback has accepted a block.
+         */
+        result = connector_pending;
+        goto done;
+    }
+
+    {
+        unsigned int const tail = (fw_ptr->queue.head + fw_ptr->queue.count) % CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE;
+        fw_queued_block_t * const block = &fw_ptr->queue.block[tail];
+
+        block->offset = download_data->image.offset;
+        block->length = download_data->image.bytes_used;
+        memcpy(block->data, download_data->image.data, block->length);
+    }
+
+    fw_ptr->queue.count++;
+    if (fw_ptr->queue.count > fw_ptr->timing.stats.queue_high_water)
+    {
+        fw_ptr->timing.stats.queue_high_water = fw_ptr->queue.count;
     }
 
 done:
     return result;
 }
+#endif
 
 STATIC connector_status_t process_fw_binary_block(connector_firmware_data_t * const fw_ptr, uint8_t * const fw_binary_block, uint16_t const length)
 {
@@ -613,10 +813,24 @@ enum fw_binary_ack {
     download_data.image.data = (fw_binary_block + record_bytes(fw_binary_block));
     download_data.status = connector_firmware_status_success;
 
-    result = get_fw_config(fw_ptr, connector_request_id_firmware_download_data, &download_data);
+    if (fw_phase_start(fw_ptr, &fw_ptr->timing.receive_start) != connector_working)
+    {
+        result = connector_abort;
+        goto done;
+    }
+
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    /* the block is acknowledged as soon as it is queued; fw_process()
+     * passes it to the callback while further blocks are received.
+     */
+    result = fw_queue_block(fw_ptr, &download_data);
+#else
+    result = fw_write_block(fw_ptr, &download_data);
+#endif
 
     if (result == connector_working && download_data.status == connector_firmware_status_success)
     {
+        fw_ptr->timing.stats.blocks++;
 
         if(ack_required)
         {
@@ -684,6 +898,7 @@ STATIC connector_status_t process_fw_abort(connector_firmware_data_t * const fw_
         /* call callback */
         if (fw_ptr->target_info.target_number == request_data.target_number)
         {
+            fw_reset_queue(fw_ptr);
             result = get_fw_config(fw_ptr, connector_request_id_firmware_download_abort, &request_data);
             if (result != connector_pending)
             {
@@ -751,8 +966,37 @@ enum fw_complete_response {
     }
 
 
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    if (fw_ptr->queue.count > 0)
+    {
+        /* wait until fw_process() has written all queued blocks */
+        result = connector_pending;
+        goto done;
+    }
+#endif
+
+    if (fw_ptr->timing.verify_start == 0)
+    {
+        /* all image data is here: the receive phase ends and verify starts */
+        if (fw_phase_start(fw_ptr, &fw_ptr->timing.verify_start) != connector_working)
+        {
+            result = connector_abort;
+            goto done;
+        }
+        if (fw_ptr->timing.receive_start != 0)
+        {
+            fw_ptr->timing.stats.receive_ms = fw_ptr->timing.verify_start - fw_ptr->timing.receive_start;
+            fw_ptr->timing.receive_start = 0;
+        }
+    }
+
     /* call callback */
     result = get_fw_config(fw_ptr, connector_request_id_firmware_download_complete, &download_complete);
+    if (result != connector_pending)
+    {
+        fw_phase_end(fw_ptr, &fw_ptr->timing.verify_start, &fw_ptr->timing.stats.verify_ms);
+    }
+
     if (result == connector_working)
     {
         uint8_t * fw_complete_response = GET_PACKET_DATA_POINTER(fw_ptr->response_buffer, PACKET_EDP_FACILITY_SIZE);
@@ -808,7 +1052,7 @@ STATIC connector_status_t send_discovery_packet_callback(connector_data_t * cons
     connector_status_t result;
     connector_firmware_data_t * const fw_ptr = user_data;
     /* update fw download keepalive timing */
-    result = get_system_time(connector_ptr, &fw_ptr->last_fw_keepalive_sent_time);
+    result = get_system_time_in_milliseconds(connector_ptr, &fw_ptr->last_fw_keepalive_sent_time);
 
     tcp_release_packet_buffer(connector_ptr, packet, send_status, user_data);
 
@@ -908,6 +1152,50 @@ STATIC connector_status_t fw_process(connector_data_t * const connector_ptr, voi
     uint8_t * fw_message;
     uint16_t length;
 
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    if (fw_ptr->queue.count > 0)
+    {
+        /* commit queued blocks whether or not a message has arrived */
+        result = fw_write_queued_blocks(fw_ptr);
+        if (result != connector_working)
+        {
+            goto done;
+        }
+    }
+#endif
+
+    if (fw_ptr->response_queued)
+    {
+        /* response_buffer is still in the send queue, so no
+         * message that builds another response can be processed.
+         */
+        result = (edp_header != NULL || fw_ptr->update_started) ? connector_pending : connector_idle;
+        goto done;
+    }
+
+#if (defined CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE)
+    if (fw_ptr->queue.abort_pending && fw_ptr->send_busy == connector_false)
+    {
+        fw_abort_status_t fw_status;
+
+        /* abort_pending stays set until the abort is queued; send_busy is left
+         * for the response of a held message, which this abort does not answer.
+         */
+        fw_status.user_status = fw_ptr->queue.abort_status;
+        result = send_fw_abort(fw_ptr, (uint8_t)fw_ptr->target_info.target_number, fw_download_abort_opcode, fw_status);
+        fw_ptr->send_busy = connector_false;
+        if (result != connector_working)
+        {
+            goto done;
+        }
+        fw_ptr->queue.abort_pending = connector_false;
+
+        /* a held message is processed once the abort has left response_buffer */
+        result = (edp_header != NULL) ? connector_pending : connector_working;
+        goto done;
+    }
+#endif
+
     if (edp_header == NULL)
     {
         if (fw_ptr->update_started)
@@ -922,7 +1210,7 @@ STATIC connector_status_t fw_process(connector_data_t * const connector_ptr, voi
         result = fw_discovery(connector_ptr, facility_data, edp_header, receive_timeout);
         if (result == connector_working)
         {
-            if (get_system_time(connector_ptr, &fw_ptr->last_fw_keepalive_sent_time) != connector_working)
+            if (get_system_time_in_milliseconds(connector_ptr, &fw_ptr->last_fw_keepalive_sent_time) != connector_working)
             {
                 result = connector_abort;
                 goto done;
@@ -1050,8 +1338,10 @@ STATIC connector_status_t connector_facility_firmware_init(connector_data_t * co
     fw_ptr->last_fw_keepalive_sent_time = 0;
     fw_ptr->fw_keepalive_start = connector_false;
     fw_ptr->send_busy = connector_false;
+    fw_ptr->response_queued = connector_false;
     fw_ptr->update_started = connector_false;
     fw_ptr->connector_ptr = connector_ptr;
+    fw_reset_queue(fw_ptr);
 
     {
         connector_firmware_count_t firmware_data;
@@ -24,9 +24,17 @@
 #define MSG_FACILITY_VERSION  0x01
 #define MSG_COMPRESSION_NONE  0x00
 #define MSG_COMPRESSION_LIBZ  0xFF
+#define MSG_COMPRESSION_LIBZ_DICT  0xFE
 
 #define MSG_INVALID_CLIENT_SESSION  0xFFFF
 
+#define MSG_SESSION_TABLE_INITIAL_SIZE  16
+
+/* Session steps each priority class may run in one scheduling round */
+#define MSG_PRIORITY_WEIGHT_INTERACTIVE 8
+#define MSG_PRIORITY_WEIGHT_NORMAL      2
+#define MSG_PRIORITY_WEIGHT_BULK        1
+
 #define MSG_FLAG_REQUEST      UINT32_C(0x01)
 #define MSG_FLAG_LAST_DATA    UINT32_C(0x02)
 #define MSG_FLAG_SENDER       UINT32_C(0x04)
@@ -40,6 +48,8 @@
 #define MSG_FLAG_DEFLATED     UINT32_C(0x800)
 #define MSG_FLAG_SEND_NOW     UINT32_C(0x1000)
 #define MSG_FLAG_DOUBLE_BUF   UINT32_C(0x2000)
+#define MSG_FLAG_DIRECT_DATA  UINT32_C(0x4000)
+#define MSG_FLAG_DICTIONARY   UINT32_C(0x8000)
 
 #define MsgIsBitSet(flag, bit)   (connector_bool(((flag) & (bit)) == (bit)))
 #define MsgIsBitClear(flag, bit) (connector_bool(((flag) & (bit)) == 0))
@@ -58,6 +68,8 @@
 #define MsgIsDeflated(flag)     MsgIsBitSet((flag), MSG_FLAG_DEFLATED)
 #define MsgIsSendNow(flag)      MsgIsBitSet((flag), MSG_FLAG_SEND_NOW)
 #define MsgIsDoubleBuf(flag)    MsgIsBitSet((flag), MSG_FLAG_DOUBLE_BUF)
+#define MsgIsDirectData(flag)   MsgIsBitSet((flag), MSG_FLAG_DIRECT_DATA)
+#define MsgIsDictionary(flag)   MsgIsBitSet((flag), MSG_FLAG_DICTIONARY)
 
 #define MsgIsNotRequest(flag)      MsgIsBitClear((flag), MSG_FLAG_REQUEST)
 #define MsgIsNotLastData(flag)     MsgIsBitClear((flag), MSG_FLAG_LAST_DATA)
@@ -79,6 +91,8 @@
 #define MsgSetDeflated(flag)    MsgBitSet((flag), MSG_FLAG_DEFLATED)
 #define MsgSetSendNow(flag)     MsgBitSet((flag), MSG_FLAG_SEND_NOW)
 #define MsgSetDoubleBuf(flag)   MsgBitSet((flag), MSG_FLAG_DOUBLE_BUF)
+#define MsgSetDirectData(flag)  MsgBitSet((flag), MSG_FLAG_DIRECT_DATA)
+#define MsgSetDictionary(flag)  MsgBitSet((flag), MSG_FLAG_DICTIONARY)
 
 #define MsgClearRequest(flag)     MsgBitClear((flag), MSG_FLAG_REQUEST)
 #define MsgClearLastData(flag)    MsgBitClear((flag), MSG_FLAG_LAST_DATA)
@@ -100,6 +114,15 @@ typedef enum
     msg_service_id_count
 } msg_service_id_t;
 
+/* Scheduling classes, highest priority first */
+typedef enum
+{
+    msg_priority_interactive,
+    msg_priority_normal,
+    msg_priority_bulk,
+    msg_priority_count
+} msg_priority_t;
+
 typedef enum
 {
     msg_opcode_capability,
@@ -200,6 +223,12 @@ typedef struct msg_data_block_t
 {
     size_t total_bytes;
     size_t available_window;
+    struct
+    {
+        unsigned long ack_time;
+        unsigned long probe_time;
+        size_t probe_edge;
+    } flow;
     size_t ack_count;
     unsigned int status_flag;
 #if (defined CONNECTOR_COMPRESSION)
@@ -207,7 +236,7 @@ typedef struct msg_data_block_t
     uint8_t  buffer_out[MSG_MAX_RECV_PACKET_SIZE];
     size_t   bytes_out;
     int      z_flag;
-    z_stream zlib;
+    z_streamp zlib;
 #endif
 } msg_data_block_t;
 
@@ -216,6 +245,10 @@ typedef struct
     void * data_ptr;
     size_t length_in_bytes;
     unsigned int flags;
+    /* with MSG_FLAG_DIRECT_DATA the service may leave the last direct_bytes
+       of length_in_bytes in direct_handle, the transport sends them from there */
+    connector_filesystem_file_handle_t direct_handle;
+    size_t direct_bytes;
 } msg_service_data_t;
 
 #if (defined CONNECTOR_DATA_SERVICE)
@@ -253,6 +286,14 @@ typedef struct msg_session_t
     connector_session_error_t error;
     unsigned int error_flag;
     msg_service_request_t service_layer_data;
+    struct
+    {
+        msg_priority_t priority;
+        unsigned long serial;
+        unsigned long ready_since;
+        unsigned int blocked_step;
+        connector_bool_t queued;
+    } schedule;
     struct msg_session_t * next;
     struct msg_session_t * prev;
 } msg_session_t;
@@ -263,20 +304,41 @@ typedef struct
 {
     uint32_t window_size;
     connector_bool_t compression_supported;
+#if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+    connector_bool_t dictionary_supported;
+#endif
     uint8_t active_transactions;
     uint8_t max_transactions;
 } msg_capabilities_t;
 
+/* Per class totals: session steps run and how long ready sessions waited for them */
+typedef struct
+{
+    unsigned long served;
+    unsigned long delay_total_ms;
+    unsigned long delay_max_ms;
+} msg_priority_stats_t;
+
 typedef struct
 {
     msg_capabilities_t capabilities[msg_capability_count];
     connector_msg_callback_t * service_cb[msg_service_id_count];
     connector_bool_t session_locked;
+    unsigned long rtt_ms;
+    struct
+    {
+        unsigned int credit[msg_priority_count];
+        msg_priority_stats_t stats[msg_priority_count];
+        unsigned long serial;
+        unsigned int step;
+    } scheduler;
     struct
     {
         msg_session_t * head;
         msg_session_t * tail;
-        msg_session_t * current;
+        msg_session_t ** table;
+        unsigned int table_size;
+        unsigned int count;
     } session;
     unsigned int last_assigned_id;
     struct {
@@ -285,26 +347,154 @@ typedef struct
     } pending_service_request;
 } connector_msg_data_t;
 
+#if (defined CONNECTOR_NO_MALLOC)
+STATIC unsigned int msg_session_table_static_size(void);
+#endif
+
+/* Sessions are also kept in an open addressing table (linear probing, at most half full)
+ * keyed on session id and owner, so received frames do not walk the session list.
+ */
+#define msg_session_key(id, client_owned)   ((uint32_t)(((uint32_t)(id) << 1) | ((client_owned) == connector_true ? 1 : 0)))
+#define msg_session_hash(key, size)         ((unsigned int)((uint32_t)((key) * UINT32_C(0x9E3779B1)) >> 8) & ((size) - 1))
+
+STATIC connector_bool_t msg_session_is_client_owned(msg_session_t const * const session)
+{
+    unsigned int const status = (session->in_dblock != NULL) ? session->in_dblock->status_flag : session->out_dblock->status_flag;
+
+    return MsgIsClientOwned(status);
+}
+
+STATIC unsigned int msg_session_slot(msg_session_t const * const session, unsigned int const table_size)
+{
+    uint32_t const key = msg_session_key(session->session_id, msg_session_is_client_owned(session));
+
+    return msg_session_hash(key, table_size);
+}
+
 STATIC msg_session_t * msg_find_session(connector_msg_data_t const * const msg_ptr, unsigned int const id, connector_bool_t const client_owned)
 {
-    msg_session_t * session = msg_ptr->session.head;
+    msg_session_t * session = NULL;
+    unsigned int const table_size = msg_ptr->session.table_size;
 
-    while (session != NULL)
+    if (table_size > 0)
     {
-        if (session->session_id == id)
+        uint32_t const key = msg_session_key(id, client_owned);
+        unsigned int slot = msg_session_hash(key, table_size);
+
+        while (msg_ptr->session.table[slot] != NULL)
         {
-            unsigned int const status = (session->in_dblock != NULL) ? session->in_dblock->status_flag : session->out_dblock->status_flag;
+            msg_session_t * const entry = msg_ptr->session.table[slot];
 
-            if (MsgIsClientOwned(status) == client_owned)
+            if (msg_session_key(entry->session_id, msg_session_is_client_owned(entry)) == key)
+            {
+                session = entry;
                 break;
+            }
+            slot = (slot + 1) & (table_size - 1);
         }
-
-        session = session->next;
     }
 
     return session;
 }
 
+STATIC void msg_session_table_insert(msg_session_t ** const table, unsigned int const table_size, msg_session_t * const session)
+{
+    unsigned int slot = msg_session_slot(session, table_size);
+
+    while (table[slot] != NULL)
+        slot = (slot + 1) & (table_size - 1);
+
+    table[slot] = session;
+}
+
+STATIC connector_status_t msg_session_table_add(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, msg_session_t * const session)
+{
+    connector_status_t status = connector_working;
+    unsigned int const table_size = msg_ptr->session.table_size;
+
+    if (2 * (msg_ptr->session.count + 1) > table_size)
+    {
+        msg_session_t ** new_table;
+#if (defined CONNECTOR_NO_MALLOC)
+        /* the static table is sized for every session buffer, it never needs to grow */
+        unsigned int const new_size = msg_session_table_static_size();
+
+        ASSERT_GOTO(table_size == 0, done);
+#else
+        unsigned int const new_size = (table_size == 0) ? MSG_SESSION_TABLE_INITIAL_SIZE : 2 * table_size;
+#endif
+
+        {
+            void * ptr;
+
+            status = malloc_data_buffer(connector_ptr, new_size * sizeof *new_table, named_buffer_id(msg_session_table), &ptr);
+            if (status != connector_working) goto done;
+            new_table = ptr;
+            memset(new_table, 0, new_size * sizeof *new_table);
+        }
+
+        if (msg_ptr->session.table != NULL)
+        {
+            unsigned int i;
+
+            for (i = 0; i < table_size; i++)
+            {
+                if (msg_ptr->session.table[i] != NULL)
+                    msg_session_table_insert(new_table, new_size, msg_ptr->session.table[i]);
+            }
+
+            status = free_data_buffer(connector_ptr, named_buffer_id(msg_session_table), msg_ptr->session.table);
+        }
+
+        msg_ptr->session.table = new_table;
+        msg_ptr->session.table_size = new_size;
+        if (status != connector_working) goto done;
+    }
+
+    msg_session_table_insert(msg_ptr->session.table, msg_ptr->session.table_size, session);
+    msg_ptr->session.count++;
+
+done:
+    return status;
+}
+
+STATIC void msg_session_table_remove(connector_msg_data_t * const msg_ptr, msg_session_t * const session)
+{
+    msg_session_t ** const table = msg_ptr->session.table;
+    unsigned int const mask = msg_ptr->session.table_size - 1;
+    unsigned int hole;
+    unsigned int slot;
+
+    ASSERT_GOTO(table != NULL, done);
+
+    hole = msg_session_slot(session, msg_ptr->session.table_size);
+    while (table[hole] != session)
+    {
+        ASSERT_GOTO(table[hole] != NULL, done);
+        hole = (hole + 1) & mask;
+    }
+    table[hole] = NULL;
+    msg_ptr->session.count--;
+
+    /* shift the rest of the probe run back so lookups never stop at the new hole */
+    for (slot = (hole + 1) & mask; table[slot] != NULL; slot = (slot + 1) & mask)
+    {
+        unsigned int const home = msg_session_slot(table[slot], msg_ptr->session.table_size);
+        connector_bool_t const stays = (hole <= slot) ? connector_bool((home > hole) && (home <= slot))
+                                                      : connector_bool((home > hole) || (home <= slot));
+
+        if (!stays)
+        {
+            table[hole] = table[slot];
+            table[slot] = NULL;
+            hole = slot;
+        }
+    }
+
+done:
+    return;
+}
+
 static unsigned int msg_find_next_available_id(connector_msg_data_t * const msg_ptr)
 {
     unsigned int new_id = MSG_INVALID_CLIENT_SESSION;
@@ -398,10 +588,35 @@ STATIC connector_status_t msg_inform_error(connector_data_t * const connector_pt
     return msg_call_service_layer(connector_ptr, session, msg_service_type_error);
 }
 
+/* Services may move a session to another class once they know what the request is */
+STATIC msg_priority_t msg_default_priority(unsigned int const service_id, connector_bool_t const client_owned)
+{
+    msg_priority_t priority;
+
+    switch (service_id)
+    {
+    case msg_service_id_rci:
+    case msg_service_id_brci:
+        priority = msg_priority_interactive;
+        break;
+
+    case msg_service_id_data:
+        /* device requests have someone waiting on the other end, sends and data points do not */
+        priority = client_owned ? msg_priority_normal : msg_priority_interactive;
+        break;
+
+    default:
+        priority = msg_priority_normal;
+        break;
+    }
+
+    return priority;
+}
+
 STATIC msg_session_t * msg_create_session(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, unsigned int const service_id,
-                                          connector_bool_t const client_owned, connector_status_t * const status)
+                                          connector_bool_t const client_owned, unsigned int const cloud_session_id, connector_status_t * const status)
 {
-    unsigned int session_id = MSG_INVALID_CLIENT_SESSION;
+    unsigned int session_id = cloud_session_id;
     msg_capability_type_t const capability_id = client_owned == connector_true ? msg_capability_cloud : msg_capability_client;
     msg_session_t * session = NULL;
     unsigned int flags = 0;
@@ -431,6 +646,11 @@ STATIC msg_session_t * msg_create_session(connector_data_t * const connector_ptr
     MsgSetRequest(flags);
     #if (defined CONNECTOR_COMPRESSION)
     MsgSetCompression(flags);
+    #if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+    /* both directions of the session use the preset dictionary once Device Cloud announced it */
+    if (msg_ptr->capabilities[msg_capability_cloud].dictionary_supported)
+        MsgSetDictionary(flags);
+    #endif
     #endif
 
     switch (service_id)
@@ -498,15 +718,35 @@ STATIC msg_session_t * msg_create_session(connector_data_t * const connector_ptr
     session->service_context = NULL;
     session->current_state = msg_state_init;
     session->saved_state = msg_state_init;
+    session->schedule.priority = msg_default_priority(service_id, client_owned);
+    session->schedule.serial = 0;
+    session->schedule.ready_since = 0;
+    session->schedule.blocked_step = msg_ptr->scheduler.step - 1;
+    session->schedule.queued = connector_false;
 
     if (session->out_dblock != NULL)
+    {
         session->out_dblock->status_flag = flags;
+#if (defined CONNECTOR_COMPRESSION)
+        session->out_dblock->zlib = NULL;
+#endif
+    }
 
     if (session->in_dblock != NULL)
+    {
         session->in_dblock->status_flag = flags;
+#if (defined CONNECTOR_COMPRESSION)
+        session->in_dblock->zlib = NULL;
+#endif
+    }
 
     if (msg_ptr->session_locked) goto error;
     msg_ptr->session_locked = connector_true;
+    if (msg_session_table_add(connector_ptr, msg_ptr, session) != connector_working)
+    {
+        msg_ptr->session_locked = connector_false;
+        goto error;
+    }
     add_list_node(&msg_ptr->session.head, &msg_ptr->session.tail, session);
     msg_ptr->session_locked = connector_false;
 
@@ -537,17 +777,16 @@ STATIC connector_status_t msg_delete_session(connector_data_t * const connector_
     if (msg_ptr->session_locked) goto error;
     msg_ptr->session_locked = connector_true;
     remove_list_node(&msg_ptr->session.head, &msg_ptr->session.tail, session);
-    if (msg_ptr->session.current == session)
-        msg_ptr->session.current = (session->prev != NULL) ? session->prev : msg_ptr->session.tail;
+    msg_session_table_remove(msg_ptr, session);
     msg_ptr->session_locked = connector_false;
 
     #if (defined CONNECTOR_COMPRESSION)
     {
-        if ((session->in_dblock != NULL) && MsgIsInflated(session->in_dblock->status_flag))
-            inflateEnd(&session->in_dblock->zlib);
+        if (session->in_dblock != NULL)
+            zlib_stream_release(connector_ptr, &session->in_dblock->zlib);
 
-        if ((session->out_dblock != NULL) && MsgIsDeflated(session->out_dblock->status_flag))
-            deflateEnd(&session->out_dblock->zlib);
+        if (session->out_dblock != NULL)
+            zlib_stream_release(connector_ptr, &session->out_dblock->zlib);
     }
     #endif
 
@@ -588,26 +827,38 @@ STATIC void msg_default_data_block(msg_data_block_t * dblock, uint32_t const win
     dblock->available_window = window_size;
     dblock->ack_count = 0;
     dblock->total_bytes = 0;
+    dblock->flow.ack_time = 0;
+    dblock->flow.probe_time = 0;
+    dblock->flow.probe_edge = 0;
     MsgSetStart(dblock->status_flag);
     MsgClearLastData(dblock->status_flag);
     MsgClearAckPending(dblock->status_flag);
 }
 
-STATIC connector_session_error_t msg_initialize_data_block(msg_session_t * const session, uint32_t const window_size, msg_block_state_t state)
+STATIC connector_session_error_t msg_initialize_data_block(connector_data_t * const connector_ptr, msg_session_t * const session, uint32_t const window_size, msg_block_state_t state)
 {
     connector_session_error_t result = connector_session_error_none;
 
+    #if !(defined CONNECTOR_COMPRESSION)
+    UNUSED_PARAMETER(connector_ptr);
+    #endif
     ASSERT_GOTO(session != NULL, error);
 
     switch(state)
     {
     case msg_block_state_send_response:
+        #if (defined CONNECTOR_COMPRESSION)
+        /* the request is complete, let another session have the inflate stream */
+        if ((session->in_dblock != NULL) && MsgIsInflated(session->in_dblock->status_flag))
+        {
+            zlib_stream_release(connector_ptr, &session->in_dblock->zlib);
+            MsgClearInflated(session->in_dblock->status_flag);
+        }
+        #endif
         if (session->out_dblock == NULL)
         {
             #if (defined CONNECTOR_COMPRESSION)
             ASSERT_GOTO(session->in_dblock != NULL, compression_error);
-            inflateEnd(&session->in_dblock->zlib);
-            MsgClearInflated(session->in_dblock->status_flag);
             #endif
             session->out_dblock = session->in_dblock;
             ASSERT_GOTO(session->service_layer_data.have_data != NULL, error);
@@ -626,20 +877,29 @@ STATIC connector_session_error_t msg_initialize_data_block(msg_session_t * const
         #if (defined CONNECTOR_COMPRESSION)
         if (MsgIsNotDeflated(session->out_dblock->status_flag) == connector_true)
         {
-            memset(&session->out_dblock->zlib, 0, sizeof session->out_dblock->zlib);
-            ASSERT_GOTO(deflateInit(&session->out_dblock->zlib, Z_DEFAULT_COMPRESSION) == Z_OK, compression_error);
+            if (zlib_stream_acquire(connector_ptr, zlib_stream_deflate, &session->out_dblock->zlib) != connector_working)
+                goto compression_error;
+            #if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+            if (MsgIsDictionary(session->out_dblock->status_flag) && (zlib_deflate_dictionary(session->out_dblock->zlib) != connector_working))
+                goto compression_error;
+            #endif
             MsgSetDeflated(session->out_dblock->status_flag);
         }
         #endif
         break;
 
     case msg_block_state_recv_response:
+        #if (defined CONNECTOR_COMPRESSION)
+        if ((session->out_dblock != NULL) && MsgIsDeflated(session->out_dblock->status_flag))
+        {
+            zlib_stream_release(connector_ptr, &session->out_dblock->zlib);
+            MsgClearDeflated(session->out_dblock->status_flag);
+        }
+        #endif
         if (session->in_dblock == NULL)
         {
             #if (defined CONNECTOR_COMPRESSION)
             ASSERT_GOTO(session->out_dblock != NULL, compression_error);
-            deflateEnd(&session->out_dblock->zlib);
-            MsgClearDeflated(session->out_dblock->status_flag);
             #endif
             session->in_dblock = session->out_dblock;
             ASSERT_GOTO(session->service_layer_data.need_data != NULL, error);
@@ -657,8 +917,8 @@ STATIC connector_session_error_t msg_initialize_data_block(msg_session_t * const
         #if (defined CONNECTOR_COMPRESSION)
         if (MsgIsNotInflated(session->in_dblock->status_flag) == connector_true)
         {
-            memset(&session->in_dblock->zlib, 0, sizeof session->in_dblock->zlib);
-            ASSERT_GOTO(inflateInit(&session->in_dblock->zlib) == Z_OK, compression_error);
+            if (zlib_stream_acquire(connector_ptr, zlib_stream_inflate, &session->in_dblock->zlib) != connector_working)
+                goto compression_error;
             MsgSetInflated(session->in_dblock->status_flag);
         }
         #endif
@@ -734,11 +994,18 @@ STATIC connector_status_t msg_send_capabilities(connector_data_t * const connect
 
     /* append compression algorithms supported */
     {
-        uint8_t const compression_length = (msg_ptr->capabilities[msg_capability_client].compression_supported) ? 1 : 0;
+        uint8_t compression_length = 0;
+
+        if (msg_ptr->capabilities[msg_capability_client].compression_supported)
+        {
+            #if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+            variable_data_ptr[compression_length++] = MSG_COMPRESSION_LIBZ_DICT;
+            #endif
+            variable_data_ptr[compression_length++] = MSG_COMPRESSION_LIBZ;
+        }
 
         message_store_u8(capability_packet, compression_count, compression_length);
-        if (compression_length > 0)
-            *variable_data_ptr++ = MSG_COMPRESSION_LIBZ;
+        variable_data_ptr += compression_length;
     }
 
     /* append service IDs of all listeners */
@@ -804,7 +1071,14 @@ STATIC void msg_fill_msg_header(msg_session_t * const session, void * ptr)
             message_store_be16(start_packet, transaction_id, session_id);
             message_store_be16(start_packet, service_id, service_id);
         }
-        message_store_u8(start_packet, compression_id, (MsgIsCompressed(session->out_dblock->status_flag) ? MSG_COMPRESSION_LIBZ : MSG_COMPRESSION_NONE));
+        {
+            uint8_t compression_id = MSG_COMPRESSION_NONE;
+
+            if (MsgIsCompressed(session->out_dblock->status_flag))
+                compression_id = MsgIsDictionary(session->out_dblock->status_flag) ? MSG_COMPRESSION_LIBZ_DICT : MSG_COMPRESSION_LIBZ;
+
+            message_store_u8(start_packet, compression_id, compression_id);
+        }
     }
     else
     {
@@ -869,14 +1143,14 @@ STATIC connector_status_t msg_send_complete(connector_data_t * const connector_p
 
             #if (defined CONNECTOR_COMPRESSION)
             dblock->bytes_out = 0;
-            if (dblock->zlib.avail_out == 0)
+            if (dblock->zlib->avail_out == 0)
             {
                 session->current_state = msg_state_compress;
                 goto done;
             }
 
             dblock->z_flag = Z_NO_FLUSH;
-            dblock->zlib.avail_out = 0;
+            dblock->zlib->avail_out = 0;
             #else
             session->send_data_bytes = 0;
             #endif
@@ -915,7 +1189,22 @@ STATIC connector_status_t msg_send_data(connector_data_t * const connector_ptr,
     #endif
 
     ASSERT_GOTO(bytes > 0, error);
+    #if !(defined CONNECTOR_COMPRESSION)
+    {
+        msg_service_data_t const * const service_data = session->service_layer_data.need_data;
+
+        if ((service_data != NULL) && (service_data->direct_bytes > 0))
+        {
+            ASSERT_GOTO(bytes > service_data->direct_bytes, error);
+            status = tcp_initiate_send_facility_file(connector_ptr, buffer, bytes - service_data->direct_bytes, E_MSG_FAC_MSG_NUM,
+                                                     service_data->direct_handle, service_data->direct_bytes, msg_send_complete, session);
+        }
+        else
+            status = tcp_initiate_send_facility_packet(connector_ptr, buffer, bytes, E_MSG_FAC_MSG_NUM, msg_send_complete, session);
+    }
+    #else
     status = tcp_initiate_send_facility_packet(connector_ptr, buffer, bytes, E_MSG_FAC_MSG_NUM, msg_send_complete, session);
+    #endif
     if (status != connector_working)
     {
         connector_status_t result = status;
@@ -938,7 +1227,7 @@ STATIC connector_status_t msg_compress_data(connector_data_t * const connector_p
     msg_data_block_t * const dblock = session->out_dblock;
     uint8_t * const msg_buffer = GET_PACKET_DATA_POINTER(dblock->buffer_out, PACKET_EDP_FACILITY_SIZE);
     size_t const frame_bytes = sizeof dblock->buffer_out - PACKET_EDP_FACILITY_SIZE;
-    z_streamp zlib_ptr = &dblock->zlib;
+    z_streamp zlib_ptr = dblock->zlib;
     int zret;
 
     if (zlib_ptr->avail_out == 0)
@@ -981,7 +1270,7 @@ STATIC connector_status_t msg_prepare_send_data(connector_data_t * const connect
 
     UNUSED_PARAMETER(connector_ptr);
     ASSERT_GOTO(dblock != NULL, error);
-    ASSERT_GOTO(dblock->zlib.avail_in == 0, error);
+    ASSERT_GOTO(dblock->zlib->avail_in == 0, error);
 
     {
         unsigned int const flag = (dblock->total_bytes == 0) ? MSG_FLAG_START : 0;
@@ -1004,10 +1293,10 @@ STATIC connector_status_t msg_process_send_data(connector_data_t * const connect
     msg_data_block_t * const dblock = session->out_dblock;
 
     ASSERT_GOTO(dblock != NULL, error);
-    ASSERT_GOTO(dblock->zlib.avail_in == 0, error);
+    ASSERT_GOTO(dblock->zlib->avail_in == 0, error);
 
     {
-        z_streamp const zlib_ptr = &dblock->zlib;
+        z_streamp const zlib_ptr = dblock->zlib;
         msg_service_data_t * const service_data = session->service_layer_data.need_data;
 
         zlib_ptr->next_in = dblock->buffer_in;
@@ -1062,15 +1351,21 @@ STATIC connector_status_t msg_prepare_send_data(connector_data_t * const connect
     {
         size_t const header_bytes = MsgIsStart(dblock->status_flag) == connector_true ? record_end(start_packet) : record_end(data_packet);
         msg_service_data_t * const service_data = session->service_layer_data.need_data;
-        unsigned int const flag = MsgIsStart(dblock->status_flag) ? MSG_FLAG_START : 0;
+        unsigned int flag = MsgIsStart(dblock->status_flag) ? MSG_FLAG_START : 0;
 
         ASSERT_GOTO(MsgIsNotLastData(dblock->status_flag), error);
         ASSERT_GOTO(session->send_data_bytes > header_bytes, error);
         ASSERT_GOTO(service_data != NULL, error);
 
+        /* the packet buffer stays queued until a direct region is sent,
+           so only offer it when the session owns no second buffer */
+        if (!MsgIsDoubleBuf(dblock->status_flag) && tcp_is_send_file_supported(connector_ptr))
+            MsgSetDirectData(flag);
+
         service_data->data_ptr = msg_buffer + header_bytes;
         service_data->length_in_bytes = session->send_data_bytes - header_bytes;
         service_data->flags = flag;
+        service_data->direct_bytes = 0;
         status = connector_working;
     }
 
@@ -1227,12 +1522,12 @@ STATIC connector_status_t msg_start_session(connector_data_t * const connector_p
 {
     connector_status_t status = connector_working;
     static connector_bool_t const client_owned = connector_true;
-    msg_session_t * const session = msg_create_session(connector_ptr, msg_ptr, msg_service_id_data, client_owned, &status);
+    msg_session_t * const session = msg_create_session(connector_ptr, msg_ptr, msg_service_id_data, client_owned, MSG_INVALID_CLIENT_SESSION, &status);
 
     if (session == NULL) goto error;
 
     {
-        connector_session_error_t const result = msg_initialize_data_block(session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_request);
+        connector_session_error_t const result = msg_initialize_data_block(connector_ptr, session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_request);
 
         status = msg_handle_pending_requests(connector_ptr, msg_ptr, session, result);
     }
@@ -1242,17 +1537,97 @@ error:
 }
 #endif
 
+/* Device Cloud may send available_window bytes past the last ack and the ack goes out once half
+ * of that arrived, so a window that is used up within a round trip is what holds the transfer back.
+ * Such a window is doubled. A window that carries less than a quarter of itself per round trip is
+ * halved, anything in between is kept. The window never leaves MSG_RECV_WINDOW_SIZE..limit.
+ */
+STATIC size_t msg_next_recv_window(size_t const window, size_t const bytes, unsigned long const elapsed_ms, unsigned long const rtt_ms, size_t const limit)
+{
+    size_t next = window;
+
+    if ((rtt_ms > 0) && (elapsed_ms > 0))
+    {
+        unsigned long const per_rtt = (bytes <= (ULONG_MAX / rtt_ms)) ? (bytes * rtt_ms) / elapsed_ms : (bytes / elapsed_ms) * rtt_ms;
+
+        if (per_rtt >= (window / 2))
+            next = 2 * window;
+        else if (per_rtt < (window / 4))
+            next = window / 2;
+    }
+
+    if (next > limit)
+        next = limit;
+    if (next < MSG_RECV_WINDOW_SIZE)
+        next = MSG_RECV_WINDOW_SIZE;
+
+    return next;
+}
+
+/* MSG_RECV_WINDOW_MAX bounds what all receiving sessions may have in flight together */
+STATIC size_t msg_recv_window_limit(connector_msg_data_t const * const msg_ptr)
+{
+    msg_session_t const * session;
+    size_t receiving = 0;
+
+    for (session = msg_ptr->session.head; session != NULL; session = session->next)
+    {
+        if ((session->in_dblock != NULL) && MsgIsReceiving(session->in_dblock->status_flag))
+            receiving++;
+    }
+
+    return (receiving > 1) ? MSG_RECV_WINDOW_MAX / receiving : MSG_RECV_WINDOW_MAX;
+}
+
+/* Smoothed round trip time, each new sample weighs 1/8 */
+STATIC unsigned long msg_next_rtt(unsigned long const rtt_ms, unsigned long const sample_ms)
+{
+    return (rtt_ms == 0) ? sample_ms : ((7 * rtt_ms) + sample_ms) / 8;
+}
+
+/* Data past probe_edge could only be sent once the ack sent at probe_time reached Device Cloud */
+STATIC connector_status_t msg_sample_rtt(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, msg_data_block_t * const dblock)
+{
+    connector_status_t status = connector_working;
+    unsigned long now;
+
+    if ((dblock->flow.probe_edge == 0) || (dblock->total_bytes <= dblock->flow.probe_edge))
+        goto done;
+
+    status = get_system_time_in_milliseconds(connector_ptr, &now);
+    if (status != connector_working)
+        goto done;
+
+    {
+        unsigned long const sample = (now > dblock->flow.probe_time) ? now - dblock->flow.probe_time : 1;
+
+        msg_ptr->rtt_ms = msg_next_rtt(msg_ptr->rtt_ms, sample);
+    }
+    dblock->flow.probe_edge = 0;
+
+done:
+    return status;
+}
+
 STATIC connector_status_t msg_send_ack(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, msg_session_t * const session)
 {
     connector_status_t status = connector_pending;
     uint8_t * ack_packet;
-    uint8_t * const edp_packet = tcp_get_packet_buffer(connector_ptr, E_MSG_FAC_MSG_NUM, &ack_packet, NULL);
     msg_data_block_t * const dblock = session->in_dblock;
+    unsigned long now;
+    uint8_t * edp_packet;
+
+    ASSERT_GOTO(dblock != NULL, error);
+
+    status = get_system_time_in_milliseconds(connector_ptr, &now);
+    if (status != connector_working)
+        goto done;
 
+    status = connector_pending;
+    edp_packet = tcp_get_packet_buffer(connector_ptr, E_MSG_FAC_MSG_NUM, &ack_packet, NULL);
     if (edp_packet == NULL)
         goto done;
 
-    ASSERT_GOTO(dblock != NULL, error);
     message_store_u8(ack_packet, opcode, msg_opcode_ack);
     {
         uint8_t const flag = MsgIsClientOwned(dblock->status_flag) ? 0 : MSG_FLAG_REQUEST;
@@ -1271,10 +1646,30 @@ STATIC connector_status_t msg_send_ack(connector_data_t * const connector_ptr, c
         message_store_be32(ack_packet, ack_count, val32);
     }
 
-    message_store_be32(ack_packet, window_size, msg_ptr->capabilities[msg_capability_client].window_size);
+    {
+        size_t const edge = dblock->ack_count + dblock->available_window;
+        size_t window = dblock->available_window;
+
+        if (dblock->flow.ack_time != 0)
+            window = msg_next_recv_window(window, dblock->total_bytes - dblock->ack_count, now - dblock->flow.ack_time,
+                                          msg_ptr->rtt_ms, msg_recv_window_limit(msg_ptr));
+
+        message_store_be32(ack_packet, window_size, (uint32_t)window);
+
+        status = tcp_initiate_send_facility_packet(connector_ptr, edp_packet, record_end(ack_packet),
+                                               E_MSG_FAC_MSG_NUM, tcp_release_packet_buffer, NULL);
+        if (status != connector_pending)
+        {
+            dblock->available_window = window;
+            dblock->flow.ack_time = now;
+            if (dblock->flow.probe_edge == 0)
+            {
+                dblock->flow.probe_edge = edge;
+                dblock->flow.probe_time = now;
+            }
+        }
+    }
 
-    status = tcp_initiate_send_facility_packet(connector_ptr, edp_packet, record_end(ack_packet),
-                                           E_MSG_FAC_MSG_NUM, tcp_release_packet_buffer, NULL);
     if (status != connector_pending)
     {
         dblock->ack_count = dblock->total_bytes;
@@ -1304,14 +1699,27 @@ STATIC connector_status_t msg_process_capabilities(connector_data_t * const conn
         int i;
 
         msg_fac->capabilities[msg_capability_cloud].compression_supported = connector_false;
+        #if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+        msg_fac->capabilities[msg_capability_cloud].dictionary_supported = connector_false;
+        #endif
         for (i = 0; i < comp_count; i++)
         {
             uint8_t const compression_id = *compression_list++;
 
-            if (compression_id == MSG_COMPRESSION_LIBZ)
+            switch (compression_id)
             {
-                msg_fac->capabilities[msg_capability_cloud].compression_supported = connector_true;
-                break;
+                case MSG_COMPRESSION_LIBZ:
+                    msg_fac->capabilities[msg_capability_cloud].compression_supported = connector_true;
+                    break;
+
+                #if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+                case MSG_COMPRESSION_LIBZ_DICT:
+                    msg_fac->capabilities[msg_capability_cloud].dictionary_supported = connector_true;
+                    break;
+                #endif
+
+                default:
+                    break;
             }
         }
     }
@@ -1374,7 +1782,7 @@ STATIC connector_status_t msg_pass_service_data(connector_data_t * const connect
                 ASSERT_GOTO(msg_ptr != NULL, error);
                 if (MsgIsDoubleBuf(dblock->status_flag) == connector_false)
                 {
-                    result = msg_initialize_data_block(session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_response);
+                    result = msg_initialize_data_block(connector_ptr, session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_response);
                     if (result != connector_session_error_none)
                         status = msg_inform_error(connector_ptr, session, result);
                 }
@@ -1389,7 +1797,13 @@ STATIC connector_status_t msg_pass_service_data(connector_data_t * const connect
         }
         else
         {
+            connector_msg_data_t * const msg_ptr = get_facility_data(connector_ptr, E_MSG_FAC_MSG_NUM);
+
+            ASSERT_GOTO(msg_ptr != NULL, error);
             dblock->total_bytes += bytes;
+            status = msg_sample_rtt(connector_ptr, msg_ptr, dblock);
+            if (status != connector_working)
+                goto error;
 
             if ((dblock->total_bytes - dblock->ack_count) > (dblock->available_window/2))
             {
@@ -1434,7 +1848,7 @@ STATIC connector_status_t msg_process_decompressed_data(connector_data_t * const
         dblock->bytes_out = 0;
         if (session->current_state != msg_state_get_data)
         {
-            if (dblock->zlib.avail_out == 0)
+            if (dblock->zlib->avail_out == 0)
                 session->current_state = msg_state_decompress;
             else
             {
@@ -1460,7 +1874,7 @@ STATIC connector_status_t msg_decompress_data(connector_data_t * const connector
     z_streamp zlib_ptr;
 
     ASSERT_GOTO(dblock != NULL, error);
-    zlib_ptr = &dblock->zlib;
+    zlib_ptr = dblock->zlib;
 
     if (zlib_ptr->avail_out == 0)
     {
@@ -1469,7 +1883,7 @@ STATIC connector_status_t msg_decompress_data(connector_data_t * const connector
     }
 
     {
-        int const zret = inflate(zlib_ptr, Z_NO_FLUSH);
+        int const zret = zlib_inflate(zlib_ptr, Z_NO_FLUSH);
 
         session->current_state = MsgIsAckPending(dblock->status_flag) ? msg_state_send_ack : msg_state_receive;
         switch(zret)
@@ -1512,7 +1926,7 @@ STATIC connector_status_t msg_process_compressed_data(connector_data_t * const c
     z_streamp zlib_ptr;
 
     ASSERT_GOTO(dblock != NULL, error);
-    zlib_ptr = &dblock->zlib;
+    zlib_ptr = dblock->zlib;
 
     if (zlib_ptr->avail_in > 0)
     {
@@ -1587,7 +2001,7 @@ STATIC connector_status_t msg_process_start(connector_data_t * const connector_p
              goto error;
         }
 
-        session = msg_create_session(connector_ptr, msg_ptr, service_id, client_owned, &status);
+        session = msg_create_session(connector_ptr, msg_ptr, service_id, client_owned, session_id, &status);
         if (session == NULL)
         {
             switch (status)
@@ -1605,15 +2019,14 @@ STATIC connector_status_t msg_process_start(connector_data_t * const connector_p
             goto error;
         }
 
-        session->session_id = session_id;
         if (session->out_dblock != NULL)
         {
-            result = msg_initialize_data_block(session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_response);
+            result = msg_initialize_data_block(connector_ptr, session, msg_ptr->capabilities[msg_capability_cloud].window_size, msg_block_state_send_response);
             if (result != connector_session_error_none)
                 goto error;
         }
 
-        result = msg_initialize_data_block(session, msg_ptr->capabilities[msg_capability_client].window_size, msg_block_state_recv_request);
+        result = msg_initialize_data_block(connector_ptr, session, msg_ptr->capabilities[msg_capability_client].window_size, msg_block_state_recv_request);
         if (result != connector_session_error_none)
             goto error;
     }
@@ -1624,7 +2037,7 @@ STATIC connector_status_t msg_process_start(connector_data_t * const connector_p
 
         if (client_owned)
         {
-            result = msg_initialize_data_block(session, msg_ptr->capabilities[msg_capability_client].window_size, msg_block_state_recv_response);
+            result = msg_initialize_data_block(connector_ptr, session, msg_ptr->capabilities[msg_capability_client].window_size, msg_block_state_recv_response);
             if (result != connector_session_error_none)
                 goto error;
         }
@@ -1766,14 +2179,173 @@ STATIC connector_status_t msg_discovery(connector_data_t * const connector_ptr,
     return msg_send_capabilities(connector_ptr, facility_data, capability_flag);
 }
 
-STATIC void msg_switch_session(connector_msg_data_t * const msg_ptr, msg_session_t * const session)
+/* Sessions with nothing to do until Device Cloud or the transport answers */
+STATIC connector_bool_t msg_session_is_ready(connector_msg_data_t const * const msg_ptr, msg_session_t const * const session)
 {
-    if (!msg_ptr->session_locked)
+    connector_bool_t ready;
+
+    switch (session->current_state)
     {
-        msg_ptr->session_locked = connector_true;
-        msg_ptr->session.current = (session->prev != NULL) ? session->prev : msg_ptr->session.tail;
-        msg_ptr->session_locked = connector_false;
+    case msg_state_init:
+    case msg_state_receive:
+    case msg_state_wait_send_complete:
+        ready = connector_false;
+        break;
+
+    case msg_state_get_data:
+        ready = connector_bool((session->out_dblock == NULL) || !MsgIsAckPending(session->out_dblock->status_flag));
+        break;
+
+    default:
+        ready = connector_true;
+        break;
+    }
+
+    /* a session that returned pending gets another try on the next step */
+    if (session->schedule.blocked_step == msg_ptr->scheduler.step)
+        ready = connector_false;
+
+    return ready;
+}
+
+/* Weighted round robin over the priority classes: each class with ready sessions runs up to its
+ * weight in session steps per round, higher classes first. Within a class the session served
+ * longest ago goes next. Also marks when each session became ready to measure queueing delay.
+ */
+STATIC msg_session_t * msg_schedule_session(connector_msg_data_t * const msg_ptr, unsigned long const now)
+{
+    static unsigned int const weight[msg_priority_count] =
+    {
+        MSG_PRIORITY_WEIGHT_INTERACTIVE,
+        MSG_PRIORITY_WEIGHT_NORMAL,
+        MSG_PRIORITY_WEIGHT_BULK
+    };
+    msg_session_t * candidate[msg_priority_count];
+    msg_session_t * session = NULL;
+    msg_session_t * ptr;
+    connector_bool_t any_ready = connector_false;
+    int priority;
+    int round;
+
+    for (priority = 0; priority < msg_priority_count; priority++)
+        candidate[priority] = NULL;
+
+    for (ptr = msg_ptr->session.head; ptr != NULL; ptr = ptr->next)
+    {
+        if (!msg_session_is_ready(msg_ptr, ptr))
+        {
+            ptr->schedule.queued = connector_false;
+            continue;
+        }
+
+        if (!ptr->schedule.queued)
+        {
+            ptr->schedule.queued = connector_true;
+            ptr->schedule.ready_since = now;
+        }
+
+        {
+            msg_session_t * const best = candidate[ptr->schedule.priority];
+
+            if ((best == NULL) || (ptr->schedule.serial < best->schedule.serial))
+                candidate[ptr->schedule.priority] = ptr;
+        }
+        any_ready = connector_true;
+    }
+
+    if (!any_ready)
+        goto done;
+
+    for (round = 0; round < 2; round++)
+    {
+        for (priority = 0; priority < msg_priority_count; priority++)
+        {
+            if ((candidate[priority] != NULL) && (msg_ptr->scheduler.credit[priority] > 0))
+            {
+                msg_ptr->scheduler.credit[priority]--;
+                session = candidate[priority];
+                goto done;
+            }
+        }
+
+        /* every class with work used up its share, start a new round */
+        for (priority = 0; priority < msg_priority_count; priority++)
+            msg_ptr->scheduler.credit[priority] = weight[priority];
     }
+
+done:
+    return session;
+}
+
+STATIC void msg_record_delay(connector_msg_data_t * const msg_ptr, msg_session_t * const session, unsigned long const now)
+{
+    msg_priority_stats_t * const stats = &msg_ptr->scheduler.stats[session->schedule.priority];
+    unsigned long const delay = now - session->schedule.ready_since;
+
+    stats->served++;
+    stats->delay_total_ms += delay;
+    if (delay > stats->delay_max_ms)
+        stats->delay_max_ms = delay;
+
+    session->schedule.queued = connector_false;
+    session->schedule.serial = ++msg_ptr->scheduler.serial;
+}
+
+STATIC connector_status_t msg_run_session(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, msg_session_t * const session)
+{
+    connector_status_t status = connector_working;
+
+    switch (session->current_state)
+    {
+    case msg_state_get_data:
+        session->saved_state = msg_state_get_data;
+        status = msg_get_service_data(connector_ptr, session);
+        break;
+
+    case msg_state_send_data:
+        status = msg_send_data(connector_ptr, session);
+        break;
+
+    #if (defined CONNECTOR_COMPRESSION)
+    case msg_state_compress:
+        status = msg_compress_data(connector_ptr, session);
+        break;
+
+    case msg_state_decompress:
+        status = msg_decompress_data(connector_ptr, session);
+        break;
+
+    case msg_state_process_decompressed:
+        status = msg_process_decompressed_data(connector_ptr, session);
+        break;
+    #endif
+
+    case msg_state_send_ack:
+        status = msg_send_ack(connector_ptr, msg_ptr, session);
+        break;
+
+    case msg_state_send_error:
+    {
+        uint8_t const flag = (uint8_t)session->error_flag;
+        uint16_t const session_id = (uint16_t)session->session_id;
+
+        status = msg_send_error(connector_ptr, msg_ptr, session, session_id, session->error, flag);
+        break;
+    }
+
+    case msg_state_delete:
+        status = msg_delete_session(connector_ptr, msg_ptr, session);
+        break;
+
+    default:
+        status = connector_init_error;
+        connector_debug_line("Failed %X, state %d", session, session->current_state);
+        ASSERT_GOTO(connector_false, done);
+        break;
+    }
+
+done:
+    return status;
 }
 
 STATIC connector_status_t msg_process_pending(connector_data_t * const connector_ptr, connector_msg_data_t * const msg_ptr, unsigned int * const receive_timeout)
@@ -1791,87 +2363,75 @@ STATIC connector_status_t msg_process_pending(connector_data_t * const connector
 #endif
 
 #if (defined CONNECTOR_DATA_POINTS)
-    status = dp_process_request(connector_ptr, connector_transport_tcp);
-    if ((status != connector_idle) && (status != connector_working))
-        goto done;
-#endif
+    {
+        size_t count = 0;
 
-    msg_ptr->session_locked = connector_true;
-    if (msg_ptr->session.current == NULL)
-        msg_ptr->session.current = msg_ptr->session.tail;
-    msg_ptr->session_locked = connector_false;
+        /* start a session for each queued data point until the transaction limit is reached */
+        do
+        {
+            status = dp_process_request(connector_ptr, connector_transport_tcp);
+            if ((status != connector_idle) && (status != connector_working))
+                goto done;
+
+            if (msg_ptr->pending_service_request.internal == NULL)
+                break;
+
+            status = msg_start_session(connector_ptr, msg_ptr);
+            if (status != connector_working) goto done;
+        } while (++count < CONNECTOR_DATA_POINT_QUEUE_SIZE);
+    }
+#endif
 
     *receive_timeout = MAX_RECEIVE_TIMEOUT_IN_SECONDS;
-    if (msg_ptr->session.current != NULL)
+    if (msg_ptr->session.head != NULL)
     {
-        msg_session_t * const session = msg_ptr->session.current;
-
-        status = connector_working;
+        /* a session runs at most a handful of states per frame, this only bounds a session stuck in one */
+        unsigned int const max_runs = (4 * msg_ptr->session.count) + 1;
+        connector_bool_t blocked = connector_false;
+        connector_bool_t progress = connector_false;
+        unsigned long now;
+        unsigned int runs;
 
         *receive_timeout = MIN_RECEIVE_TIMEOUT_IN_SECONDS;
-        switch (session->current_state)
-        {
-        case msg_state_init:
-        case msg_state_receive:
-        case msg_state_wait_send_complete:
-            msg_switch_session(msg_ptr, session);
-            break;
 
-        case msg_state_get_data:
-            if ((session->out_dblock != NULL) && MsgIsAckPending(session->out_dblock->status_flag))
-            {
-                msg_switch_session(msg_ptr, session);
-            }
-            else
-            {
-                session->saved_state = msg_state_get_data;
-                status = msg_get_service_data(connector_ptr, session);
-                if (status == connector_pending)
-                    msg_switch_session(msg_ptr, session);
-            }
-            break;
+        status = get_system_time_in_milliseconds(connector_ptr, &now);
+        if (status != connector_working) goto done;
 
-        case msg_state_send_data:
-            status = msg_send_data(connector_ptr, session);
-            break;
+        msg_ptr->scheduler.step++;
 
-        #if (defined CONNECTOR_COMPRESSION)
-        case msg_state_compress:
-            status = msg_compress_data(connector_ptr, session);
-            break;
+        /* keep running sessions while the EDP send queue has room for their frames */
+        for (runs = 0; (runs < max_runs) && !tcp_is_send_queue_full(connector_ptr); runs++)
+        {
+            msg_session_t * const session = msg_schedule_session(msg_ptr, now);
+            connector_status_t result;
+            msg_state_t state;
 
-        case msg_state_decompress:
-            status = msg_decompress_data(connector_ptr, session);
-            break;
+            if (session == NULL)
+                break;
 
-        case msg_state_process_decompressed:
-            status = msg_process_decompressed_data(connector_ptr, session);
-            break;
-        #endif
+            msg_record_delay(msg_ptr, session, now);
+            state = session->current_state;
+            result = msg_run_session(connector_ptr, msg_ptr, session);
 
-        case msg_state_send_ack:
-            status = msg_send_ack(connector_ptr, msg_ptr, session);
-            break;
+            /* a session in msg_state_delete is freed whatever the result */
+            if ((result == connector_pending) && (state != msg_state_delete))
+            {
+                session->schedule.blocked_step = msg_ptr->scheduler.step;
+                blocked = connector_true;
+                continue;
+            }
 
-        case msg_state_send_error:
-        {
-            uint8_t const flag = (uint8_t)session->error_flag;
-            uint16_t const session_id = (uint16_t)session->session_id;
+            if ((result != connector_working) && (result != connector_pending))
+            {
+                status = result;
+                goto done;
+            }
 
-            status = msg_send_error(connector_ptr, msg_ptr, session, session_id, session->error, flag);
-            break;
+            progress = connector_true;
         }
 
-        case msg_state_delete:
-            status = msg_delete_session(connector_ptr, msg_ptr, session);
-            break;
-
-        default:
-            status = connector_init_error;
-            connector_debug_line("Failed %X, state %d", session, session->current_state);
-            ASSERT_GOTO(connector_false, done);
-            break;
-        }
+        if (blocked && !progress)
+            status = connector_pending;
     }
 
 done:
@@ -2006,7 +2566,31 @@ STATIC connector_status_t msg_delete_facility(connector_data_t * const connector
             }
         }
 
-        status = is_empty == connector_true ? del_facility_data(connector_ptr, E_MSG_FAC_MSG_NUM) : connector_working;
+        status = connector_working;
+        if (is_empty == connector_true)
+        {
+#if (defined CONNECTOR_DEBUG)
+            static char const * const class_name[msg_priority_count] = {"interactive", "normal", "bulk"};
+            int priority;
+
+            for (priority = 0; priority < msg_priority_count; priority++)
+            {
+                msg_priority_stats_t const * const stats = &msg_ptr->scheduler.stats[priority];
+
+                if (stats->served > 0)
+                    connector_debug_line("msg %s sessions: %lu steps, queueing delay avg %lu ms, max %lu ms", class_name[priority],
+                                         stats->served, stats->delay_total_ms / stats->served, stats->delay_max_ms);
+            }
+#endif
+            if (msg_ptr->session.table != NULL)
+            {
+                status = free_data_buffer(connector_ptr, named_buffer_id(msg_session_table), msg_ptr->session.table);
+                msg_ptr->session.table = NULL;
+                msg_ptr->session.table_size = 0;
+                if (status != connector_working) goto error;
+            }
+            status = del_facility_data(connector_ptr, E_MSG_FAC_MSG_NUM);
+        }
     }
 
 error:
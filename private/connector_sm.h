@@ -196,6 +196,7 @@ STATIC connector_status_t sm_initialize(connector_data_t * const connector_ptr,
             sm_ptr->network.class_id = connector_class_id_network_udp;
             sm_ptr->network.transport = connector_transport_udp;
             sm_ptr->transport.mtu = SM_PACKET_SIZE_UDP;
+            sm_ptr->network.recv_queue.slots = SM_RECV_BATCH_SIZE;
             sm_ptr->transport.sm_mtu_tx = sm_ptr->transport.mtu - (sm_ptr->transport.id_length + sm_udp_version_length);
             sm_ptr->transport.sm_mtu_rx = sm_ptr->transport.sm_mtu_tx;
             break;
@@ -236,6 +237,7 @@ STATIC connector_status_t sm_initialize(connector_data_t * const connector_ptr,
             sm_ptr->network.class_id = connector_class_id_network_sms;
             sm_ptr->network.transport = connector_transport_sms;
             sm_ptr->transport.mtu = SM_PACKET_SIZE_SMS_ENCODED;
+            sm_ptr->network.recv_queue.slots = 1;
             {
                 if ((sm_ptr->transport.id != NULL) && (sm_ptr->transport.id_length > 0))
                 {
@@ -276,6 +278,9 @@ STATIC connector_status_t sm_initialize(connector_data_t * const connector_ptr,
     sm_ptr->session.active_cloud_sessions = 0;
 
     sm_ptr->network.handle = CONNECTOR_NETWORK_HANDLE_NOT_INITIALIZED;
+    sm_ptr->network.send_queue.count = 0;
+    sm_ptr->network.recv_queue.count = 0;
+    sm_ptr->network.recv_queue.processed = 0;
     sm_ptr->close.status = connector_close_status_device_error;
     sm_ptr->close.callback_needed = connector_true;
     sm_ptr->close.stop_condition = connector_stop_immediately;
@@ -629,10 +634,49 @@ STATIC connector_status_t sm_initiate_action(connector_handle_t const handle, co
                         goto error;
                     }
                     request_id = get_request_id_ptr(request, request_data);
-                    /* dp_initiate_data_point() and dp_initiate_data_point_binary() convert a connector_initiate_data_point or  
+
+#if (defined CONNECTOR_DATA_POINTS)
+                    switch (request)
+                    {
+                        case connector_initiate_data_point:
+                        case connector_initiate_data_point_binary:
+                            /* Queued data points get their request_id now, the "hidden"
+                             * connector_initiate_send_data started later by dp_send_message()
+                             * reuses it (see pending_internal below). A full queue takes no id.
+                             */
+                            if (!dp_queue_has_room(connector_ptr, *transport_ptr))
+                            {
+                                result = connector_service_busy;
+                                goto done_datapoints;
+                            }
+
+                            if (request_id != NULL)
+                            {
+                                result = sm_get_request_id(connector_ptr, sm_ptr);
+                                ASSERT_GOTO(result == connector_working, error);
+                                *request_id = connector_ptr->last_request_id;
+                            }
+
+                            if (request == connector_initiate_data_point)
+                                result = dp_initiate_data_point(connector_ptr, request_data);
+                            else
+                                result = dp_initiate_data_point_binary(connector_ptr, request_data);
+                            goto done_datapoints;
+
+                        default:
+                            break;
+                    }
+#endif
+                    if (sm_ptr->pending.data != NULL)
+                    {
+                        result = connector_service_busy;
+                        goto error;
+                    }
+
+                    /* dp_send_message() converts a queued connector_initiate_data_point or
                      * connector_initiate_data_point_binary to a connector_initiate_send_data,
                      * but we want that that "hidden" connector_initiate_send_data
-                     * use the same request_id, which has been already set by dp_send_message().
+                     * use the same request_id, which has been already set above.
                      * */
                     if (sm_ptr->pending.pending_internal)
                     {
@@ -660,31 +704,6 @@ STATIC connector_status_t sm_initiate_action(connector_handle_t const handle, co
                             *request_id = sm_ptr->pending.request_id;
                     }
 
-#if (defined CONNECTOR_DATA_POINTS)
-                    switch (request)
-                    {
-                        case connector_initiate_data_point:
-                        {
-                            sm_ptr->pending.pending_internal = connector_true;
-                            result = dp_initiate_data_point(request_data);
-                            goto done_datapoints;
-                        }
-                        case connector_initiate_data_point_binary:
-                        {
-                            sm_ptr->pending.pending_internal = connector_true;
-                            result = dp_initiate_data_point_binary(request_data);
-                            goto done_datapoints;
-                        }
-
-                        default:
-                            break;
-                    }
-#endif
-                    if (sm_ptr->pending.data != NULL)
-                    {
-                        result = connector_service_busy;
-                        goto error;
-                    }
                     sm_ptr->pending.data = request_data;
                     sm_ptr->pending.request = request;
                     break;
@@ -715,7 +734,6 @@ STATIC void sm_init_network_packet(connector_sm_packet_t * const packet, void *
     packet->data = ptr;
     packet->total_bytes = 0;
     packet->processed_bytes = 0;
-    packet->pending_session = NULL;
 }
 
 STATIC connector_status_t sm_open_transport(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
@@ -770,7 +788,7 @@ STATIC connector_status_t sm_open_transport(connector_data_t * const connector_p
 
     {
         void * data_ptr;
-        size_t const data_size = 2 * sm_ptr->transport.mtu;
+        size_t const data_size = (1 + sm_ptr->network.recv_queue.slots) * sm_ptr->transport.mtu;
 
         result = malloc_data_buffer(connector_ptr, data_size, named_buffer_id(sm_packet), &data_ptr);
         ASSERT_GOTO(result == connector_working, error);
@@ -782,6 +800,15 @@ STATIC connector_status_t sm_open_transport(connector_data_t * const connector_p
             sm_init_network_packet(&sm_ptr->network.send_packet, send_data_ptr);
             sm_init_network_packet(&sm_ptr->network.recv_packet, recv_data_ptr);
         }
+
+        sm_ptr->network.recv_queue.data = sm_ptr->network.recv_packet.data;
+        sm_ptr->network.recv_queue.count = 0;
+        sm_ptr->network.recv_queue.processed = 0;
+        sm_ptr->network.recv_queue.batch_unsupported = connector_false;
+
+        sm_ptr->network.send_queue.count = 0;
+        sm_ptr->network.send_queue.processed_bytes = 0;
+        sm_ptr->network.send_queue.batch_unsupported = connector_false;
     }
 
 error:
@@ -828,6 +855,9 @@ STATIC connector_status_t sm_close_transport(connector_data_t * const connector_
         sm_ptr->network.handle = CONNECTOR_NETWORK_HANDLE_NOT_INITIALIZED;
     }
 
+    sm_ptr->network.send_queue.count = 0;
+    sm_ptr->network.recv_queue.count = 0;
+    sm_ptr->network.recv_queue.processed = 0;
     if (sm_ptr->network.send_packet.data != NULL)
     {
         if (free_data_buffer(connector_ptr, named_buffer_id(sm_packet), sm_ptr->network.send_packet.data) == connector_abort)
@@ -891,9 +921,27 @@ STATIC connector_status_t sm_state_machine(connector_data_t * const connector_pt
         goto done;
 
 #if (defined CONNECTOR_DATA_POINTS)
-    result = dp_process_request(connector_ptr, sm_ptr->network.transport);
-    if ((result != connector_idle) && (result != connector_working))
-        goto error;
+    {
+        size_t count = 0;
+
+        /* start a session for each queued data point until the session limit is reached */
+        do
+        {
+            result = dp_process_request(connector_ptr, sm_ptr->network.transport);
+            if ((result != connector_idle) && (result != connector_working))
+                goto error;
+
+            if (sm_ptr->pending.data == NULL)
+                break;
+
+            result = sm_process_pending_data(connector_ptr, sm_ptr);
+            if (result != connector_working)
+                break;
+        } while (++count < CONNECTOR_DATA_POINT_QUEUE_SIZE);
+
+        if ((result != connector_idle) && (result != connector_pending) && (result != connector_working))
+            goto done;
+    }
 #endif
 
     while (iterations > 0)
@@ -1002,6 +1050,12 @@ STATIC connector_status_t sm_state_machine(connector_data_t * const connector_pt
 
                 } while (session != NULL);
 
+                /* every session had its turn, flush the segments queued for a batch */
+                result = sm_send_segments(connector_ptr, sm_ptr);
+                sm_verify_result(sm_ptr, &result);
+                if ((result == connector_working) || (result == connector_pending))
+                    goto done;
+
                 iterations--;
                 break;
             }
@@ -1025,17 +1079,17 @@ STATIC connector_status_t sm_state_machine(connector_data_t * const connector_pt
 #else
                     connector_debug_line("Waiting %d second before reconnecting SM transport SMS", CONNECTOR_TRANSPORT_RECONNECT_AFTER);
 #endif
-                    result = get_system_time(connector_ptr, &sm_ptr->transport.connect_at);
+                    result = get_system_time_in_milliseconds(connector_ptr, &sm_ptr->transport.connect_at);
                     if (result != connector_working)
                         goto done;
-                    sm_ptr->transport.connect_at += CONNECTOR_TRANSPORT_RECONNECT_AFTER;
+                    sm_ptr->transport.connect_at += CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS;
                 } else {
                     unsigned long int uptime;
 
-                    result = get_system_time(connector_ptr, &uptime);
+                    result = get_system_time_in_milliseconds(connector_ptr, &uptime);
                     if (result != connector_working)
                         goto done;
-                    if (uptime >= sm_ptr->transport.connect_at)
+                    if (is_reconnect_due(uptime, sm_ptr->transport.connect_at))
                         sm_ptr->transport.state = connector_transport_open;
                 }
                 break;
@@ -1064,3 +1118,31 @@ STATIC connector_status_t connector_sms_step(connector_data_t * const connector_
     return sm_state_machine(connector_ptr, &connector_ptr->sm_sms);
 }
 #endif
+
+STATIC void sm_next_timeout(connector_sm_data_t * const sm_ptr, unsigned long const uptime, unsigned long * const timeout)
+{
+    switch (sm_ptr->transport.state)
+    {
+        case connector_transport_wait_for_reconnect:
+            next_timeout_update(uptime, sm_ptr->transport.connect_at - CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS, CONNECTOR_TRANSPORT_RECONNECT_AFTER_IN_MILLISECONDS, timeout);
+            break;
+
+        case connector_transport_idle:
+        case connector_transport_close:
+        case connector_transport_terminate:
+            break;
+
+        default:
+        {
+            connector_sm_session_t const * session;
+
+            /* receive timeout, see sm_process_recv_path() */
+            for (session = sm_ptr->session.head; session != NULL; session = session->next)
+            {
+                if (session->sm_state == connector_sm_state_receive_data && session->timeout_in_seconds != SM_WAIT_FOREVER)
+                    next_timeout_update(uptime, session->start_time, session->timeout_in_seconds * UINT32_C(1000) + 1, timeout);
+            }
+            break;
+        }
+    }
+}
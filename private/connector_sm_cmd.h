@@ -129,6 +129,7 @@ STATIC size_t sm_get_max_payload_bytes(connector_sm_data_t * const sm_ptr)
 }
 #endif
 
+/* The buffer starts SM_SEGMENT_HEADROOM bytes in, so sm_send_data() can build each segment in place */
 STATIC connector_status_t sm_allocate_user_buffer(connector_data_t * const connector_ptr, sm_data_block_t * const dblock)
 {
     void * ptr = NULL;
@@ -137,7 +138,9 @@ STATIC connector_status_t sm_allocate_user_buffer(connector_data_t * const conne
     if (dblock->bytes > 0)
     {
         ASSERT(dblock->data == NULL);
-        result = malloc_data_buffer(connector_ptr, dblock->bytes, named_buffer_id(sm_data_block), &ptr);
+        result = malloc_data_buffer(connector_ptr, dblock->bytes + SM_SEGMENT_HEADROOM, named_buffer_id(sm_data_block), &ptr);
+        if (result == connector_working)
+            ptr = (uint8_t *)ptr + SM_SEGMENT_HEADROOM;
     }
 
     dblock->data = ptr;
@@ -145,6 +148,19 @@ STATIC connector_status_t sm_allocate_user_buffer(connector_data_t * const conne
     return result;
 }
 
+STATIC connector_status_t sm_free_user_buffer(connector_data_t * const connector_ptr, sm_data_block_t * const dblock)
+{
+    connector_status_t result = connector_working;
+
+    if (dblock->data != NULL)
+    {
+        result = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), dblock->data - SM_SEGMENT_HEADROOM);
+        dblock->data = NULL;
+    }
+
+    return result;
+}
+
 STATIC connector_status_t sm_map_callback_status_to_connector_status(connector_callback_status_t const callback_status)
 {
     connector_status_t result;
@@ -335,11 +351,10 @@ done:
 
     if (session->in.data != NULL)
     {
-        if (free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->in.data) != connector_working)
+        if (sm_free_user_buffer(connector_ptr, &session->in) != connector_working)
             result = connector_abort;
 
         session->in.bytes = 0;
-        session->in.data = NULL;
     }
 
     return result;
@@ -351,11 +366,10 @@ STATIC connector_status_t sm_switch_path(connector_data_t * const connector_ptr,
 
     if (session->in.data != NULL)
     {
-        result = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->in.data);
+        result = sm_free_user_buffer(connector_ptr, &session->in);
         if (result != connector_working) goto error;
 
         session->in.bytes = 0;
-        session->in.data = NULL;
     }
 
     if (SmIsResponseNeeded(session->flags))
@@ -710,7 +724,7 @@ STATIC connector_status_t sm_process_config_request(connector_data_t * const con
                     SmSetSmsConfigInit(session->flags);
                     sm_ptr->network.handle = CONNECTOR_NETWORK_HANDLE_NOT_INITIALIZED;
 
-                    if (get_system_time(connector_ptr, &uptime) == connector_working)
+                    if (get_system_time_in_milliseconds(connector_ptr, &uptime) == connector_working)
                     {
                         sm_ptr->transport.connect_at = uptime;
                         sm_ptr->transport.state = connector_transport_wait_for_reconnect;
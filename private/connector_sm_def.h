@@ -142,7 +142,6 @@ typedef enum
     connector_sm_state_more_data,
     connector_sm_state_compress,
     connector_sm_state_prepare_segment,
-    connector_sm_state_encoding,
     connector_sm_state_send_data,
     connector_sm_state_receive_data,
     connector_sm_state_decompress,
@@ -191,7 +190,7 @@ typedef struct connector_sm_session_t
 #if (defined CONNECTOR_COMPRESSION)
     struct
     {
-        z_stream zlib;
+        z_streamp zlib;
         sm_data_block_t out;
     } compress;
 #endif
@@ -213,9 +212,50 @@ typedef struct connector_sm_packet_t
     uint8_t * data;
     size_t total_bytes;
     size_t processed_bytes;
-    connector_sm_session_t * pending_session;
 } connector_sm_packet_t;
 
+/* Segments waiting to go out, at most one per session. Each one is a complete datagram,
+   either built in front of its payload inside the session buffer or in send_packet. */
+#if !(defined SM_SEND_BATCH_SIZE)
+#define SM_SEND_BATCH_SIZE 8
+#endif
+
+typedef struct
+{
+    uint8_t * data;
+    size_t bytes;
+    connector_sm_session_t * session;
+} connector_sm_segment_t;
+
+typedef struct
+{
+    connector_sm_segment_t segment[SM_SEND_BATCH_SIZE];
+    size_t count;
+    size_t processed_bytes;
+    connector_bool_t batch_unsupported;
+} connector_sm_send_queue_t;
+
+/* Datagrams read by one receive callback. They sit one transport MTU apart after send_packet
+   and are handed to the SM layer one by one through recv_packet. Only UDP reads more than one. */
+#if (defined CONNECTOR_TRANSPORT_UDP)
+#if !(defined SM_RECV_BATCH_SIZE)
+#define SM_RECV_BATCH_SIZE 4
+#endif
+#else
+#undef SM_RECV_BATCH_SIZE
+#define SM_RECV_BATCH_SIZE 1
+#endif
+
+typedef struct
+{
+    uint8_t * data;
+    size_t bytes[SM_RECV_BATCH_SIZE];
+    size_t slots;
+    size_t count;
+    size_t processed;
+    connector_bool_t batch_unsupported;
+} connector_sm_recv_queue_t;
+
 typedef struct connector_sm_data_t
 {
     connector_status_t error_code;
@@ -245,7 +285,9 @@ typedef struct connector_sm_data_t
     struct
     {
         connector_sm_packet_t send_packet;
+        connector_sm_send_queue_t send_queue;
         connector_sm_packet_t recv_packet;
+        connector_sm_recv_queue_t recv_queue;
         connector_network_handle_t * handle;
         connector_class_id_t class_id;
         connector_transport_t transport;
@@ -301,4 +343,8 @@ enum sm_segmentn_t
     record_end(segmentn)
 };
 
+/* Bytes reserved in front of every session buffer, enough for the UDP preamble (version
+   and Device ID) and the largest segment header. Kept a multiple of 4 for alignment. */
+#define SM_SEGMENT_HEADROOM ((((1 + DEVICE_ID_LENGTH + record_end(segment0)) + 3) / 4) * 4)
+
 #endif
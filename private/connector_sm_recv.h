@@ -503,74 +503,87 @@ error:
     return result;
 }
 
-STATIC connector_status_t sm_receive_data(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+#if (defined CONNECTOR_TRANSPORT_UDP)
+STATIC connector_callback_status_t sm_receive_batch(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
 {
-    connector_status_t result = connector_pending;
-    connector_sm_packet_t * const recv_ptr = &sm_ptr->network.recv_packet;
+    connector_sm_recv_queue_t * const queue = &sm_ptr->network.recv_queue;
     connector_callback_status_t status;
     connector_request_id_t request_id;
-    connector_network_receive_t read_data;
-
-    if (recv_ptr->total_bytes > 0) goto done;
+    connector_network_receive_batch_t read_data;
 
     read_data.handle = sm_ptr->network.handle;
-    read_data.buffer = recv_ptr->data;
-    read_data.bytes_available = sm_ptr->transport.mtu;
-    read_data.bytes_used = 0;
+    read_data.buffer = queue->data;
+    read_data.slot_size = sm_ptr->transport.mtu;
+    read_data.slot_count = queue->slots;
+    read_data.bytes_used = queue->bytes;
+    read_data.slots_used = 0;
 
-    request_id.network_request = connector_request_id_network_receive;
+    request_id.network_request = connector_request_id_network_receive_batch;
     status = connector_callback(connector_ptr->callback, sm_ptr->network.class_id, request_id, &read_data, connector_ptr->context);
-    ASSERT(status != connector_callback_unrecognized);
     switch (status)
     {
-        case connector_callback_busy:
-            result = connector_idle;
-            goto done;
-
         case connector_callback_continue:
-            recv_ptr->total_bytes = read_data.bytes_used;
-            recv_ptr->processed_bytes = 0;
+            ASSERT(read_data.slots_used <= queue->slots);
+            queue->count = (read_data.slots_used <= queue->slots) ? read_data.slots_used : queue->slots;
+            if (queue->count == 0)
+                status = connector_callback_busy;
+            break;
 
-            switch (sm_ptr->network.transport)
-            {
-                #if (defined CONNECTOR_TRANSPORT_SMS)
-                case connector_transport_sms:
-                    result = sm_verify_sms_preamble(sm_ptr);
-                    switch(result)
-                    {
-                        case connector_working:
-                            break;
-                        case connector_invalid_response:
-                            /* not Device Cloud packet? Ignore the packet */
-                            recv_ptr->total_bytes = 0;
-                            recv_ptr->processed_bytes = 0;
-                            result = connector_working;
-                            goto done;
-                        default:
-                            goto done;
-                    }
-
-                    result = sm_decode_segment(connector_ptr, recv_ptr);
-
-                    /* Remove sms preamble */
-                    sm_ptr->network.recv_packet.processed_bytes = 0;
+        case connector_callback_unrecognized:
+            connector_debug_line("sm_receive_batch: receive_batch not supported, receiving one datagram at a time");
+            queue->batch_unsupported = connector_true;
+            break;
 
-                    break;
-                #endif
+        default:
+            break;
+    }
 
-                #if (defined CONNECTOR_TRANSPORT_UDP)
-                case connector_transport_udp:
-                    result = sm_verify_udp_header(sm_ptr);
-                    break;
-                #endif
+    return status;
+}
+#endif
 
-                default:
-                    ASSERT_GOTO(connector_false, done);
-                    break;
-            }
+/* Fill the receive queue with whatever the platform has ready, one callback call whatever the slot count */
+STATIC connector_status_t sm_receive_datagrams(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_working;
+    connector_sm_recv_queue_t * const queue = &sm_ptr->network.recv_queue;
+    connector_callback_status_t status = connector_callback_unrecognized;
+
+    queue->count = 0;
+    queue->processed = 0;
 
-            if(result != connector_working) goto done; /* not Device Cloud packet? */
-                result = sm_process_packet(connector_ptr, sm_ptr);
+    #if (defined CONNECTOR_TRANSPORT_UDP)
+    if ((sm_ptr->network.transport == connector_transport_udp) && (queue->slots > 1) && !queue->batch_unsupported)
+        status = sm_receive_batch(connector_ptr, sm_ptr);
+    #endif
+
+    if (status == connector_callback_unrecognized)
+    {
+        connector_request_id_t request_id;
+        connector_network_receive_t read_data;
+
+        read_data.handle = sm_ptr->network.handle;
+        read_data.buffer = queue->data;
+        read_data.bytes_available = sm_ptr->transport.mtu;
+        read_data.bytes_used = 0;
+
+        request_id.network_request = connector_request_id_network_receive;
+        status = connector_callback(connector_ptr->callback, sm_ptr->network.class_id, request_id, &read_data, connector_ptr->context);
+        ASSERT(status != connector_callback_unrecognized);
+        if (status == connector_callback_continue)
+        {
+            queue->bytes[0] = read_data.bytes_used;
+            queue->count = 1;
+        }
+    }
+
+    switch (status)
+    {
+        case connector_callback_continue:
+            break;
+
+        case connector_callback_busy:
+            result = connector_idle;
             break;
 
         case connector_callback_abort:
@@ -583,19 +596,106 @@ STATIC connector_status_t sm_receive_data(connector_data_t * const connector_ptr
             break;
     }
 
+    return result;
+}
+
+STATIC connector_status_t sm_process_datagram(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_working;
+    connector_sm_packet_t * const recv_ptr = &sm_ptr->network.recv_packet;
+
+    switch (sm_ptr->network.transport)
+    {
+        #if (defined CONNECTOR_TRANSPORT_SMS)
+        case connector_transport_sms:
+            result = sm_verify_sms_preamble(sm_ptr);
+            switch(result)
+            {
+                case connector_working:
+                    break;
+                case connector_invalid_response:
+                    /* not Device Cloud packet? Ignore the packet */
+                    recv_ptr->total_bytes = 0;
+                    recv_ptr->processed_bytes = 0;
+                    result = connector_working;
+                    goto done;
+                default:
+                    goto done;
+            }
+
+            result = sm_decode_segment(connector_ptr, recv_ptr);
+
+            /* Remove sms preamble */
+            recv_ptr->processed_bytes = 0;
+
+            break;
+        #endif
+
+        #if (defined CONNECTOR_TRANSPORT_UDP)
+        case connector_transport_udp:
+            result = sm_verify_udp_header(sm_ptr);
+            break;
+        #endif
+
+        default:
+            ASSERT_GOTO(connector_false, done);
+            break;
+    }
+
+    if (result != connector_working)  /* not Device Cloud packet? */
+    {
+        recv_ptr->total_bytes = 0;
+        recv_ptr->processed_bytes = 0;
+        goto done;
+    }
+
+    result = sm_process_packet(connector_ptr, sm_ptr);
     sm_verify_result(sm_ptr, &result);
 
 done:
     return result;
 }
 
+STATIC connector_status_t sm_receive_data(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_working;
+    connector_sm_recv_queue_t * const queue = &sm_ptr->network.recv_queue;
+    connector_sm_packet_t * const recv_ptr = &sm_ptr->network.recv_packet;
+
+    if (queue->processed == queue->count)
+    {
+        result = sm_receive_datagrams(connector_ptr, sm_ptr);
+        if (result != connector_working)
+        {
+            sm_verify_result(sm_ptr, &result);
+            goto done;
+        }
+    }
+
+    /* reassemble everything the last receive brought in before going back to the platform */
+    while (queue->processed < queue->count)
+    {
+        recv_ptr->data = queue->data + (queue->processed * sm_ptr->transport.mtu);
+        recv_ptr->total_bytes = queue->bytes[queue->processed];
+        recv_ptr->processed_bytes = 0;
+        queue->processed++;
+
+        result = sm_process_datagram(connector_ptr, sm_ptr);
+        if (result != connector_working) break;
+        if (sm_ptr->transport.state == connector_transport_close) break;
+    }
+
+done:
+    return result;
+}
+
 #if (defined CONNECTOR_COMPRESSION)
 STATIC connector_status_t sm_decompress_data(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
 {
     connector_status_t status;
     size_t const max_payload_bytes = sm_get_max_payload_bytes(sm_ptr);
     uint8_t zlib_header[] = {0x58, 0xC3};
-    z_streamp const zlib_ptr = &session->compress.zlib;
+    z_streamp zlib_ptr;
     int zret;
 
     if (session->compress.out.data == NULL)
@@ -604,15 +704,22 @@ STATIC connector_status_t sm_decompress_data(connector_data_t * const connector_
         status = sm_allocate_user_buffer(connector_ptr, &session->compress.out);
         ASSERT_GOTO(status == connector_working, done);
 
-        memset(zlib_ptr, 0, sizeof *zlib_ptr);
-        zret = inflateInit(zlib_ptr);
-        ASSERT_GOTO(zret == Z_OK, error);
+        status = zlib_stream_acquire(connector_ptr, zlib_stream_inflate, &session->compress.zlib);
+        if (status != connector_working)
+        {
+            status = connector_abort;
+            goto error;
+        }
+
+        zlib_ptr = session->compress.zlib;
         zlib_ptr->next_out = session->compress.out.data;
         zlib_ptr->avail_out = session->compress.out.bytes;
         zlib_ptr->next_in = zlib_header;
         zlib_ptr->avail_in = sizeof zlib_header;
     }
 
+    zlib_ptr = session->compress.zlib;
+
     while (zlib_ptr->avail_out > 0)
     {
         if (zlib_ptr->avail_in == 0)
@@ -672,18 +779,11 @@ STATIC connector_status_t sm_decompress_data(connector_data_t * const connector_
     }
 
 error:
-    zret = inflateEnd(zlib_ptr);
-    if (zret != Z_OK)
-    {
-        status = connector_abort;
-        goto done;
-    }
-    ASSERT_GOTO(zret == Z_OK, done);
+    zlib_stream_release(connector_ptr, &session->compress.zlib);
 
     if (status != connector_abort)
     {
-        status = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->compress.out.data);
-        session->compress.out.data = NULL;
+        status = sm_free_user_buffer(connector_ptr, &session->compress.out);
     }
 
 done:
@@ -721,11 +821,8 @@ STATIC connector_status_t sm_handle_complete(connector_data_t * const connector_
 {
     connector_status_t result = connector_working;
 
-    if (session->in.data != NULL)
-    {
-        result = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->in.data);
-        if (result != connector_working) goto error;
-    }
+    result = sm_free_user_buffer(connector_ptr, &session->in);
+    if (result != connector_working) goto error;
 
     if (SmIsReboot(session->flags))
         result = sm_process_reboot(connector_ptr);
@@ -758,9 +855,9 @@ STATIC connector_status_t sm_process_recv_path(connector_data_t * const connecto
             {
                 unsigned long current_time = 0;
 
-                result = get_system_time(connector_ptr, &current_time);
+                result = get_system_time_in_milliseconds(connector_ptr, &current_time);
                 ASSERT_GOTO(result == connector_working, error);
-                if (current_time > (session->start_time + session->timeout_in_seconds))
+                if ((current_time - session->start_time) > (session->timeout_in_seconds * UINT32_C(1000)))
                 {
                     session->sm_state = connector_sm_state_error;
                     session->error = connector_sm_error_timeout;
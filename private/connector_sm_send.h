@@ -198,13 +198,17 @@ STATIC connector_status_t sm_compress_data(connector_data_t * const connector_pt
     status = sm_allocate_user_buffer(connector_ptr, &session->compress.out);
     ASSERT_GOTO(status == connector_working, error);
 
+    status = zlib_stream_acquire(connector_ptr, zlib_stream_deflate, &session->compress.zlib);
+    if (status != connector_working)
     {
-        z_streamp const zlib_ptr = &session->compress.zlib;
-        int zret;
+        sm_free_user_buffer(connector_ptr, &session->compress.out);
+        status = connector_abort;
+        goto error;
+    }
 
-        memset(zlib_ptr, 0, sizeof *zlib_ptr);
-        zret = deflateInit(zlib_ptr, Z_DEFAULT_COMPRESSION);
-        ASSERT_GOTO(zret == Z_OK, error);
+    {
+        z_streamp const zlib_ptr = session->compress.zlib;
+        int zret;
 
         zlib_ptr->next_in = session->in.data;
         zlib_ptr->avail_in = session->bytes_processed;
@@ -222,7 +226,7 @@ STATIC connector_status_t sm_compress_data(connector_data_t * const connector_pt
                     uint8_t * data_ptr = session->compress.out.data;
 
                     SmSetCompressed(session->flags);
-                    status = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->in.data);
+                    status = sm_free_user_buffer(connector_ptr, &session->in);
                     if (status != connector_working) goto error;
                     session->in.data = data_ptr;
                     session->bytes_processed = compressed_bytes;
@@ -233,19 +237,18 @@ STATIC connector_status_t sm_compress_data(connector_data_t * const connector_pt
             /* no break */
 
             case Z_OK:
-                status = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->compress.out.data);
+                status = sm_free_user_buffer(connector_ptr, &session->compress.out);
                 if (status != connector_working) goto error;
                 sm_set_payload_process(session);
                 break;
 
             default:
                 status = connector_abort;
-                ASSERT_GOTO(connector_false, error);
+                ASSERT(connector_false);
                 break;
         }
 
-        zret = deflateEnd(zlib_ptr);
-        ASSERT_GOTO(zret == Z_OK, error);
+        zlib_stream_release(connector_ptr, &session->compress.zlib);
     }
 
 error:
@@ -289,86 +292,78 @@ error:
     return result;
 }
 
-STATIC connector_status_t sm_send_segment(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+STATIC connector_bool_t sm_segment_in_place(connector_sm_session_t const * const session)
 {
-    connector_status_t result = connector_no_resource;
-    connector_sm_packet_t * const send_packet = &sm_ptr->network.send_packet;
-    connector_callback_status_t status;
-    connector_network_send_t send_data;
-    connector_request_id_t request_id;
-
-    send_data.buffer = &send_packet->data[send_packet->processed_bytes];
-    send_data.bytes_available = send_packet->total_bytes - send_packet->processed_bytes;
-    send_data.handle = sm_ptr->network.handle;
-    send_data.bytes_used = 0;
+    /* session buffers keep SM_SEGMENT_HEADROOM bytes in front, see sm_allocate_user_buffer() */
+    return connector_bool(!SmIsError(session->flags) && (session->in.bytes > 0) && (session->in.data != NULL));
+}
 
-    request_id.network_request = connector_request_id_network_send;
-    status = connector_callback(connector_ptr->callback, sm_ptr->network.class_id, request_id, &send_data, connector_ptr->context);
-    ASSERT_GOTO(status != connector_callback_unrecognized, error);
-    result = sm_map_callback_status_to_connector_status(status);
-    if (status != connector_callback_continue) goto error;
+STATIC connector_bool_t sm_segment_is_queued(connector_sm_data_t const * const sm_ptr, connector_sm_session_t const * const session)
+{
+    connector_sm_send_queue_t const * const queue = &sm_ptr->network.send_queue;
+    connector_bool_t queued = connector_false;
+    size_t i;
 
-    send_packet->processed_bytes += send_data.bytes_used;
-    if (send_packet->processed_bytes >= send_packet->total_bytes)
+    for (i = 0; i < queue->count; i++)
     {
-        connector_sm_session_t * const session = send_packet->pending_session;
-
-        ASSERT_GOTO(session != NULL, error);
-        session->segments.processed++;
-        if (session->segments.count == session->segments.processed)
+        if (queue->segment[i].session == session)
         {
-            if (session->in.bytes != 0)
-            {
-                connector_debug_line("ERROR: sm_send_segment: All segments processed but still remaining bytes");
-            }
-            result = sm_switch_path(connector_ptr, session, SmIsResponse(session->flags) ? connector_sm_state_complete : connector_sm_state_receive_data);
-            if (result != connector_working) goto error;
+            queued = connector_true;
+            break;
         }
-
-        send_packet->total_bytes = 0;
-        send_packet->processed_bytes = 0;
-        send_packet->pending_session = NULL;
     }
 
-error:
-    return result;
+    return queued;
 }
 
-#if (defined CONNECTOR_TRANSPORT_SMS)
-STATIC connector_status_t sm_encode_segment(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
+STATIC connector_bool_t sm_send_batch_enabled(connector_sm_data_t const * const sm_ptr)
 {
-    size_t const data_size = 1+(sm_ptr->network.send_packet.total_bytes * 5)/4;
-    void * data_ptr = NULL;
-    connector_status_t result = malloc_data_buffer(connector_ptr, data_size, named_buffer_id(sm_data_block), &data_ptr);
-
-    if (result == connector_working)
-    {
-        connector_sm_packet_t * const send_ptr = &sm_ptr->network.send_packet;
+    connector_bool_t enabled = connector_false;
 
-        send_ptr->total_bytes = sm_encode85(data_ptr, data_size, send_ptr->data, send_ptr->total_bytes);
-        memcpy(send_ptr->data, data_ptr, send_ptr->total_bytes);
-        result = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), data_ptr);
-        if (result != connector_working) goto error;
-        session->sm_state = connector_sm_state_send_data;
-    }
+    #if (defined CONNECTOR_TRANSPORT_UDP)
+    if (sm_ptr->network.transport == connector_transport_udp)
+        enabled = connector_bool(!sm_ptr->network.send_queue.batch_unsupported);
+    #else
+    UNUSED_PARAMETER(sm_ptr);
+    #endif
 
-error:
-    return result;
+    return enabled;
 }
-#endif
 
-STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
+STATIC size_t sm_preamble_bytes(connector_sm_data_t const * const sm_ptr)
 {
-    connector_status_t result = connector_working;
-    connector_sm_packet_t * const send_ptr = &sm_ptr->network.send_packet;
-    uint8_t * data_ptr = send_ptr->data;
-    uint8_t * sm_header;
+    size_t preamble_bytes = 0;
 
-    if (send_ptr->total_bytes > 0)
+    switch (sm_ptr->network.transport)
     {
-        goto send;
+        #if (defined CONNECTOR_TRANSPORT_UDP)
+        case connector_transport_udp:
+        {
+            size_t const sm_udp_version_length = 1;
+
+            preamble_bytes = sm_udp_version_length + sm_ptr->transport.id_length;
+            break;
+        }
+        #endif
+
+        #if (defined CONNECTOR_TRANSPORT_SMS)
+        case connector_transport_sms:
+            /* service ID available? */
+            if (sm_ptr->transport.id_length > 0)
+                preamble_bytes = sm_ptr->transport.id_length + SMS_SERVICEID_WRAPPER_TX_SIZE;
+            break;
+        #endif
+
+        default:
+            ASSERT(connector_false);
+            break;
     }
 
+    return preamble_bytes;
+}
+
+STATIC void sm_store_preamble(connector_sm_data_t const * const sm_ptr, uint8_t * data_ptr)
+{
     switch (sm_ptr->network.transport)
     {
         #if (defined CONNECTOR_TRANSPORT_UDP)
@@ -378,9 +373,7 @@ STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, c
             uint8_t const version_byte = sm_udp_version_num | sm_ptr->transport.id_type;
 
             *data_ptr++ = version_byte;
-            ASSERT(connector_ptr->connector_got_device_id);
             memcpy(data_ptr, sm_ptr->transport.id, sm_ptr->transport.id_length);
-            data_ptr += sm_ptr->transport.id_length;
             break;
         }
         #endif
@@ -388,15 +381,13 @@ STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, c
         #if (defined CONNECTOR_TRANSPORT_SMS)
         case connector_transport_sms:
         {
-            /* service ID available? */
             if (sm_ptr->transport.id_length > 0)
             {
                 ASSERT(sm_ptr->transport.id != NULL);
                 memcpy(data_ptr, sm_ptr->transport.id, sm_ptr->transport.id_length);
                 data_ptr += sm_ptr->transport.id_length;
-                *data_ptr++ = ' ';
+                *data_ptr = ' ';
             }
-
             break;
         }
         #endif
@@ -405,77 +396,121 @@ STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, c
             ASSERT(connector_false);
             break;
     }
+}
+
+STATIC size_t sm_segment_header_bytes(connector_sm_session_t const * const session)
+{
+    size_t header_bytes = record_end(segmentn);
 
-    sm_header = data_ptr;
+    if (session->segments.processed == 0)
+        header_bytes = SmIsMultiPart(session->flags) ? record_end(segment0) : record_end(segment);
 
+    return header_bytes;
+}
+
+STATIC connector_status_t sm_store_segment_header(connector_sm_session_t const * const session, uint8_t * const sm_header)
+{
+    connector_status_t result = connector_abort;
+    uint8_t const sm_version_num = 0x01 << 5;
+    uint8_t const request_id_hi = (session->request_id & SM_REQUEST_ID_MASK) >> 8;
+    uint8_t const request_id_low = session->request_id & 0xFF;
+    uint8_t info_field = sm_version_num | request_id_hi;
+
+    if (SmIsResponse(session->flags))
+        SmSetResponse(info_field);
+    else if (SmIsResponseNeeded(session->flags))
+        SmSetResponseNeeded(info_field);
+
+    if (session->segments.processed == 0)
     {
-        uint8_t const sm_version_num = 0x01 << 5;
-        uint8_t const request_id_hi = (session->request_id & SM_REQUEST_ID_MASK) >> 8;
-        uint8_t const request_id_low = session->request_id & 0xFF;
-        uint8_t info_field = sm_version_num | request_id_hi;
+        uint8_t cmd_field = SmIsRequest(session->flags) ? session->command : 0;
 
-        if (SmIsResponse(session->flags))
-            SmSetResponse(info_field);
-        else if (SmIsResponseNeeded(session->flags))
-            SmSetResponseNeeded(info_field);
+        if (SmIsError(session->flags))
+            SmSetError(cmd_field);
+        if (SmIsCompressed(session->flags))
+            SmSetCompressed(cmd_field);
 
-        if (session->segments.processed == 0)
+        #if (defined CONNECTOR_SM_MULTIPART)
+        if (SmIsMultiPart(session->flags))
         {
-            uint8_t cmd_field = SmIsRequest(session->flags) ? session->command : 0;
+            uint8_t * const segment0 = sm_header;
 
-            if (SmIsError(session->flags))
-                SmSetError(cmd_field);
-            if (SmIsCompressed(session->flags))
-                SmSetCompressed(cmd_field);
-
-            #if (defined CONNECTOR_SM_MULTIPART)
-            if (SmIsMultiPart(session->flags))
-            {
-                uint8_t * const segment0 = sm_header;
-
-                SmSetMultiPart(info_field);
-                message_store_u8(segment0, info, info_field);
-                message_store_u8(segment0, request, request_id_low);
-                message_store_u8(segment0, segment, session->segments.processed);
-                message_store_u8(segment0, count, session->segments.count);
-                message_store_u8(segment0, cmd_status, cmd_field);
-                message_store_be16(segment0, crc, 0);
-                data_ptr += record_end(segment0);
-            }
-            else
-            #endif
-            {
-                uint8_t * const segment = sm_header;
-
-                ASSERT_GOTO(SmIsNotMultiPart(session->flags), done);
-                message_store_u8(segment, info, info_field);
-                message_store_u8(segment, request, request_id_low);
-                message_store_u8(segment, cmd_status, cmd_field);
-                message_store_be16(segment, crc, 0);
-                data_ptr += record_end(segment);
-            }
+            SmSetMultiPart(info_field);
+            message_store_u8(segment0, info, info_field);
+            message_store_u8(segment0, request, request_id_low);
+            message_store_u8(segment0, segment, session->segments.processed);
+            message_store_u8(segment0, count, session->segments.count);
+            message_store_u8(segment0, cmd_status, cmd_field);
+            message_store_be16(segment0, crc, 0);
         }
         else
+        #endif
         {
-            uint8_t * const segmentn = sm_header;
+            uint8_t * const segment = sm_header;
 
-            ASSERT_GOTO(SmIsMultiPart(session->flags), done);
-            SmSetMultiPart(info_field);
-            message_store_u8(segmentn, info, info_field);
-            message_store_u8(segmentn, request, request_id_low);
-            message_store_u8(segmentn, segment, session->segments.processed);
-            message_store_be16(segmentn, crc, 0);
-            data_ptr += record_end(segmentn);
+            ASSERT_GOTO(SmIsNotMultiPart(session->flags), error);
+            message_store_u8(segment, info, info_field);
+            message_store_u8(segment, request, request_id_low);
+            message_store_u8(segment, cmd_status, cmd_field);
+            message_store_be16(segment, crc, 0);
         }
     }
+    else
+    {
+        uint8_t * const segmentn = sm_header;
+
+        ASSERT_GOTO(SmIsMultiPart(session->flags), error);
+        SmSetMultiPart(info_field);
+        message_store_u8(segmentn, info, info_field);
+        message_store_u8(segmentn, request, request_id_low);
+        message_store_u8(segmentn, segment, session->segments.processed);
+        message_store_be16(segmentn, crc, 0);
+    }
+
+    result = connector_working;
+
+error:
+    return result;
+}
 
+/*
+ * Builds the next segment of a session and queues it. A payload slice is not copied: its
+ * header (and the UDP preamble) is written right in front of it in the session buffer,
+ * over the tail of the previous segment, which has already been sent. Segments without a
+ * payload slice and SMS segments, which are base85 encoded, are built in send_packet.
+ */
+STATIC connector_status_t sm_build_segment(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
+{
+    connector_status_t result;
+    connector_sm_packet_t * const send_packet = &sm_ptr->network.send_packet;
+    connector_sm_send_queue_t * const queue = &sm_ptr->network.send_queue;
+    connector_sm_segment_t * const segment = &queue->segment[queue->count];
+    size_t const header_bytes = sm_segment_header_bytes(session);
+    size_t const preamble_bytes = sm_preamble_bytes(sm_ptr);
+    uint8_t small_segment[record_end(segment0) + sizeof(uint16_t) + sizeof "Unexpected request"];
+    uint8_t * sm_header;
+    size_t payload_bytes = 0;
+
+    UNUSED_PARAMETER(connector_ptr);
+    ASSERT(queue->count < SM_SEND_BATCH_SIZE);
+    #if (defined CONNECTOR_TRANSPORT_UDP)
+    ASSERT((sm_ptr->network.transport != connector_transport_udp) || connector_ptr->connector_got_device_id);
+    #endif
+
+    if (sm_segment_in_place(session))
+    {
+        size_t const bytes_available = sm_ptr->transport.sm_mtu_tx - header_bytes;
+
+        payload_bytes = (session->in.bytes < bytes_available) ? session->in.bytes : bytes_available;
+        sm_header = &session->in.data[session->bytes_processed] - header_bytes;
+    }
+    else
     {
-        size_t const filled_bytes = data_ptr - send_ptr->data;
-        size_t const bytes_available = sm_ptr->transport.sm_mtu_tx - (data_ptr - sm_header);
-        size_t payload_bytes;
+        sm_header = small_segment;
 
         if (SmIsError(session->flags))
         {
+            uint8_t * const data_ptr = sm_header + header_bytes;
             uint16_t const error_code = (uint16_t)session->error;
             char * const error_text = (session->error == connector_sm_error_in_request) ? "Request error" : "Unexpected request";
             size_t const error_text_length = strlen(error_text) + 1;
@@ -485,59 +520,202 @@ STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, c
             memcpy(data_ptr + error_code_length, error_text, error_text_length);
             payload_bytes = error_code_length + error_text_length;
         }
-        else
-        {
-            payload_bytes = (session->in.bytes < bytes_available) ? session->in.bytes : bytes_available;
+    }
 
-            if (payload_bytes > 0)
-            {
-                memcpy(data_ptr, &session->in.data[session->bytes_processed], payload_bytes);
-                session->bytes_processed += payload_bytes;
-                session->in.bytes -= payload_bytes;
-            }
-        }
+    result = sm_store_segment_header(session, sm_header);
+    if (result != connector_working) goto error;
+
+    {
+        size_t const segment_bytes = header_bytes + payload_bytes;
+        uint8_t * const crc_field = sm_header + header_bytes - 2;
+        uint16_t crc_value = 0;
 
-        send_ptr->total_bytes = filled_bytes + payload_bytes;
+        crc_value = sm_calculate_crc16(crc_value, sm_header, segment_bytes);
+        StoreBE16(crc_field, crc_value);
 
+        #if (defined CONNECTOR_TRANSPORT_SMS)
+        if (SmIsEncoded(session->flags))
         {
-            uint8_t * const crc_field = data_ptr - 2;
-            size_t const header_bytes = data_ptr - sm_header;
-            size_t const crc_bytes = header_bytes + payload_bytes;
-            uint16_t crc_value = 0;
-
-            crc_value = sm_calculate_crc16(crc_value, sm_header, crc_bytes);
-            StoreBE16(crc_field, crc_value);
+            /* the preamble is not encoded */
+            sm_store_preamble(sm_ptr, send_packet->data);
+            send_packet->total_bytes = preamble_bytes + (size_t)sm_encode85(send_packet->data + preamble_bytes, sm_ptr->transport.mtu - preamble_bytes, sm_header, segment_bytes);
+            segment->data = send_packet->data;
+            segment->bytes = send_packet->total_bytes;
+        }
+        else
+        #endif
+        if (sm_header != small_segment)
+        {
+            segment->data = sm_header - preamble_bytes;
+            segment->bytes = preamble_bytes + segment_bytes;
+            sm_store_preamble(sm_ptr, segment->data);
+        }
+        else
+        {
+            sm_store_preamble(sm_ptr, send_packet->data);
+            memcpy(send_packet->data + preamble_bytes, sm_header, segment_bytes);
+            send_packet->total_bytes = preamble_bytes + segment_bytes;
+            segment->data = send_packet->data;
+            segment->bytes = send_packet->total_bytes;
         }
     }
 
-    send_ptr->pending_session = session;
-    #if (defined CONNECTOR_TRANSPORT_SMS)
-    if (SmIsEncoded(session->flags))
+    if (!SmIsError(session->flags))
     {
-        session->sm_state = connector_sm_state_encoding;
-        /* Increase pointer to skip preamble encoding */
-        if (sm_ptr->transport.id_length)
-        {
-            send_ptr->data += (sm_ptr->transport.id_length + SMS_SERVICEID_WRAPPER_TX_SIZE);
-            send_ptr->total_bytes -= (sm_ptr->transport.id_length + SMS_SERVICEID_WRAPPER_TX_SIZE);
-        }
+        session->bytes_processed += payload_bytes;
+        session->in.bytes -= payload_bytes;
+    }
+
+    segment->session = session;
+    queue->count++;
 
-        result = sm_encode_segment(connector_ptr, sm_ptr, session);
+error:
+    return result;
+}
+
+STATIC connector_status_t sm_segment_sent(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_working;
+    connector_sm_send_queue_t * const queue = &sm_ptr->network.send_queue;
+    connector_sm_session_t * const session = queue->segment[0].session;
 
-        /* Restore pointer if it has preamble */
-        if (sm_ptr->transport.id_length)
+    ASSERT_GOTO(session != NULL, error);
+    if (queue->segment[0].data == sm_ptr->network.send_packet.data)
+        sm_ptr->network.send_packet.total_bytes = 0;
+
+    queue->count--;
+    memmove(&queue->segment[0], &queue->segment[1], queue->count * sizeof queue->segment[0]);
+    queue->processed_bytes = 0;
+
+    session->segments.processed++;
+    if (session->segments.count == session->segments.processed)
+    {
+        if (session->in.bytes != 0)
         {
-            send_ptr->data -= (sm_ptr->transport.id_length + SMS_SERVICEID_WRAPPER_TX_SIZE);
-            send_ptr->total_bytes += (sm_ptr->transport.id_length + SMS_SERVICEID_WRAPPER_TX_SIZE);
+            connector_debug_line("ERROR: sm_segment_sent: All segments processed but still remaining bytes");
         }
+        result = sm_switch_path(connector_ptr, session, SmIsResponse(session->flags) ? connector_sm_state_complete : connector_sm_state_receive_data);
     }
-    #endif
-send:
-    if (result == connector_working)
+
+error:
+    return result;
+}
+
+STATIC connector_status_t sm_send_segment(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_no_resource;
+    connector_sm_send_queue_t * const queue = &sm_ptr->network.send_queue;
+    connector_sm_segment_t const * const segment = &queue->segment[0];
+    connector_callback_status_t status;
+    connector_network_send_t send_data;
+    connector_request_id_t request_id;
+
+    send_data.buffer = &segment->data[queue->processed_bytes];
+    send_data.bytes_available = segment->bytes - queue->processed_bytes;
+    send_data.handle = sm_ptr->network.handle;
+    send_data.bytes_used = 0;
+
+    request_id.network_request = connector_request_id_network_send;
+    status = connector_callback(connector_ptr->callback, sm_ptr->network.class_id, request_id, &send_data, connector_ptr->context);
+    ASSERT_GOTO(status != connector_callback_unrecognized, error);
+    result = sm_map_callback_status_to_connector_status(status);
+    if (status != connector_callback_continue) goto error;
+
+    queue->processed_bytes += send_data.bytes_used;
+    if (queue->processed_bytes >= segment->bytes)
+        result = sm_segment_sent(connector_ptr, sm_ptr);
+
+error:
+    return result;
+}
+
+#if (defined CONNECTOR_TRANSPORT_UDP)
+STATIC connector_status_t sm_send_batch(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result;
+    connector_sm_send_queue_t * const queue = &sm_ptr->network.send_queue;
+    connector_network_iovec_t datagram[SM_SEND_BATCH_SIZE];
+    connector_network_send_batch_t send_data;
+    connector_callback_status_t status;
+    connector_request_id_t request_id;
+    size_t i;
+
+    for (i = 0; i < queue->count; i++)
+    {
+        datagram[i].buffer = queue->segment[i].data;
+        datagram[i].length = queue->segment[i].bytes;
+    }
+
+    send_data.handle = sm_ptr->network.handle;
+    send_data.datagram = datagram;
+    send_data.datagram_count = queue->count;
+    send_data.datagrams_sent = 0;
+
+    request_id.network_request = connector_request_id_network_send_batch;
+    status = connector_callback(connector_ptr->callback, sm_ptr->network.class_id, request_id, &send_data, connector_ptr->context);
+    if (status == connector_callback_unrecognized)
     {
+        /* optional callback, send one datagram at a time from now on */
+        queue->batch_unsupported = connector_true;
         result = sm_send_segment(connector_ptr, sm_ptr);
+        goto done;
+    }
+
+    result = sm_map_callback_status_to_connector_status(status);
+    if (status != connector_callback_continue) goto done;
+
+    ASSERT_GOTO(send_data.datagrams_sent <= send_data.datagram_count, done);
+    for (i = 0; (i < send_data.datagrams_sent) && (result == connector_working); i++)
+        result = sm_segment_sent(connector_ptr, sm_ptr);
+
+done:
+    return result;
+}
+#endif
+
+/* Sends the queued segments, all of them with one callback when the transport takes a batch */
+STATIC connector_status_t sm_send_segments(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr)
+{
+    connector_status_t result = connector_idle;
+    connector_sm_send_queue_t const * const queue = &sm_ptr->network.send_queue;
+
+    if (queue->count == 0) goto done;
+
+    #if (defined CONNECTOR_TRANSPORT_UDP)
+    if ((queue->count > 1) && (queue->processed_bytes == 0) && sm_send_batch_enabled(sm_ptr))
+    {
+        result = sm_send_batch(connector_ptr, sm_ptr);
+        goto done;
+    }
+    #endif
+
+    result = sm_send_segment(connector_ptr, sm_ptr);
+
+done:
+    return result;
+}
+
+STATIC connector_status_t sm_send_data(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
+{
+    connector_status_t result;
+    connector_sm_send_queue_t const * const queue = &sm_ptr->network.send_queue;
+    connector_bool_t const needs_send_packet = connector_bool(SmIsEncoded(session->flags) || !sm_segment_in_place(session));
+
+    /* The next segment's header goes over the tail of the previous one, so that one must be out first */
+    if (sm_segment_is_queued(sm_ptr, session) || (queue->count == SM_SEND_BATCH_SIZE) ||
+        (needs_send_packet && (sm_ptr->network.send_packet.total_bytes > 0)))
+    {
+        result = sm_send_segments(connector_ptr, sm_ptr);
+        goto done;
     }
 
+    result = sm_build_segment(connector_ptr, sm_ptr, session);
+    if (result != connector_working) goto done;
+
+    /* When batching, the segment waits for the other sessions to queue theirs; see sm_state_machine() */
+    if (!sm_send_batch_enabled(sm_ptr))
+        result = sm_send_segments(connector_ptr, sm_ptr);
+
 done:
     return result;
 }
@@ -573,16 +751,6 @@ STATIC connector_status_t sm_process_send_path(connector_data_t * const connecto
             result = sm_prepare_segment(sm_ptr, session);
             break;
 
-        #if (defined CONNECTOR_TRANSPORT_SMS)
-        case connector_sm_state_encoding:
-            result = sm_encode_segment(connector_ptr, sm_ptr, session);
-            if (result == connector_working)
-            {
-                result = sm_send_segment(connector_ptr, sm_ptr);
-            }
-            break;
-        #endif
-
         case connector_sm_state_send_data:
             result = sm_send_data(connector_ptr, sm_ptr, session);
             break;
@@ -90,7 +90,7 @@ STATIC connector_sm_session_t * sm_create_session(connector_data_t * const conne
         goto error;
 
     session = ptr;
-    result = get_system_time(connector_ptr, &session->start_time);
+    result = get_system_time_in_milliseconds(connector_ptr, &session->start_time);
     ASSERT_GOTO(result == connector_working, error);
 
     session->flags = 0;
@@ -102,6 +102,9 @@ STATIC connector_sm_session_t * sm_create_session(connector_data_t * const conne
     session->user.context = NULL;
     session->segments.processed = 0;
     session->segments.count = 0;
+#if (defined CONNECTOR_COMPRESSION)
+    session->compress.zlib = NULL;
+#endif
 
     session->transport = sm_ptr->network.transport;
     #if (defined CONNECTOR_TRANSPORT_SMS)
@@ -140,6 +143,29 @@ done:
     return session;
 }
 
+/* Forget the segment a session still has queued, its data is about to be freed */
+STATIC void sm_drop_segment(connector_sm_data_t * const sm_ptr, connector_sm_session_t const * const session)
+{
+    connector_sm_send_queue_t * const queue = &sm_ptr->network.send_queue;
+    size_t i;
+
+    for (i = 0; i < queue->count; i++)
+    {
+        connector_sm_segment_t const * const segment = &queue->segment[i];
+
+        if (segment->session != session) continue;
+
+        if (segment->data == sm_ptr->network.send_packet.data)
+            sm_ptr->network.send_packet.total_bytes = 0;
+        if (i == 0)
+            queue->processed_bytes = 0;
+
+        queue->count--;
+        memmove(&queue->segment[i], &queue->segment[i + 1], (queue->count - i) * sizeof queue->segment[i]);
+        break;
+    }
+}
+
 STATIC connector_status_t sm_delete_session(connector_data_t * const connector_ptr, connector_sm_data_t * const sm_ptr, connector_sm_session_t * const session)
 {
     connector_status_t result = connector_working;
@@ -158,11 +184,11 @@ STATIC connector_status_t sm_delete_session(connector_data_t * const connector_p
         sm_ptr->session.active_cloud_sessions--;
     }
 
-    if (session->in.data != NULL)
-    {
-        result = free_data_buffer(connector_ptr, named_buffer_id(sm_data_block), session->in.data);
-        session->in.data = NULL;
-    }
+    sm_drop_segment(sm_ptr, session);
+    result = sm_free_user_buffer(connector_ptr, &session->in);
+#if (defined CONNECTOR_COMPRESSION)
+    zlib_stream_release(connector_ptr, &session->compress.zlib);
+#endif
 
     remove_list_node(&sm_ptr->session.head, &sm_ptr->session.tail, session);
     if (sm_ptr->session.current == session)
@@ -22,8 +22,9 @@
  * In os_intf.h: 
  * 1. Add to connector_static_buffer_id_t:
  *      named_buffer_id(my_data)
- * - Single buffers share a msg_facility map, and their id's should go up from the bottom (28, 27, etc.)
+ * - Single buffers share the single_buffer_map, and their id's should go up from the bottom (28, 27, etc.)
  * - All arrays should be before single buffers
+ * - Arrays also need a connector_static_pool_t entry in connector_api.h so their statistics can be read
  *  
  * In this file:
  * 2. - If there is a type, add:
@@ -33,7 +34,7 @@
  *         define_sized_buffer_type(my_data, 100);
  *  
  * For a single static buffer:
- * 3. Add to connector_static_mem: 
+ * 3. Add to connector_static_mem_t: 
  *      named_buffer_define(my_data);
  *  
  * 4. Add to malloc_static_data(): 
@@ -46,11 +47,11 @@
  *           free_named_static_buffer(my_data);
  *           break;
  *  
- * For an array of 20 elements (must be <= 32): 
+ * For an array of 20 elements: 
  * 3. Add: 
  *      #define my_data_buffer_cnt 20
  *  
- * 4. Add to connector_static_mem: 
+ * 4. Add to connector_static_mem_t: 
  *      named_buffer_array_define(my_data);
  *      named_buffer_map_define(my_data);
  *
@@ -73,10 +74,13 @@
 #define named_buffer_cnt(name)          name##_buffer_cnt
 #define named_buffer_define(name)       named_buffer_type(name) named_buffer_decl(name)
 #define named_buffer_array_define(name) named_buffer_define(name)[named_buffer_cnt(name)]
-#define named_buffer_map_define(name)   uint32_t named_buffer_map_decl(name)
+#define named_buffer_map_words(name)    ((named_buffer_cnt(name) + 31) / 32)
+#define named_buffer_map_define(name)   uint32_t named_buffer_map_decl(name)[named_buffer_map_words(name)]
+#define named_pool_id(name)             connector_static_pool_##name
 
-#define named_buffer_storage(name)      connector_static_mem.named_buffer_decl(name)
-#define named_buffer_map(name)          connector_static_mem.named_buffer_map_decl(name)
+/* Storage and maps are always reached through the local static_mem arena pointer */
+#define named_buffer_storage(name)      static_mem->named_buffer_decl(name)
+#define named_buffer_map(name)          static_mem->named_buffer_map_decl(name)
 
 #define define_sized_buffer_type(name, size) typedef struct { char field[(size)]; } named_buffer_type(name)
 
@@ -89,10 +93,6 @@
 #define CONNECTOR_MSG_MAX_TRANSACTION   1
 #endif
 
-#if CONNECTOR_MSG_MAX_TRANSACTION > 32
-#error "CONNECTOR_MSG_MAX_TRANSACTION must be <= 32"
-#endif
-
 #define CONNECTOR_MSG_SERVICE
 
 #if defined CONNECTOR_RCI_SERVICE
@@ -168,6 +168,27 @@ typedef union
 
 define_sized_buffer_type(msg_session, MSG_SESSION_SIZE);
 define_sized_buffer_type(msg_session_client, MSG_SESSION_CLIENT_SIZE);
+
+/* Session lookup table: a power of 2 at least twice the number of session buffers */
+#if defined CONNECTOR_DATA_SERVICE
+#define MSG_SESSION_TABLE_MIN_SIZE  (2 * (msg_session_buffer_cnt + msg_session_client_buffer_cnt))
+#else
+#define MSG_SESSION_TABLE_MIN_SIZE  (2 * msg_session_buffer_cnt)
+#endif
+
+#if MSG_SESSION_TABLE_MIN_SIZE <= MSG_SESSION_TABLE_INITIAL_SIZE
+#define MSG_SESSION_TABLE_SIZE  MSG_SESSION_TABLE_INITIAL_SIZE
+#elif MSG_SESSION_TABLE_MIN_SIZE <= 64
+#define MSG_SESSION_TABLE_SIZE  64
+#elif MSG_SESSION_TABLE_MIN_SIZE <= 256
+#define MSG_SESSION_TABLE_SIZE  256
+#elif MSG_SESSION_TABLE_MIN_SIZE <= 1024
+#define MSG_SESSION_TABLE_SIZE  1024
+#else
+#define MSG_SESSION_TABLE_SIZE  4096
+#endif
+
+typedef struct { msg_session_t * slot[MSG_SESSION_TABLE_SIZE]; } named_buffer_type(msg_session_table);
 #endif
 
 typedef struct
@@ -229,10 +250,6 @@ typedef struct
 #undef CONNECTOR_SM_MAX_SESSIONS /* In case of old define is still present in connector_config.h */
 #define CONNECTOR_SM_MAX_SESSIONS (CONNECTOR_SM_UDP_MAX_SESSIONS + CONNECTOR_SM_SMS_MAX_SESSIONS)
 
-#if CONNECTOR_SM_MAX_SESSIONS > 32
-#error "CONNECTOR_SM_MAX_SESSIONS must be <= 32"
-#endif
-
 #if defined (CONNECTOR_TRANSPORT_UDP) && defined (CONNECTOR_TRANSPORT_SMS)
 #define sm_session_buffer_cnt   (4 * CONNECTOR_SM_MAX_SESSIONS)
 #else
@@ -250,19 +267,26 @@ typedef struct
 
 typedef connector_sm_session_t named_buffer_type(sm_session);
 
-define_sized_buffer_type(sm_packet, 2 * SM_MAX_MTU);
-define_sized_buffer_type(sm_data_block, CONNECTOR_SM_MAX_RX_SEGMENTS * SM_MAX_MTU);
+define_sized_buffer_type(sm_packet, (1 + SM_RECV_BATCH_SIZE) * SM_MAX_MTU);
+define_sized_buffer_type(sm_data_block, (CONNECTOR_SM_MAX_RX_SEGMENTS * SM_MAX_MTU) + SM_SEGMENT_HEADROOM);
 
 #endif
 
+#if defined CONNECTOR_COMPRESSION
+#define zlib_stream_buffer_cnt      CONNECTOR_COMPRESSION_STREAMS
+typedef zlib_stream_t named_buffer_type(zlib_stream);
+#endif
+
 typedef connector_data_t named_buffer_type(connector_data);
 
 
 /*** Declare static memory structure ***/
-static struct
+/* connector_data must stay the first member: a handle is the start of its own arena */
+typedef struct
 {
     named_buffer_define(connector_data);
-    named_buffer_map_define(msg_facility);
+    uint32_t single_buffer_map;
+    connector_static_pool_stats_t pool_stats[connector_static_pool_count];
 
 #if defined CONNECTOR_TRANSPORT_TCP
     named_buffer_define(cc_facility);
@@ -275,7 +299,9 @@ static struct
     named_buffer_array_define(msg_facility);
     named_buffer_array_define(msg_session);
     named_buffer_array_define(msg_service);
+    named_buffer_define(msg_session_table);
 
+    named_buffer_map_define(msg_facility);
     named_buffer_map_define(msg_session);
     named_buffer_map_define(msg_service);
 #endif
@@ -302,38 +328,87 @@ static struct
     named_buffer_map_define(sm_data_block);
 #endif
 
-} connector_static_mem;
+#if defined CONNECTOR_COMPRESSION
+    named_buffer_array_define(zlib_stream);
+    named_buffer_map_define(zlib_stream);
+#endif
+
+} connector_static_mem_t;
+
+/* Arena used by connector_init(); connector_init_static() handles use their own */
+static connector_static_mem_t connector_static_mem;
+
+#define get_static_mem(connector_ptr)   ((connector_ptr) != NULL ? (connector_static_mem_t *)(void *)(connector_ptr) : &connector_static_mem)
 
 /*** Static memory operations ***/
 
-#define static_buffer_release(pmap, idx) (*(pmap) &= (~(1 << (idx))))
+#define static_buffer_bit(idx)  (UINT32_C(1) << ((idx) % 32))
+
+#define static_buffer_release(pmap, idx) ((pmap)[(idx) / 32] &= ~static_buffer_bit(idx))
 
 STATIC int static_buffer_reserve(uint32_t * const pmap, uint32_t const idx)
 {
     int result = -1;
 
-    if ((*pmap & (1 << idx)) == 0)
+    if ((pmap[idx / 32] & static_buffer_bit(idx)) == 0)
     {
-        *pmap |= 1 << idx;
+        pmap[idx / 32] |= static_buffer_bit(idx);
         result = idx;
     }
     return result;
 }
 
-STATIC int static_buffer_get_avail(uint32_t * const pmap, int max_cnt)
+/* Count trailing zeros of a non-zero word: isolate the lowest set bit and index a de Bruijn table */
+STATIC unsigned int static_buffer_ctz(uint32_t const value)
+{
+    static uint8_t const debruijn_bit_position[32] =
+    {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    uint32_t const lowest_bit = value & (~value + 1);
+
+    ASSERT(value != 0);
+    return debruijn_bit_position[(uint32_t)(lowest_bit * UINT32_C(0x077CB531)) >> 27];
+}
+
+STATIC int static_buffer_get_avail(uint32_t * const pmap, int const max_cnt)
 {
     int idx = -1;
-    int i;
+    int word;
 
-    for (i = 0; i < max_cnt; i++)
+    for (word = 0; word * 32 < max_cnt; word++)
     {
-        idx = static_buffer_reserve(pmap, i);
-        if (idx >= 0)
+        uint32_t free_bits = ~pmap[word];
+        int const bits_in_word = (max_cnt - word * 32) < 32 ? (max_cnt - word * 32) : 32;
+
+        if (bits_in_word < 32)
+            free_bits &= static_buffer_bit(bits_in_word) - 1;
+
+        if (free_bits != 0)
+        {
+            idx = word * 32 + (int)static_buffer_ctz(free_bits);
+            pmap[word] |= static_buffer_bit(idx);
             break;
+        }
     }
     return idx;
 }
 
+STATIC void static_buffer_update_stats(connector_static_pool_stats_t * const stats, void const * const ptr)
+{
+    if (ptr != NULL)
+    {
+        stats->in_use++;
+        if (stats->in_use > stats->high_water)
+            stats->high_water = stats->in_use;
+    }
+    else
+    {
+        stats->failures++;
+    }
+}
+
 #define static_buffer_malloc(pmap, name) static_buffer_reserve(pmap, named_buffer_id(name)) >= 0 ? &named_buffer_storage(name) : NULL
 #define static_buffer_free(pmap, name) static_buffer_release(pmap, named_buffer_id(name))
 
@@ -341,39 +416,105 @@ STATIC int static_buffer_get_avail(uint32_t * const pmap, int max_cnt)
 {   \
     int idx = ((named_buffer_type(name) *) ptr - (named_buffer_type(name) *) &named_buffer_storage(name)[0]); \
     ASSERT(idx >= 0 && idx < named_buffer_cnt(name)); \
-    static_buffer_release(&named_buffer_map(name), idx); \
+    static_buffer_release(named_buffer_map(name), idx); \
+    static_mem->pool_stats[named_pool_id(name)].in_use--; \
 }
 
 #define malloc_named_static_buffer(name, size, ptr, status) \
 { \
     ASSERT(size == sizeof(named_buffer_type(name))); \
-    *ptr = static_buffer_malloc(&named_buffer_map(msg_facility), name); \
+    *ptr = static_buffer_malloc(&static_mem->single_buffer_map, name); \
     status = *ptr != NULL ? connector_working : connector_pending; \
 }
 
 
-#define free_named_static_buffer(name) static_buffer_free(&named_buffer_map(msg_facility), name)
+#define free_named_static_buffer(name) static_buffer_free(&static_mem->single_buffer_map, name)
 
 #define malloc_named_array_element(name, size, ptr, status) \
 {   \
     int idx; \
     ASSERT(size <= sizeof(named_buffer_type(name))); \
-    idx = static_buffer_get_avail(&named_buffer_map(name), named_buffer_cnt(name)); \
+    idx = static_buffer_get_avail(named_buffer_map(name), named_buffer_cnt(name)); \
     *ptr = idx >= 0 ? &named_buffer_storage(name)[idx] : NULL; \
+    static_buffer_update_stats(&static_mem->pool_stats[named_pool_id(name)], *ptr); \
     status = *ptr != NULL ? connector_working : connector_pending; \
 }
 
-STATIC connector_status_t malloc_static_data(connector_data_t * const connector_ptr, size_t const size, connector_static_buffer_id_t const buffer_id, void ** const ptr)
+#if defined CONNECTOR_MSG_SERVICE
+STATIC unsigned int msg_session_table_static_size(void)
 {
-    connector_status_t status = connector_working;
+    return MSG_SESSION_TABLE_SIZE;
+}
+#endif
 
-    UNUSED_PARAMETER(connector_ptr);
-    UNUSED_PARAMETER(size);
+STATIC unsigned int static_pool_size(connector_static_pool_t const pool)
+{
+    unsigned int size = 0;
 
-    if (buffer_id != named_buffer_id(connector_data))
+    switch (pool)
     {
-        ASSERT(connector_ptr == &named_buffer_storage(connector_data));
+#if defined CONNECTOR_MSG_SERVICE
+    case named_pool_id(msg_facility):
+        size = named_buffer_cnt(msg_facility);
+        break;
+
+    case named_pool_id(msg_session):
+        size = named_buffer_cnt(msg_session);
+        break;
+
+    case named_pool_id(msg_service):
+        size = named_buffer_cnt(msg_service);
+        break;
+#endif
+
+#if defined CONNECTOR_TRANSPORT_TCP && defined CONNECTOR_DATA_SERVICE
+    case named_pool_id(msg_session_client):
+        size = named_buffer_cnt(msg_session_client);
+        break;
+
+    case named_pool_id(put_request):
+        size = named_buffer_cnt(put_request);
+        break;
+
+#if defined CONNECTOR_DATA_POINTS
+    case named_pool_id(data_point_block):
+        size = named_buffer_cnt(data_point_block);
+        break;
+#endif
+#endif
+
+#if defined CONNECTOR_TRANSPORT_UDP || defined CONNECTOR_TRANSPORT_SMS
+    case named_pool_id(sm_session):
+        size = named_buffer_cnt(sm_session);
+        break;
+
+    case named_pool_id(sm_packet):
+        size = named_buffer_cnt(sm_packet);
+        break;
+
+    case named_pool_id(sm_data_block):
+        size = named_buffer_cnt(sm_data_block);
+        break;
+#endif
+
+#if defined CONNECTOR_COMPRESSION
+    case named_pool_id(zlib_stream):
+        size = named_buffer_cnt(zlib_stream);
+        break;
+#endif
+
+    default:
+        break;
     }
+    return size;
+}
+
+STATIC connector_status_t malloc_static_data(connector_data_t * const connector_ptr, size_t const size, connector_static_buffer_id_t const buffer_id, void ** const ptr)
+{
+    connector_status_t status = connector_working;
+    connector_static_mem_t * const static_mem = get_static_mem(connector_ptr);
+
+    UNUSED_PARAMETER(size);
 
     switch(buffer_id)
     {
@@ -393,6 +534,10 @@ STATIC connector_status_t malloc_static_data(connector_data_t * const connector_
 #endif
 
 #if defined CONNECTOR_MSG_SERVICE
+    case named_buffer_id(msg_session_table):
+        malloc_named_static_buffer(msg_session_table, size, ptr, status);
+        break;
+
     case named_buffer_id(msg_facility):
         malloc_named_array_element(msg_facility, size, ptr, status);
         break;
@@ -437,6 +582,12 @@ STATIC connector_status_t malloc_static_data(connector_data_t * const connector_
         break;
 #endif
 
+#if defined CONNECTOR_COMPRESSION
+    case named_buffer_id(zlib_stream):
+        malloc_named_array_element(zlib_stream, size, ptr, status);
+        break;
+#endif
+
     default:
         ASSERT(connector_false);
         *ptr = NULL;
@@ -447,7 +598,8 @@ STATIC connector_status_t malloc_static_data(connector_data_t * const connector_
 
 void free_static_data(connector_data_t * const connector_ptr, connector_static_buffer_id_t const buffer_id, void * const ptr)
 {
-    UNUSED_PARAMETER(connector_ptr);
+    connector_static_mem_t * const static_mem = get_static_mem(connector_ptr);
+
     UNUSED_PARAMETER(ptr);
     ASSERT(connector_ptr == &named_buffer_storage(connector_data));
 
@@ -469,6 +621,10 @@ void free_static_data(connector_data_t * const connector_ptr, connector_static_b
 #endif
 
 #if defined CONNECTOR_MSG_SERVICE
+    case named_buffer_id(msg_session_table):
+        free_named_static_buffer(msg_session_table);
+        break;
+
     case named_buffer_id(msg_facility):
         free_named_array_element(msg_facility, ptr);
         break;
@@ -521,6 +677,12 @@ void free_static_data(connector_data_t * const connector_ptr, connector_static_b
         break;
 #endif
 
+#if defined CONNECTOR_COMPRESSION
+    case named_buffer_id(zlib_stream):
+        free_named_array_element(zlib_stream, ptr);
+        break;
+#endif
+
     default:
         break;
     }
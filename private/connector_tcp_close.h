@@ -88,7 +88,8 @@ STATIC connector_status_t tcp_close_cloud(connector_data_t * const connector_ptr
                 connector_ptr->edp_data.stop.auto_connect = close_data.reconnect;
                 edp_set_active_state(connector_ptr, connector_transport_idle);
 
-                tcp_send_complete_callback(connector_ptr, connector_abort);
+                while (tcp_is_send_active(connector_ptr))
+                    tcp_send_complete_callback(connector_ptr, connector_abort);
 
         }
         layer_remove_facilities(connector_ptr, facility_callback_cleanup);
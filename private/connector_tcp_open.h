@@ -253,16 +253,11 @@ STATIC connector_status_t send_keepalive(connector_data_t * const connector_ptr)
         size_t const len = build_keepalive_param(ptr, keepalive_parameters[i].type, keepalive_parameters[i].value);
         ptr += len;
     }
-    /* Setting the total_length will enable tcp_send_packet_process.
-     * Clear length to 0 for actual length that has been sent.
-     */
+    /* Queueing the packet will enable tcp_send_packet_process. */
     {
         size_t const total_packet_length = (size_t)(ptr - start_ptr);
         ASSERT(ptr > start_ptr);
-        connector_ptr->edp_data.send_packet.total_length = total_packet_length;
-        connector_ptr->edp_data.send_packet.bytes_sent = 0;
-        connector_ptr->edp_data.send_packet.ptr = packet;
-        connector_ptr->edp_data.send_packet.complete_cb = tcp_release_packet_buffer;
+        result = tcp_queue_send_frame(connector_ptr, packet, total_packet_length, tcp_release_packet_buffer, NULL);
     }
 
 done:
@@ -855,9 +850,7 @@ STATIC connector_status_t edp_tcp_open_process(connector_data_t * const connecto
         case connector_working:
             edp_set_edp_state(connector_ptr, edp_configuration_init);
             connector_ptr->edp_data.send_packet.packet_buffer.in_use = connector_false;
-            connector_ptr->edp_data.receive_packet.packet_buffer.in_use = connector_false;
-            connector_ptr->edp_data.receive_packet.packet_buffer.next = NULL;
-            connector_ptr->edp_data.receive_packet.free_packet_buffer = &connector_ptr->edp_data.receive_packet.packet_buffer;
+            tcp_init_receive_packet(connector_ptr);
             break;
         case connector_unavailable:
             edp_set_active_state(connector_ptr, connector_transport_idle);
@@ -17,6 +17,18 @@
  * =======================================================================
  */
 
+STATIC void tcp_init_receive_packet(connector_data_t * const connector_ptr)
+{
+    connector_ptr->edp_data.receive_packet.packet_buffer.buffer = NULL;
+    connector_ptr->edp_data.receive_packet.packet_buffer.in_use = connector_false;
+    connector_ptr->edp_data.receive_packet.packet_buffer.next = NULL;
+    connector_ptr->edp_data.receive_packet.free_packet_buffer = &connector_ptr->edp_data.receive_packet.packet_buffer;
+
+    connector_ptr->edp_data.receive_packet.start = 0;
+    connector_ptr->edp_data.receive_packet.head = 0;
+    connector_ptr->edp_data.receive_packet.tail = 0;
+}
+
 STATIC connector_buffer_t * tcp_new_receive_packet(connector_data_t * const connector_ptr)
 {
     connector_buffer_t * buffer_ptr;
@@ -43,12 +55,17 @@ STATIC void tcp_release_receive_packet(connector_data_t * const connector_ptr, c
     {
         connector_buffer_t * const buffer_ptr = (connector_buffer_t *)packet;
 
+        buffer_ptr->buffer = NULL;
         buffer_ptr->next = connector_ptr->edp_data.receive_packet.free_packet_buffer;
         connector_ptr->edp_data.receive_packet.free_packet_buffer = buffer_ptr;
+
+        /* the frame slice and any keepalive parsed behind it are consumed */
+        connector_ptr->edp_data.receive_packet.start = connector_ptr->edp_data.receive_packet.head;
     }
     return;
 }
 
+#define tcp_is_receive_packet_held(connector_ptr)   connector_bool((connector_ptr)->edp_data.receive_packet.free_packet_buffer == NULL)
 
 STATIC connector_callback_status_t tcp_receive_buffer(connector_data_t * const connector_ptr, uint8_t  * const buffer, size_t * const length)
 {
@@ -91,7 +108,7 @@ STATIC connector_callback_status_t tcp_receive_buffer(connector_data_t * const c
         if (read_data.bytes_used > 0 || connector_ptr->edp_data.keepalive.last_tx_received_time == 0)
         {
             /* Retain the "last (tx keepalive) message send" time. */
-            if (get_system_time(connector_ptr, &connector_ptr->edp_data.keepalive.last_tx_received_time) != connector_working)
+            if (get_system_time_in_milliseconds(connector_ptr, &connector_ptr->edp_data.keepalive.last_tx_received_time) != connector_working)
             {
                 status = connector_callback_abort;
             }
@@ -115,7 +132,7 @@ STATIC connector_callback_status_t tcp_receive_buffer(connector_data_t * const c
         unsigned long const tx_keepalive_interval = GET_TX_KEEPALIVE_INTERVAL(connector_ptr);
 
         unsigned long const wait_count = connector_ptr->edp_data.keepalive.miss_tx_count + UINT32_C(1);
-        unsigned long const max_timeout = (tx_keepalive_interval * wait_count);
+        unsigned long const max_timeout = (tx_keepalive_interval * wait_count * UINT32_C(1000));
 
         if (!is_valid_timing_limit(connector_ptr, connector_ptr->edp_data.keepalive.last_tx_received_time, max_timeout))
         {
@@ -150,47 +167,57 @@ done:
 }
 
 
-STATIC connector_callback_status_t tcp_receive_data_status(connector_data_t * const connector_ptr)
+STATIC connector_callback_status_t tcp_receive_ring_fill(connector_data_t * const connector_ptr, size_t const frame_length)
 {
-    connector_callback_status_t status = connector_callback_continue;
-
-    /* send data if we have more data to send */
-    if (connector_ptr->edp_data.receive_packet.bytes_received < connector_ptr->edp_data.receive_packet.total_length)
+    connector_callback_status_t status = connector_callback_busy;
+    uint8_t * const ring = connector_ptr->edp_data.receive_packet.ring;
+    size_t const ring_size = sizeof connector_ptr->edp_data.receive_packet.ring;
+    size_t const start = connector_ptr->edp_data.receive_packet.start;
+    size_t length;
+
+    /* Read as much as the ring can take so several frames arrive
+     * in one network receive callback. The ring can only be rearranged
+     * when no facility holds a frame slice out of it.
+     */
+    if (!tcp_is_receive_packet_held(connector_ptr))
     {
-        uint8_t * const buf = connector_ptr->edp_data.receive_packet.ptr + connector_ptr->edp_data.receive_packet.bytes_received;
-        size_t length = connector_ptr->edp_data.receive_packet.total_length - connector_ptr->edp_data.receive_packet.bytes_received;
-        status = tcp_receive_buffer(connector_ptr, buf, &length);
-
-        if (status == connector_callback_continue)
+        if (start == connector_ptr->edp_data.receive_packet.tail)
         {
-            connector_ptr->edp_data.receive_packet.bytes_received += length;
+            connector_ptr->edp_data.receive_packet.start = 0;
+            connector_ptr->edp_data.receive_packet.head = 0;
+            connector_ptr->edp_data.receive_packet.tail = 0;
         }
-        else if (status != connector_callback_busy)
+        else if (start > 0 && start + frame_length > ring_size)
         {
-            goto done;
+            /* move the partial frame to the front so it is contiguous */
+            size_t const partial_length = connector_ptr->edp_data.receive_packet.tail - start;
+
+            memmove(ring, ring + start, partial_length);
+            connector_ptr->edp_data.receive_packet.head -= start;
+            connector_ptr->edp_data.receive_packet.tail = partial_length;
+            connector_ptr->edp_data.receive_packet.start = 0;
         }
     }
 
-    if (connector_ptr->edp_data.receive_packet.bytes_received < connector_ptr->edp_data.receive_packet.total_length)
+    length = ring_size - connector_ptr->edp_data.receive_packet.tail;
+    if (length > 0)
     {
-        /* still more data */
-        status = connector_callback_busy;
+        status = tcp_receive_buffer(connector_ptr, ring + connector_ptr->edp_data.receive_packet.tail, &length);
+
+        if (status == connector_callback_continue)
+        {
+            connector_ptr->edp_data.receive_packet.tail += length;
+            if (length == 0)
+                status = connector_callback_busy;
+        }
     }
-done:
+
     return status;
 }
 
 
 STATIC connector_status_t tcp_receive_packet(connector_data_t * const connector_ptr, connector_buffer_t ** packet)
 {
-    enum {
-        receive_packet_init,
-        receive_packet_type,
-        receive_packet_length,
-        receive_packet_data,
-        receive_packet_complete
-    };
-
     connector_status_t result = connector_idle;
 
     *packet = NULL;
@@ -214,98 +241,24 @@ STATIC connector_status_t tcp_receive_packet(connector_data_t * const connector_
      * the input stream.
      */
 
-    /* we have to read 3 times to get a complete packet.
-     * 1. read message type
-     * 2. read message length
-     * 3. read actual message data
-     *
-     * So we use index == receive_packet_init to initialize the packet before starting reading.
-     * When index == receive_packet_type, set to receive message type. After message type is received,
-     * we must check valid message type.
-     *
-     * When index == receive_packet_length, set to receive message length.
-     * When index == receive_packet_data, set to receive message data.
-     * When index == receive_packet_complete, message data is completely received and
-     * reset index = receive_packet_init and exit.
+    /* Frames are parsed straight out of the receive ring. A complete frame
+     * (type, length and data) is passed to the caller as a slice of the ring
+     * starting at its MT header, which has the same layout as the EDP header
+     * the facilities expect, so no data is copied.
      *
+     * The network is only read when the ring does not hold a complete frame.
      */
-    while (connector_ptr->edp_data.receive_packet.index <= receive_packet_complete)
+    for (;;)
     {
-        connector_callback_status_t status = connector_callback_continue;
+        size_t const available = connector_ptr->edp_data.receive_packet.tail - connector_ptr->edp_data.receive_packet.head;
+        size_t frame_length = PACKET_EDP_HEADER_SIZE;
+        connector_callback_status_t status;
 
-        if (connector_ptr->edp_data.receive_packet.index != receive_packet_init)
-        {   /* continue for any pending receive */
-            status = tcp_receive_data_status(connector_ptr);
-
-            switch (status)
-            {
-                case connector_callback_continue:
-                    break;
-                case connector_callback_busy:
-                    result = (connector_ptr->edp_data.receive_packet.index <= receive_packet_length) ? connector_idle : connector_pending;
-                    goto done;
-                case connector_callback_error:
-                    result = connector_unavailable;
-                    goto done;
-                case connector_callback_abort:
-                    edp_set_close_status(connector_ptr, connector_close_status_abort);
-                    result = connector_abort;
-                    goto done;
-                default:
-                    ASSERT(connector_false);
-            }
-        }
-        result = connector_pending;
-
-        switch (connector_ptr->edp_data.receive_packet.index)
+        if (available >= PACKET_EDP_HEADER_SIZE)
         {
-        case receive_packet_init:
-            /* initialize and setup packet for receive */
-            connector_ptr->edp_data.receive_packet.packet_type = 0;
-            connector_ptr->edp_data.receive_packet.packet_length = 0;
-            connector_ptr->edp_data.receive_packet.bytes_received = 0;
-            connector_ptr->edp_data.receive_packet.total_length = 0;
-            connector_ptr->edp_data.receive_packet.index = 0;
-
-            if (edp_get_active_state(connector_ptr) == connector_transport_open)
-            {
-                /* We are still in edp connection process.
-                 * So we need to setup the packet for any message
-                 * during edp connection process since no facility is
-                 * running.
-                 * Otherwise, we setup the packet in receive_packet_data index
-                 * to receive actual data. Otherwise, we don't have actual
-                 * data received but we need to be able to receive keepalive.
-                 */
-                connector_ptr->edp_data.receive_packet.data_packet = tcp_new_receive_packet(connector_ptr);
-                if (connector_ptr->edp_data.receive_packet.data_packet == NULL)
-                {
-                    result = connector_idle;
-                    goto done;
-                }
-            }
-
-            connector_ptr->edp_data.receive_packet.index++;
-            break;
-
-        case receive_packet_type:
-            /* set to read the message type */
-            connector_ptr->edp_data.receive_packet.ptr = (uint8_t *)&connector_ptr->edp_data.receive_packet.packet_type;
-            connector_ptr->edp_data.receive_packet.bytes_received = 0;
-            connector_ptr->edp_data.receive_packet.total_length = sizeof connector_ptr->edp_data.receive_packet.packet_type;
-            connector_ptr->edp_data.receive_packet.index++;
-            break;
-
-        case receive_packet_length:
-        {
-            /* Got message type let's get to message length.
-             * So make sure we support the message type.
-             * Then, set to read message length.
-             */
-            uint16_t type_val;
-
-            type_val = FROM_BE16(connector_ptr->edp_data.receive_packet.packet_type);
-            connector_ptr->edp_data.receive_packet.packet_type = type_val;
+            uint8_t * const edp_header = connector_ptr->edp_data.receive_packet.ring + connector_ptr->edp_data.receive_packet.head;
+            uint16_t const type_val = message_load_be16(edp_header, type);
+            uint16_t const packet_length = message_load_be16(edp_header, length);
 
             switch (type_val)
             {
@@ -334,19 +287,7 @@ STATIC connector_status_t tcp_receive_packet(connector_data_t * const connector_
                     break;
              }
 
-            /* set up to read message length */
-            connector_ptr->edp_data.receive_packet.ptr = (uint8_t *)&connector_ptr->edp_data.receive_packet.packet_length;
-            connector_ptr->edp_data.receive_packet.bytes_received = 0;
-            connector_ptr->edp_data.receive_packet.total_length = sizeof connector_ptr->edp_data.receive_packet.packet_length;
-            connector_ptr->edp_data.receive_packet.index++;
-            break;
-        }
-        case receive_packet_data:
-        {
-            /* got packet length so set to read message data */
-            uint16_t packet_length = FROM_BE16(connector_ptr->edp_data.receive_packet.packet_length);
-
-            if (connector_ptr->edp_data.receive_packet.packet_type != E_MSG_MT2_TYPE_PAYLOAD)
+            if (type_val != E_MSG_MT2_TYPE_PAYLOAD && packet_length != 0)
             {
                 /*
                  * For all but payload messages, the length field value should be
@@ -357,66 +298,73 @@ STATIC connector_status_t tcp_receive_packet(connector_data_t * const connector_
                  *    E_MSG_MT2_TYPE_CLOUD_OVERLOAD
                  *    E_MSG_MT2_TYPE_KA_KEEPALIVE
                  */
-                if (packet_length != 0)
-                {
-                    connector_debug_line("connector_get_receive_packet: Invalid payload");
-                }
+                connector_debug_line("connector_get_receive_packet: Invalid payload");
             }
 
-
-            if (packet_length == 0)
+            if (packet_length > (MSG_MAX_RECV_PACKET_SIZE - PACKET_EDP_HEADER_SIZE))
             {
-                /* set to complete data since no data to be read. */
-                connector_ptr->edp_data.receive_packet.index = receive_packet_complete;
-                connector_ptr->edp_data.receive_packet.packet_length = packet_length;
-                connector_ptr->edp_data.receive_packet.total_length = packet_length;
+                connector_debug_line("tcp_receive_packet: packet length %u exceeds MSG_MAX_RECV_PACKET_SIZE", (unsigned) packet_length);
+                edp_set_close_status(connector_ptr, connector_close_status_abort);
+                result = connector_abort;
+                goto done;
             }
-            else
+
+            frame_length = PACKET_EDP_HEADER_SIZE + packet_length;
+
+            if (available >= frame_length)
             {
-                /*
-                 * Read the actual message data bytes into the packet buffer.
+                /* During the edp connection process every message except keepalive
+                 * is returned. Once established, only messages with data are.
                  */
-                ASSERT(packet_length <= (sizeof connector_ptr->edp_data.receive_packet.packet_buffer.buffer - PACKET_EDP_HEADER_SIZE));
+                connector_bool_t const deliver = connector_bool(type_val != E_MSG_MT2_TYPE_KA_KEEPALIVE &&
+                                                                (packet_length > 0 || edp_get_active_state(connector_ptr) == connector_transport_open));
 
-                if (edp_get_active_state(connector_ptr) != connector_transport_open)
+                if (deliver)
                 {
-                    /* We already setup data_packet in
-                     * receive_packet_init index. So we setup data_packet when we
-                     * are already established the EDP.
-                     */
-                    connector_ptr->edp_data.receive_packet.data_packet = tcp_new_receive_packet(connector_ptr);
-                    if (connector_ptr->edp_data.receive_packet.data_packet == NULL)
+                    connector_buffer_t * const data_packet = tcp_new_receive_packet(connector_ptr);
+
+                    if (data_packet == NULL)
                     {
+                        /* a facility still holds the previous frame */
+                        result = connector_pending;
                         goto done;
                     }
+                    data_packet->buffer = edp_header;
+                    *packet = data_packet;
+                    result = connector_working;
                 }
 
-                connector_ptr->edp_data.receive_packet.packet_length = packet_length;
-                connector_ptr->edp_data.receive_packet.total_length = packet_length;
-
-                connector_ptr->edp_data.receive_packet.ptr = GET_PACKET_DATA_POINTER(connector_ptr->edp_data.receive_packet.data_packet->buffer, PACKET_EDP_HEADER_SIZE);
-                connector_ptr->edp_data.receive_packet.bytes_received = 0;
-                connector_ptr->edp_data.receive_packet.index++;
+                connector_ptr->edp_data.receive_packet.head += frame_length;
+                if (!tcp_is_receive_packet_held(connector_ptr))
+                {
+                    connector_ptr->edp_data.receive_packet.start = connector_ptr->edp_data.receive_packet.head;
+                }
 
+                if (deliver) goto done;
+                continue;
             }
-            break;
         }
-        case receive_packet_complete:
-
-            if (connector_ptr->edp_data.receive_packet.data_packet != NULL &&
-                connector_ptr->edp_data.receive_packet.packet_type != E_MSG_MT2_TYPE_KA_KEEPALIVE)
-            {
-                uint8_t * edp_header = connector_ptr->edp_data.receive_packet.data_packet->buffer;
-                /* got message data. Let's set edp header */
-                message_store_be16(edp_header, type, connector_ptr->edp_data.receive_packet.packet_type);
-                message_store_be16(edp_header, length, connector_ptr->edp_data.receive_packet.packet_length);
-                *packet = connector_ptr->edp_data.receive_packet.data_packet;
-                result = connector_working;
-            }
 
-            connector_ptr->edp_data.receive_packet.index = receive_packet_init;
-            goto done;
-        } /* switch */
+        status = tcp_receive_ring_fill(connector_ptr, frame_length);
+        switch (status)
+        {
+            case connector_callback_continue:
+                break;
+            case connector_callback_busy:
+                result = (connector_ptr->edp_data.receive_packet.tail - connector_ptr->edp_data.receive_packet.head < PACKET_EDP_HEADER_SIZE) ? connector_idle : connector_pending;
+                goto done;
+            case connector_callback_error:
+                result = connector_unavailable;
+                goto done;
+            case connector_callback_abort:
+                edp_set_close_status(connector_ptr, connector_close_status_abort);
+                result = connector_abort;
+                goto done;
+            default:
+                ASSERT(connector_false);
+                result = connector_abort;
+                goto done;
+        }
     }
 
 done:
@@ -27,7 +27,35 @@
 #define DISC_OP_INITCOMPLETE  5
 #define DISC_OP_VENDOR_ID     6
 
-#define tcp_is_send_active(connector_ptr)   connector_bool(connector_ptr->edp_data.send_packet.total_length > 0)
+#define tcp_is_send_active(connector_ptr)   connector_bool(connector_ptr->edp_data.send_packet.count > 0)
+#define tcp_is_send_queue_full(connector_ptr)   connector_bool(connector_ptr->edp_data.send_packet.count >= EDP_SEND_QUEUE_SIZE)
+#define tcp_send_frame(connector_ptr, index)    (&(connector_ptr)->edp_data.send_packet.frame[((connector_ptr)->edp_data.send_packet.head + (index)) % EDP_SEND_QUEUE_SIZE])
+
+STATIC connector_status_t tcp_queue_send_frame(connector_data_t * const connector_ptr, uint8_t * const packet, size_t const length,
+                                               send_complete_cb_t send_complete_cb, void * const user_data)
+{
+    connector_status_t status = connector_working;
+    edp_send_frame_t * frame;
+
+    if (tcp_is_send_queue_full(connector_ptr))
+    {
+        status = connector_pending;
+        goto done;
+    }
+
+    frame = tcp_send_frame(connector_ptr, connector_ptr->edp_data.send_packet.count);
+    frame->ptr = packet;
+    frame->total_length = length;
+    frame->bytes_sent = 0;
+    frame->complete_cb = send_complete_cb;
+    frame->user_data = user_data;
+    frame->file.handle = 0;
+    frame->file.length = 0;
+    connector_ptr->edp_data.send_packet.count++;
+
+done:
+    return status;
+}
 
 STATIC connector_status_t tcp_initiate_send_packet(connector_data_t * const connector_ptr, uint8_t * const edp_header,
                                                     size_t const length, uint16_t const type,
@@ -42,9 +70,9 @@ STATIC connector_status_t tcp_initiate_send_packet(connector_data_t * const conn
     ASSERT_GOTO(edp_header != NULL, done);
     ASSERT_GOTO(length <= UINT16_MAX, done);
 
-    if (connector_ptr->edp_data.send_packet.total_length > 0)
+    if (tcp_is_send_queue_full(connector_ptr))
     {
-        /* connector_debug_line("tcp_initiate_send_packet: unable to trigger another send since previous data is still pending"); */
+        /* connector_debug_line("tcp_initiate_send_packet: unable to queue another send since the send queue is full"); */
         status = connector_pending;
         goto done;
     }
@@ -63,10 +91,6 @@ STATIC connector_status_t tcp_initiate_send_packet(connector_data_t * const conn
      *
     */
 
-    /* total bytes to be sent to Device Cloud (packet data length + the edp header length) */
-    connector_ptr->edp_data.send_packet.total_length = length + PACKET_EDP_HEADER_SIZE;
-    connector_ptr->edp_data.send_packet.ptr = edp_header;
-
     message_store_be16(edp_header, type, type);
 
     {
@@ -76,10 +100,9 @@ STATIC connector_status_t tcp_initiate_send_packet(connector_data_t * const conn
         message_store_be16(edp_header, length, length16);
     }
 
-    /* clear the actual number of bytes to be sent */
-    connector_ptr->edp_data.send_packet.bytes_sent = 0;
-    connector_ptr->edp_data.send_packet.complete_cb = send_complete_cb;
-    connector_ptr->edp_data.send_packet.user_data = user_data;
+    /* total bytes to be sent to Device Cloud (packet data length + the edp header length) */
+    status = tcp_queue_send_frame(connector_ptr, edp_header, length + PACKET_EDP_HEADER_SIZE, send_complete_cb, user_data);
+
 done:
     return status;
 }
@@ -115,28 +138,43 @@ STATIC connector_status_t tcp_initiate_send_facility_packet(connector_data_t * c
                                 user_data);
 }
 
-STATIC connector_callback_status_t tcp_send_buffer(connector_data_t * const connector_ptr, uint8_t * const buffer, size_t * const length)
+STATIC connector_status_t tcp_initiate_send_facility_file(connector_data_t * const connector_ptr, uint8_t * const edp_header,
+                                                           size_t const length, uint16_t const facility,
+                                                           connector_filesystem_file_handle_t const file_handle, size_t const file_length,
+                                                           send_complete_cb_t send_complete_cb, void * const user_data)
+{
+    /* the EDP length covers the buffer and the file region that follows it */
+    connector_status_t const status = tcp_initiate_send_facility_packet(connector_ptr, edp_header, (length + file_length),
+                                                                        facility, send_complete_cb, user_data);
+
+    if (status == connector_working)
+    {
+        edp_send_frame_t * const frame = tcp_send_frame(connector_ptr, connector_ptr->edp_data.send_packet.count - 1);
+
+        frame->total_length -= file_length;
+        frame->file.handle = file_handle;
+        frame->file.length = file_length;
+    }
+
+    return status;
+}
+
+STATIC connector_callback_status_t tcp_send_callback(connector_data_t * const connector_ptr, connector_request_id_network_t const network_request,
+                                                     void * const data, size_t const * const bytes_used, size_t * const length)
 {
     connector_callback_status_t status;
-    connector_network_send_t send_data;
     connector_request_id_t request_id;
 
-    send_data.buffer = buffer;
-    send_data.bytes_available = *length;
-    send_data.bytes_used = 0;
-    send_data.handle = connector_ptr->edp_data.network_handle;
-
-    request_id.network_request = connector_request_id_network_send;
-    status = connector_callback(connector_ptr->callback, connector_class_id_network_tcp, request_id, &send_data, connector_ptr->context);
-    ASSERT(status != connector_callback_unrecognized);
+    request_id.network_request = network_request;
+    status = connector_callback(connector_ptr->callback, connector_class_id_network_tcp, request_id, data, connector_ptr->context);
     switch (status)
     {
     case connector_callback_continue:
-        *length = send_data.bytes_used;
+        *length = *bytes_used;
         if (*length > 0)
         {
             /* Retain the "last (RX) message send" time. */
-            if (get_system_time(connector_ptr, &connector_ptr->edp_data.keepalive.last_rx_sent_time) != connector_working)
+            if (get_system_time_in_milliseconds(connector_ptr, &connector_ptr->edp_data.keepalive.last_rx_sent_time) != connector_working)
             {
                 status = connector_callback_abort;
             }
@@ -146,6 +184,10 @@ STATIC connector_callback_status_t tcp_send_buffer(connector_data_t * const conn
         *length = 0;
         break;
     case connector_callback_unrecognized:
+        /* only the vector request is optional, send file is probed in tcp_is_send_file_supported() */
+        if (network_request == connector_request_id_network_send_vector)
+            break;
+        ASSERT(connector_false);
         status = connector_callback_abort;
         /* no break */
     case connector_callback_abort:
@@ -158,6 +200,83 @@ STATIC connector_callback_status_t tcp_send_buffer(connector_data_t * const conn
     return status;
 }
 
+STATIC connector_callback_status_t tcp_send_buffer(connector_data_t * const connector_ptr, uint8_t * const buffer, size_t * const length)
+{
+    connector_network_send_t send_data;
+
+    send_data.buffer = buffer;
+    send_data.bytes_available = *length;
+    send_data.bytes_used = 0;
+    send_data.handle = connector_ptr->edp_data.network_handle;
+
+    return tcp_send_callback(connector_ptr, connector_request_id_network_send, &send_data, &send_data.bytes_used, length);
+}
+
+STATIC connector_callback_status_t tcp_send_vector(connector_data_t * const connector_ptr, size_t * const length)
+{
+    connector_network_iovec_t vector[EDP_SEND_QUEUE_SIZE];
+    connector_network_send_vector_t send_data;
+    unsigned int const count = connector_ptr->edp_data.send_packet.count;
+    unsigned int i;
+
+    /* one fragment per queued frame, so all of them can go out in one gather write */
+    for (i = 0; i < count; i++)
+    {
+        edp_send_frame_t const * const frame = tcp_send_frame(connector_ptr, i);
+
+        vector[i].buffer = frame->ptr + frame->bytes_sent;
+        vector[i].length = frame->total_length;
+
+        /* a file region must go out before anything queued behind it */
+        if (frame->file.length > 0)
+        {
+            i++;
+            break;
+        }
+    }
+
+    send_data.handle = connector_ptr->edp_data.network_handle;
+    send_data.vector = vector;
+    send_data.vector_count = i;
+    send_data.bytes_used = 0;
+
+    return tcp_send_callback(connector_ptr, connector_request_id_network_send_vector, &send_data, &send_data.bytes_used, length);
+}
+
+STATIC connector_callback_status_t tcp_send_file(connector_data_t * const connector_ptr, edp_send_frame_t const * const frame, size_t * const length)
+{
+    connector_network_send_file_t send_data;
+
+    send_data.handle = connector_ptr->edp_data.network_handle;
+    send_data.file_handle = frame->file.handle;
+    send_data.bytes_available = frame->file.length;
+    send_data.bytes_used = 0;
+
+    return tcp_send_callback(connector_ptr, connector_request_id_network_send_file, &send_data, &send_data.bytes_used, length);
+}
+
+STATIC connector_bool_t tcp_is_send_file_supported(connector_data_t * const connector_ptr)
+{
+    if (connector_ptr->edp_data.send_packet.send_file == edp_send_file_unknown)
+    {
+        /* ask once with an empty request, anything but continue keeps the buffered path */
+        connector_network_send_file_t send_data;
+        connector_request_id_t request_id;
+        connector_callback_status_t status;
+
+        send_data.handle = connector_ptr->edp_data.network_handle;
+        send_data.file_handle = 0;
+        send_data.bytes_available = 0;
+        send_data.bytes_used = 0;
+
+        request_id.network_request = connector_request_id_network_send_file;
+        status = connector_callback(connector_ptr->callback, connector_class_id_network_tcp, request_id, &send_data, connector_ptr->context);
+        connector_ptr->edp_data.send_packet.send_file = (status == connector_callback_continue) ? edp_send_file_supported : edp_send_file_unsupported;
+    }
+
+    return connector_bool(connector_ptr->edp_data.send_packet.send_file == edp_send_file_supported);
+}
+
 STATIC connector_status_t tcp_release_packet_buffer(connector_data_t * const connector_ptr, uint8_t const * const packet, connector_status_t const status, void * const user_data)
 {
     /* this is called when the Connector is done sending or after tcp_get_packet_buffer()
@@ -192,8 +311,8 @@ STATIC uint8_t * tcp_get_packet_buffer(connector_data_t * const connector_ptr, u
      */
 
 
-     /* make sure no send is pending */
-    if ((connector_ptr->edp_data.send_packet.total_length == 0) &&
+     /* make sure the buffer is free and its packet can be queued */
+    if (!tcp_is_send_queue_full(connector_ptr) &&
         (!connector_ptr->edp_data.send_packet.packet_buffer.in_use))
     {
         connector_ptr->edp_data.send_packet.packet_buffer.in_use = connector_true;
@@ -257,7 +376,7 @@ STATIC connector_status_t tcp_rx_keepalive_process(connector_data_t * const conn
      *
      * last_rx_keepalive_time is last time we sent Rx keepalive.
      */
-    if (is_valid_timing_limit(connector_ptr, connector_ptr->edp_data.keepalive.last_rx_sent_time, GET_RX_KEEPALIVE_INTERVAL(connector_ptr)))
+    if (is_valid_timing_limit(connector_ptr, connector_ptr->edp_data.keepalive.last_rx_sent_time, GET_RX_KEEPALIVE_INTERVAL(connector_ptr) * UINT32_C(1000)))
     {
         /* not expired yet. no need to send rx keepalive */
         goto done;
@@ -274,15 +393,55 @@ done:
 STATIC connector_status_t tcp_send_complete_callback(connector_data_t * const connector_ptr, connector_status_t status)
 {
     connector_status_t result = connector_working;
-    send_complete_cb_t callback = connector_ptr->edp_data.send_packet.complete_cb;
+    edp_send_frame_t const frame = *tcp_send_frame(connector_ptr, 0);
+
+    ASSERT_GOTO(tcp_is_send_active(connector_ptr), done);
 
-    if (callback != NULL)
+    /* dequeue first, the callback may queue the next frame */
+    connector_ptr->edp_data.send_packet.head = (connector_ptr->edp_data.send_packet.head + 1) % EDP_SEND_QUEUE_SIZE;
+    connector_ptr->edp_data.send_packet.count--;
+
+    if (frame.complete_cb != NULL)
     {
-        connector_ptr->edp_data.send_packet.complete_cb = NULL;
-        result = callback(connector_ptr, connector_ptr->edp_data.send_packet.ptr, status, connector_ptr->edp_data.send_packet.user_data);
+        result = frame.complete_cb(connector_ptr, frame.ptr, status, frame.user_data);
         ASSERT(result != connector_pending);
     }
 
+done:
+    return result;
+}
+
+STATIC connector_status_t tcp_send_frames_sent(connector_data_t * const connector_ptr, size_t length)
+{
+    connector_status_t result = connector_pending;
+
+    while ((length > 0) && tcp_is_send_active(connector_ptr))
+    {
+        edp_send_frame_t * const frame = tcp_send_frame(connector_ptr, 0);
+
+        if (frame->total_length > 0)
+        {
+            size_t const bytes = MIN_VALUE(length, frame->total_length);
+
+            frame->total_length -= bytes;
+            frame->bytes_sent += bytes;
+            length -= bytes;
+        }
+        else
+        {
+            size_t const bytes = MIN_VALUE(length, frame->file.length);
+
+            frame->file.length -= bytes;
+            length -= bytes;
+        }
+
+        if ((frame->total_length > 0) || (frame->file.length > 0)) break;
+
+        /* sent completed so let's call the complete callback */
+        result = tcp_send_complete_callback(connector_ptr, connector_success);
+        if (result != connector_working) break;
+    }
+
     return result;
 }
 
@@ -291,35 +450,50 @@ STATIC connector_status_t edp_tcp_send_process(connector_data_t * const connecto
     connector_status_t result = connector_idle;
 
     /* if nothing needs to be sent, check whether we need to send rx keepalive */
-    if (connector_ptr->edp_data.send_packet.total_length == 0)
+    if (!tcp_is_send_active(connector_ptr))
     {
 
         result = tcp_rx_keepalive_process(connector_ptr);
     }
 
-    if (connector_ptr->edp_data.send_packet.total_length > 0)
+    if (tcp_is_send_active(connector_ptr))
     {
         /* We have something to be sent */
+        edp_send_frame_t const * const frame = tcp_send_frame(connector_ptr, 0);
+        connector_callback_status_t status = connector_callback_unrecognized;
+        size_t length = 0;
 
-        uint8_t * const buf = connector_ptr->edp_data.send_packet.ptr + connector_ptr->edp_data.send_packet.bytes_sent;
-        size_t length = connector_ptr->edp_data.send_packet.total_length;
+        if (frame->total_length == 0)
+        {
+            /* only the file region of the first frame is left */
+            ASSERT(frame->file.length > 0);
+            status = tcp_send_file(connector_ptr, frame, &length);
+            if ((status == connector_callback_continue) && (length == 0))
+            {
+                connector_debug_line("edp_tcp_send_process: file ended before its region was sent");
+                status = connector_callback_error;
+            }
+        }
+        else
+        {
+            if ((connector_ptr->edp_data.send_packet.count > 1) && !connector_ptr->edp_data.send_packet.vector_unsupported)
+            {
+                status = tcp_send_vector(connector_ptr, &length);
+                if (status == connector_callback_unrecognized)
+                    connector_ptr->edp_data.send_packet.vector_unsupported = connector_true;
+            }
 
-        connector_callback_status_t const status = tcp_send_buffer(connector_ptr, buf, &length);
+            if (status == connector_callback_unrecognized)
+            {
+                length = frame->total_length;
+                status = tcp_send_buffer(connector_ptr, frame->ptr + frame->bytes_sent, &length);
+            }
+        }
 
         switch (status)
         {
             case connector_callback_continue:
-                connector_ptr->edp_data.send_packet.total_length -= length;
-                connector_ptr->edp_data.send_packet.bytes_sent += length;
-
-                if (connector_ptr->edp_data.send_packet.total_length == 0)
-                {   /* sent completed so let's call the complete callback */
-                    result = tcp_send_complete_callback(connector_ptr, connector_success);
-                }
-                else if (connector_ptr->edp_data.send_packet.total_length > 0)
-                {
-                    result = connector_pending;
-                }
+                result = tcp_send_frames_sent(connector_ptr, length);
                 break;
 
             case connector_callback_busy:
@@ -344,5 +518,3 @@ done:
     return result;
 
 }
-
-
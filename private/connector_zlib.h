@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2014 Digi International Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
+ * =======================================================================
+ */
+#if (defined CONNECTOR_NO_MALLOC)
+/* zlib allocator for CONNECTOR_NO_MALLOC: each stream hands out its own arena and gets it back
+   all at once when the stream is initialized again */
+STATIC voidpf zlib_arena_alloc(voidpf opaque, uInt items, uInt size)
+{
+    zlib_stream_t * const stream = opaque;
+    size_t const words = (((size_t)items * size) + sizeof stream->arena[0] - 1) / sizeof stream->arena[0];
+    voidpf ptr = Z_NULL;
+
+    if (words <= ZLIB_ARENA_WORDS - stream->arena_used)
+    {
+        ptr = &stream->arena[stream->arena_used];
+        stream->arena_used += words;
+    }
+    else
+    {
+        connector_debug_line("zlib_arena_alloc: arena too small for %" PRIsize " bytes", (size_t)items * size);
+    }
+
+    return ptr;
+}
+
+STATIC void zlib_arena_free(voidpf opaque, voidpf ptr)
+{
+    UNUSED_PARAMETER(opaque);
+    UNUSED_PARAMETER(ptr);
+}
+#endif
+
+STATIC connector_status_t zlib_stream_init(zlib_stream_t * const stream, zlib_stream_type_t const type)
+{
+    connector_status_t result = connector_working;
+    int status;
+
+    memset(&stream->zlib, 0, sizeof stream->zlib);
+#if (defined CONNECTOR_NO_MALLOC)
+    stream->arena_used = 0;
+    stream->zlib.zalloc = zlib_arena_alloc;
+    stream->zlib.zfree = zlib_arena_free;
+    stream->zlib.opaque = stream;
+#endif
+
+    if (type == zlib_stream_deflate)
+        status = deflateInit2(&stream->zlib, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS, CONNECTOR_COMPRESSION_MEMORY_LEVEL, Z_DEFAULT_STRATEGY);
+    else
+        status = inflateInit(&stream->zlib);
+
+    if (status == Z_OK)
+        stream->type = type;
+    else
+    {
+        connector_debug_line("zlib_stream_init: %s init failed %d", (type == zlib_stream_deflate) ? "deflate" : "inflate", status);
+        stream->type = zlib_stream_none;
+        result = connector_abort;
+    }
+
+    return result;
+}
+
+STATIC void zlib_stream_end(zlib_stream_t * const stream)
+{
+    switch (stream->type)
+    {
+        case zlib_stream_deflate:
+            deflateEnd(&stream->zlib);
+            break;
+
+        case zlib_stream_inflate:
+            inflateEnd(&stream->zlib);
+            break;
+
+        case zlib_stream_none:
+            break;
+    }
+
+    stream->type = zlib_stream_none;
+}
+
+/* Hands out a reset stream of the requested type, reusing an idle one when possible so the
+   window and hash tables are not allocated for every compressed session */
+STATIC connector_status_t zlib_stream_acquire(connector_data_t * const connector_ptr, zlib_stream_type_t const type, z_streamp * const zlib)
+{
+    connector_zlib_pool_t * const pool = &connector_ptr->zlib_pool;
+    zlib_stream_t * stream = NULL;
+    zlib_stream_t * idle = NULL;
+    connector_status_t result = connector_working;
+
+    for (stream = pool->head; stream != NULL; stream = stream->next)
+    {
+        if (stream->in_use) continue;
+
+        if (stream->type == type)
+            break;
+
+        if (idle == NULL)
+            idle = stream;
+    }
+
+    if (stream != NULL)
+    {
+        int const status = (type == zlib_stream_deflate) ? deflateReset(&stream->zlib) : inflateReset(&stream->zlib);
+
+        if (status != Z_OK)
+        {
+            zlib_stream_end(stream);
+            result = zlib_stream_init(stream, type);
+        }
+    }
+    else if (idle != NULL)
+    {
+        stream = idle;
+        zlib_stream_end(stream);
+        result = zlib_stream_init(stream, type);
+    }
+    else
+    {
+        void * ptr = NULL;
+
+        result = malloc_data_buffer(connector_ptr, sizeof *stream, named_buffer_id(zlib_stream), &ptr);
+        if (result != connector_working)
+            goto done;
+
+        stream = ptr;
+        stream->type = zlib_stream_none;
+        stream->next = pool->head;
+        pool->head = stream;
+        pool->count++;
+        result = zlib_stream_init(stream, type);
+    }
+
+    if (result != connector_working)
+    {
+        /* leave the entry uninitialized but in the pool so it is retried or freed later */
+        stream->in_use = connector_false;
+        goto done;
+    }
+
+    stream->in_use = connector_true;
+    stream->zlib.next_in = Z_NULL;
+    stream->zlib.avail_in = 0;
+    stream->zlib.next_out = Z_NULL;
+    stream->zlib.avail_out = 0;
+    *zlib = &stream->zlib;
+
+done:
+    return result;
+}
+
+STATIC void zlib_stream_free(connector_data_t * const connector_ptr, zlib_stream_t * const stream)
+{
+    connector_zlib_pool_t * const pool = &connector_ptr->zlib_pool;
+    zlib_stream_t ** link = &pool->head;
+
+    while (*link != stream)
+        link = &(*link)->next;
+
+    *link = stream->next;
+    pool->count--;
+
+    zlib_stream_end(stream);
+    free_data_buffer(connector_ptr, named_buffer_id(zlib_stream), stream);
+}
+
+/* Returns a stream to the pool. Streams above CONNECTOR_COMPRESSION_STREAMS are released back to the system. */
+STATIC void zlib_stream_release(connector_data_t * const connector_ptr, z_streamp * const zlib)
+{
+    zlib_stream_t * const stream = (zlib_stream_t *)*zlib;
+
+    if (stream == NULL)
+        goto done;
+
+    ASSERT(stream->in_use);
+    stream->in_use = connector_false;
+    *zlib = NULL;
+
+    if (connector_ptr->zlib_pool.count > CONNECTOR_COMPRESSION_STREAMS)
+        zlib_stream_free(connector_ptr, stream);
+
+done:
+    return;
+}
+
+#if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+static Bytef const zlib_dictionary[] = CONNECTOR_COMPRESSION_DICTIONARY;
+
+/* Primes a freshly acquired deflate stream, the stream header then carries the dictionary's adler32 */
+STATIC connector_status_t zlib_deflate_dictionary(z_streamp const zlib)
+{
+    int const status = deflateSetDictionary(zlib, zlib_dictionary, sizeof zlib_dictionary - 1);
+
+    return (status == Z_OK) ? connector_working : connector_abort;
+}
+#endif
+
+/* inflate() that supplies the preset dictionary when a stream asks for it */
+STATIC int zlib_inflate(z_streamp const zlib, int const flush)
+{
+    int status = inflate(zlib, flush);
+
+#if (defined CONNECTOR_COMPRESSION_DICTIONARY)
+    if (status == Z_NEED_DICT)
+    {
+        /* fails with Z_DATA_ERROR when the stream was compressed with another dictionary */
+        status = inflateSetDictionary(zlib, zlib_dictionary, sizeof zlib_dictionary - 1);
+        if (status == Z_OK)
+            status = inflate(zlib, flush);
+    }
+#endif
+
+    return status;
+}
+
+STATIC void zlib_pool_free(connector_data_t * const connector_ptr)
+{
+    while (connector_ptr->zlib_pool.head != NULL)
+        zlib_stream_free(connector_ptr, connector_ptr->zlib_pool.head);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2014 Digi International Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
+ * =======================================================================
+ */
+#ifndef CONNECTOR_ZLIB_DEF_H
+#define CONNECTOR_ZLIB_DEF_H
+
+#include "zlib.h"
+
+/* Number of zlib streams kept initialized for reuse. With CONNECTOR_NO_MALLOC it is also the
+   number of streams that can be in use at the same time. */
+#if !(defined CONNECTOR_COMPRESSION_STREAMS)
+#define CONNECTOR_COMPRESSION_STREAMS       2
+#endif
+
+/* deflate memLevel, 1 to 9. Each step down halves the hash and pending buffers (8 is zlib's default). */
+#if !(defined CONNECTOR_COMPRESSION_MEMORY_LEVEL)
+#define CONNECTOR_COMPRESSION_MEMORY_LEVEL  8
+#endif
+
+#if (CONNECTOR_COMPRESSION_MEMORY_LEVEL < 1) || (CONNECTOR_COMPRESSION_MEMORY_LEVEL > MAX_MEM_LEVEL)
+#error "CONNECTOR_COMPRESSION_MEMORY_LEVEL must be between 1 and 9"
+#endif
+
+typedef enum
+{
+    zlib_stream_none,
+    zlib_stream_deflate,
+    zlib_stream_inflate
+} zlib_stream_type_t;
+
+#if (defined CONNECTOR_NO_MALLOC)
+/* Worst case deflate state (window, prev, head and pending buffers plus deflate_state itself),
+   an inflate state is always smaller */
+#define ZLIB_ARENA_SIZE     ((1UL << (MAX_WBITS + 2)) + (1UL << (CONNECTOR_COMPRESSION_MEMORY_LEVEL + 9)) + \
+                             (1UL << (CONNECTOR_COMPRESSION_MEMORY_LEVEL + 7)) + 8192)
+
+typedef union
+{
+    void * ptr;
+    unsigned long value;
+} zlib_arena_word_t;
+
+#define ZLIB_ARENA_WORDS    ((ZLIB_ARENA_SIZE + sizeof(zlib_arena_word_t) - 1) / sizeof(zlib_arena_word_t))
+#endif
+
+typedef struct zlib_stream
+{
+    z_stream zlib;  /* must stay first, users only see the z_streamp */
+    zlib_stream_type_t type;
+    connector_bool_t in_use;
+    struct zlib_stream * next;
+#if (defined CONNECTOR_NO_MALLOC)
+    size_t arena_used;
+    zlib_arena_word_t arena[ZLIB_ARENA_WORDS];
+#endif
+} zlib_stream_t;
+
+typedef struct
+{
+    zlib_stream_t * head;
+    size_t count;
+} connector_zlib_pool_t;
+
+#endif
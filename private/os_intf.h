@@ -39,6 +39,8 @@ typedef enum
     named_buffer_id(sm_data_block),
     named_buffer_id(sm_packet),
     named_buffer_id(data_point_block),
+    named_buffer_id(zlib_stream),
+    named_buffer_id(msg_session_table) = 28,
     named_buffer_id(connector_data) = 29,
     named_buffer_id(cc_facility) = 30,
     named_buffer_id(fw_facility) = 31
@@ -116,6 +118,47 @@ STATIC connector_status_t get_system_time(connector_data_t * const connector_ptr
     return result;
 }
 
+STATIC connector_status_t get_system_time_in_milliseconds(connector_data_t * const connector_ptr, unsigned long * const uptime)
+{
+    connector_status_t result = connector_abort;
+
+    *uptime = 0;
+
+    if (!connector_ptr->uptime_in_seconds_only)
+    {
+        connector_callback_status_t status;
+        connector_request_id_t request_id;
+        connector_os_system_up_time_in_milliseconds_t data;
+
+        request_id.os_request = connector_request_id_os_system_up_time_in_milliseconds;
+        status = connector_callback(connector_ptr->callback, connector_class_id_operating_system, request_id, &data, connector_ptr->context);
+        switch (status)
+        {
+        case connector_callback_continue:
+            /* coverity[uninit_use] */
+            *uptime = data.sys_uptime_in_milliseconds;
+            result = connector_working;
+            goto done;
+        case connector_callback_unrecognized:
+            connector_debug_line("get_system_time_in_milliseconds: using system up time in seconds");
+            connector_ptr->uptime_in_seconds_only = connector_true;
+            break;
+        case connector_callback_abort:
+            goto done;
+        default:
+            ASSERT(connector_false);
+            goto done;
+        }
+    }
+
+    /* fallback to the seconds API, the product wraps like a millisecond counter */
+    result = get_system_time(connector_ptr, uptime);
+    *uptime *= 1000;
+
+done:
+    return result;
+}
+
 #if !(defined CONNECTOR_NO_MALLOC)
 STATIC connector_status_t malloc_cb(connector_callback_t const callback, size_t const length, void ** ptr, void * const context)
 {
@@ -253,7 +296,17 @@ STATIC connector_status_t free_data_buffer(connector_data_t * const connector_pt
     return status;
 }
 
-STATIC connector_status_t yield_process(connector_data_t * const connector_ptr, connector_status_t const status)
+STATIC void next_timeout_update(unsigned long const uptime, unsigned long const start, unsigned long const limit, unsigned long * const timeout_in_seconds)
+{
+    /* same elapsed time arithmetic as is_valid_timing_limit() */
+    unsigned long const elapsed = uptime - start;
+    unsigned long const remaining = (elapsed < limit) ? (limit - elapsed) : 0;
+
+    if (remaining < *timeout_in_seconds)
+        *timeout_in_seconds = remaining;
+}
+
+STATIC connector_status_t yield_process(connector_data_t * const connector_ptr, connector_status_t const status, unsigned long const timeout_in_milliseconds)
 {
     connector_status_t result = connector_working;
 
@@ -264,6 +317,7 @@ STATIC connector_status_t yield_process(connector_data_t * const connector_ptr,
 
         request_id.os_request = connector_request_id_os_yield;
         data.status = status;
+        data.timeout_in_milliseconds = (status == connector_idle) ? timeout_in_milliseconds : 0;
 
         callback_status = connector_callback(connector_ptr->callback, connector_class_id_operating_system, request_id, &data, connector_ptr->context);
 
@@ -280,6 +334,16 @@ STATIC connector_status_t yield_process(connector_data_t * const connector_ptr,
     return result;
 }
 
+STATIC void wakeup_process(connector_data_t * const connector_ptr)
+{
+    connector_request_id_t request_id;
+
+    request_id.os_request = connector_request_id_os_wakeup;
+
+    /* optional callback, only needed when the yield callback blocks */
+    (void)connector_callback(connector_ptr->callback, connector_class_id_operating_system, request_id, NULL, connector_ptr->context);
+}
+
 STATIC connector_status_t connector_reboot(connector_data_t * const connector_ptr)
 {
     connector_status_t result;
@@ -24,6 +24,7 @@
 #include "rci_binary_string.h"
 #include "rci_binary_group.h"
 #include "rci_binary_element.h"
+#include "rci_binary_tracking.h"
 #include "rci_binary_callback.h"
 #include "rci_binary_output.h"
 #include "rci_binary_input.h"
@@ -53,6 +54,9 @@ STATIC connector_bool_t rci_action_session_start(rci_t * const rci, rci_service_
     invalidate_element_id(rci);
 
     rci->shared.callback_data.response.element_value = &rci->shared.value;
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+    rci->group_query.state = rci_group_query_off;
+#endif
 
     rci->status = rci_status_busy;
     rci->error.command_error = connector_false;
@@ -95,6 +95,9 @@ STATIC void trigger_rci_callback(rci_t * const rci, connector_request_id_remote_
     case connector_request_id_remote_config_session_end:
         break;
     case connector_request_id_remote_config_action_start:
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+        rci->tracking.active = connector_false;
+#endif
         switch (rci->command.command_id)
         {
             case rci_command_query_setting:
@@ -137,6 +140,22 @@ STATIC void trigger_rci_callback(rci_t * const rci, connector_request_id_remote_
             }
 #endif
             case rci_command_query_state:
+            {
+                unsigned int i;
+                for (i=0; i < rci->command.attribute_count; i++)
+                {
+                    switch (rci->command.attribute[i].id.query_state)
+                    {
+                        case rci_query_state_attribute_id_since:
+                            rci_tracking_start(rci, &rci->command.attribute[i].value.uint32_val);
+                            break;
+                        case rci_query_state_attribute_id_count:
+                            ASSERT_GOTO(0, done);
+                            break;
+                    }
+                }
+                break;
+            }
             case rci_command_set_setting:
             case rci_command_set_state:
             case rci_command_query_descriptor:
@@ -183,6 +202,21 @@ STATIC void trigger_rci_callback(rci_t * const rci, connector_request_id_remote_
         }
 
         rci->shared.callback_data.element.value = is_set_command(rci->shared.callback_data.action) ? &rci->shared.value : NULL;
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+        rci->shared.callback_data.response.element_value = &rci->shared.value;
+#endif
+        break;
+
+    case connector_request_id_remote_config_group_query:
+        ASSERT(have_group_id(rci));
+        ASSERT(have_group_index(rci));
+
+        rci->shared.callback_data.element.value = NULL;
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+        rci->shared.callback_data.response.element_value = rci->group_query.value;
+#else
+        ASSERT(connector_false);
+#endif
         break;
 
 #if (defined RCI_LEGACY_COMMANDS)
@@ -256,6 +290,7 @@ STATIC connector_bool_t rci_callback(rci_t * const rci)
             /* intentional fall through */
         case connector_request_id_remote_config_group_end:
         case connector_request_id_remote_config_group_process:
+        case connector_request_id_remote_config_group_query:
             rci->output.element_skip = connector_false;
             remote_config->error_id = connector_success;
             remote_config->response.compare_matches = connector_false;
@@ -280,7 +315,8 @@ STATIC connector_bool_t rci_callback(rci_t * const rci)
 #endif
     }
 
-    if (remote_config_request == connector_request_id_remote_config_group_process && rci->output.group_skip == connector_true)
+    if ((remote_config_request == connector_request_id_remote_config_group_process || remote_config_request == connector_request_id_remote_config_group_query) &&
+        rci->output.group_skip == connector_true)
     {
         rci->callback.status = connector_callback_continue;
     }
@@ -317,6 +353,16 @@ STATIC connector_bool_t rci_callback(rci_t * const rci)
             break;
         }
 #endif
+        case connector_request_id_remote_config_group_query:
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+            if (rci->callback.status == connector_callback_continue && remote_config->error_id != connector_success)
+            {
+                /* fall back to one callback per element so each can report its own error */
+                rci->group_query.state = rci_group_query_off;
+                trigger_rci_callback(rci, connector_request_id_remote_config_group_process);
+            }
+#endif
+            break;
         case connector_request_id_remote_config_session_start:
         case connector_request_id_remote_config_session_end:
         case connector_request_id_remote_config_action_start:
@@ -402,6 +448,7 @@ STATIC connector_bool_t rci_callback(rci_t * const rci)
                 break;
             case connector_request_id_remote_config_group_start:
             case connector_request_id_remote_config_session_cancel:
+            case connector_request_id_remote_config_group_query:
 #if (defined RCI_LEGACY_COMMANDS)
             case connector_request_id_remote_config_do_command:
             case connector_request_id_remote_config_reboot:
@@ -64,6 +64,7 @@ static char const * rci_output_state_t_as_string(rci_output_state_t const value)
         enum_to_case(rci_output_state_field_id);
         enum_to_case(rci_output_state_field_value);
         enum_to_case(rci_output_state_field_terminator);
+        enum_to_case(rci_output_state_descriptor_hash);
         enum_to_case(rci_output_state_group_terminator);
 #if (defined RCI_LEGACY_COMMANDS)
         enum_to_case(rci_output_state_do_command_payload);
@@ -23,6 +23,12 @@
 #define invalidate_element_id(rci)      set_element_id(rci, INVALID_ID)
 #define have_element_id(rci)            (get_element_id(rci) != INVALID_ID)
 
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+#define get_output_value(rci)   (((rci)->group_query.state == rci_group_query_ready) ? &(rci)->group_query.value[get_element_id(rci)] : &(rci)->shared.value)
+#else
+#define get_output_value(rci)   (&(rci)->shared.value)
+#endif
+
 static connector_group_element_t const * get_current_element(rci_t const * const rci)
 {
     ASSERT(have_group_id(rci));
@@ -431,6 +431,14 @@ STATIC void process_rci_command(rci_t * const rci)
                 rci->shared.callback_data.action = connector_remote_action_set_factory_def;
                 break;
 #endif
+            case rci_command_query_descriptor:
+                if (!has_attribute && rci->service_data->connector_ptr->rci_data->descriptor_hash != NULL)
+                {
+                    /* answered with the descriptor hash once the command terminator is read */
+                    set_rci_input_state(rci, rci_input_state_group_id);
+                    goto done;
+                }
+                /* intentional fall through */
             default:
                 /* unsupported command.
                  * Just go to error state for returning error message.
@@ -497,8 +505,14 @@ STATIC void process_command_attribute(rci_t * const rci)
                 switch (rci->shared.callback_data.action)
                 {
                     case connector_remote_action_query:
-                        ASSERT_GOTO(rci->shared.callback_data.group.type == connector_remote_group_setting, done);
-                        ASSERT_GOTO(rci->command.attribute_count <= rci_query_setting_attribute_id_count, done);
+                        if (rci->shared.callback_data.group.type == connector_remote_group_state)
+                        {
+                            ASSERT_GOTO(rci->command.attribute_count <= rci_query_state_attribute_id_count, done);
+                        }
+                        else
+                        {
+                            ASSERT_GOTO(rci->command.attribute_count <= rci_query_setting_attribute_id_count, done);
+                        }
                         break;
                     case connector_remote_action_set:
                         ASSERT_GOTO(0, done);
@@ -567,6 +581,29 @@ STATIC void process_command_normal_attribute_value(rci_t * const rci)
             rci->command.attribute[rci->command.attributes_processed].type = attribute_type_enum;
             break;
         }
+        case rci_command_query_state:
+        {
+            uint32_t attribute_value;
+
+            if(!get_uint32(rci, &attribute_value))
+                goto done;
+
+#if (defined RCI_DEBUG)
+            connector_debug_line("attribute_val=%d\n", attribute_value);
+#endif
+
+            switch (rci->command.attribute[rci->command.attributes_processed].id.query_state)
+            {
+                case rci_query_state_attribute_id_since:
+                    rci->command.attribute[rci->command.attributes_processed].value.uint32_val = attribute_value;
+                    break;
+                case rci_query_state_attribute_id_count:
+                    ASSERT_GOTO(0, done);
+                    break;
+            }
+            rci->command.attribute[rci->command.attributes_processed].type = attribute_type_uint32;
+            break;
+        }
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_do_command:
         {
@@ -596,7 +633,6 @@ STATIC void process_command_normal_attribute_value(rci_t * const rci)
             break;
         }
 #endif
-        case rci_command_query_state:
         case rci_command_set_setting:
         case rci_command_set_state:
         case rci_command_query_descriptor:
@@ -650,6 +686,25 @@ STATIC void process_group_id(rci_t * const rci)
 
     ASSERT_GOTO(!has_rci_error(rci, group_id), done);
 
+    if (rci->command.command_id == rci_command_query_descriptor)
+    {
+        if (has_rci_terminated(group_id) && group_length == 1)
+        {
+            set_rci_input_state(rci, rci_input_state_command_id);
+
+            set_rci_output_state(rci, rci_output_state_command_id);
+            state_call(rci, rci_parser_state_output);
+        }
+        else
+        {
+            connector_debug_line("process_group_id: query_descriptor takes no groups");
+            rci_global_error(rci, connector_rci_error_bad_command, RCI_NO_HINT);
+            set_rci_command_error(rci);
+            state_call(rci, rci_parser_state_error);
+        }
+        goto done;
+    }
+
     if (has_rci_terminated(group_id) && group_length == 1)
     {
 #if (defined RCI_LEGACY_COMMANDS)
@@ -404,7 +404,6 @@ STATIC void rci_output_command_id(rci_t * const rci)
     {
         case rci_command_set_setting:
         case rci_command_set_state:
-        case rci_command_query_state:
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_reboot:
         case rci_command_set_factory_default:
@@ -413,6 +412,7 @@ STATIC void rci_output_command_id(rci_t * const rci)
             break;
 
         case rci_command_query_setting:
+        case rci_command_query_state:
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_do_command:
 #endif
@@ -426,7 +426,8 @@ STATIC void rci_output_command_id(rci_t * const rci)
             }
             break;
          case rci_command_query_descriptor:
-            ASSERT_GOTO(connector_false, done);
+            overflow = rci_output_uint32(rci, rci->command.command_id);
+            break;
     }
 
     if (overflow)
@@ -482,7 +483,8 @@ STATIC void rci_output_command_id(rci_t * const rci)
 #endif
 
             case rci_command_query_descriptor:
-                ASSERT_GOTO(connector_false, done);
+                set_rci_output_state(rci, rci_output_state_descriptor_hash);
+                break;
         }
     }
 
@@ -498,7 +500,6 @@ STATIC void rci_output_command_normal_attribute_count(rci_t * const rci)
 
     switch (rci->command.command_id)
     {
-        case rci_command_query_state:
         case rci_command_set_setting:
         case rci_command_set_state:
         case rci_command_query_descriptor:
@@ -510,6 +511,7 @@ STATIC void rci_output_command_normal_attribute_count(rci_t * const rci)
             break;
 
         case rci_command_query_setting:
+        case rci_command_query_state:
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_do_command:
 #endif
@@ -545,7 +547,6 @@ STATIC void rci_output_command_normal_attribute_id(rci_t * const rci)
 
     switch (rci->command.command_id)
     {
-        case rci_command_query_state:
         case rci_command_set_setting:
         case rci_command_set_state:
         case rci_command_query_descriptor:
@@ -557,6 +558,7 @@ STATIC void rci_output_command_normal_attribute_id(rci_t * const rci)
             break;
 
         case rci_command_query_setting:
+        case rci_command_query_state:
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_do_command:
 #endif
@@ -587,7 +589,6 @@ STATIC void rci_output_command_normal_attribute_value(rci_t * const rci)
 
     switch (rci->command.command_id)
     {
-        case rci_command_query_state:
         case rci_command_set_setting:
         case rci_command_set_state:
         case rci_command_query_descriptor:
@@ -600,6 +601,7 @@ STATIC void rci_output_command_normal_attribute_value(rci_t * const rci)
             break;
 
         case rci_command_query_setting:
+        case rci_command_query_state:
 #if (defined RCI_LEGACY_COMMANDS)
         case rci_command_do_command:
 #endif
@@ -608,6 +610,9 @@ STATIC void rci_output_command_normal_attribute_value(rci_t * const rci)
                 case attribute_type_enum:
                     overflow = rci_output_uint8(rci, rci->command.attribute[rci->command.attributes_processed].value.enum_val);
                     break;
+                case attribute_type_uint32:
+                    overflow = rci_output_uint32(rci, rci->command.attribute[rci->command.attributes_processed].value.uint32_val);
+                    break;
 #if (defined RCI_LEGACY_COMMANDS)
                 case attribute_type_string:
                     overflow = rci_output_string(rci, rci->command.attribute[rci->command.attributes_processed].value.string_val, strlen(rci->command.attribute[rci->command.attributes_processed].value.string_val));
@@ -637,7 +642,6 @@ STATIC void rci_output_command_normal_attribute_value(rci_t * const rci)
     {
         switch (rci->command.command_id)
         {
-            case rci_command_query_state:
             case rci_command_set_setting:
             case rci_command_set_state:
             case rci_command_query_descriptor:
@@ -648,6 +652,7 @@ STATIC void rci_output_command_normal_attribute_value(rci_t * const rci)
                 ASSERT_GOTO(connector_false, done);
                 break;
             case rci_command_query_setting:
+            case rci_command_query_state:
                 state_call(rci, rci_parser_state_traverse);
                 break;
 #if (defined RCI_LEGACY_COMMANDS)
@@ -773,6 +778,11 @@ STATIC void rci_output_field_id(rci_t * const rci)
         goto done;
     }
 
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+    if (rci->tracking.active)
+        rci->output.element_skip = connector_bool(remote_config->error_id == connector_success && rci_tracking_unchanged(rci));
+#endif
+
     {
         /* output field id */
         if (remote_config->error_id != connector_success) field_id |= BINARY_RCI_FIELD_TYPE_INDICATOR_BIT;
@@ -802,6 +812,7 @@ STATIC void rci_output_field_value(rci_t * const rci)
 {
     connector_group_element_t const * const element = get_current_element(rci);
     connector_element_value_type_t const type = element->type;
+    connector_element_value_t const * const value = get_output_value(rci);
 
     connector_bool_t overflow = connector_false;
 
@@ -855,21 +866,21 @@ STATIC void rci_output_field_value(rci_t * const rci)
 #if defined RCI_PARSER_USES_DATETIME
     case connector_element_type_datetime:
 #endif
-        ASSERT(rci->shared.value.string_value != NULL);
-        overflow = rci_output_string(rci, rci->shared.value.string_value, strlen(rci->shared.value.string_value));
+        ASSERT(value->string_value != NULL);
+        overflow = rci_output_string(rci, value->string_value, strlen(value->string_value));
         break;
 #endif
 
 #if defined RCI_PARSER_USES_IPV4
     case connector_element_type_ipv4:
-        ASSERT(rci->shared.value.string_value != NULL);
-        overflow = rci_output_ipv4(rci, rci->shared.value.string_value);
+        ASSERT(value->string_value != NULL);
+        overflow = rci_output_ipv4(rci, value->string_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_INT32
     case connector_element_type_int32:
-        overflow = rci_output_uint32(rci, rci->shared.value.signed_integer_value);
+        overflow = rci_output_uint32(rci, value->signed_integer_value);
         break;
 #endif
 
@@ -886,38 +897,38 @@ STATIC void rci_output_field_value(rci_t * const rci)
     case connector_element_type_0x_hex32:
 #endif
 
-        overflow = rci_output_uint32(rci, rci->shared.value.unsigned_integer_value);
+        overflow = rci_output_uint32(rci, value->unsigned_integer_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_FLOAT
     case connector_element_type_float:
-        overflow = rci_output_float(rci, rci->shared.value.float_value);
+        overflow = rci_output_float(rci, value->float_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_ENUM
     case connector_element_type_enum:
-        overflow = rci_output_uint32(rci, rci->shared.value.enum_value);
+        overflow = rci_output_uint32(rci, value->enum_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_ON_OFF
     case connector_element_type_on_off:
-        overflow = rci_output_uint32(rci, rci->shared.value.on_off_value);
+        overflow = rci_output_uint32(rci, value->on_off_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_BOOLEAN
     case connector_element_type_boolean:
-        overflow = rci_output_uint32(rci, rci->shared.value.boolean_value);
+        overflow = rci_output_uint32(rci, value->boolean_value);
         break;
 #endif
 
 #if defined RCI_PARSER_USES_MAC_ADDR
     case connector_element_type_mac_addr:
-        ASSERT(rci->shared.value.string_value != NULL);
-        overflow = rci_output_mac_addr(rci, rci->shared.value.string_value);
+        ASSERT(value->string_value != NULL);
+        overflow = rci_output_mac_addr(rci, value->string_value);
         break;
 #endif
     }
@@ -982,6 +993,15 @@ STATIC void rci_output_field_terminator(rci_t * const rci)
     return;
 }
 
+STATIC void rci_output_descriptor_hash(rci_t * const rci)
+{
+    char const * const hash = rci->service_data->connector_ptr->rci_data->descriptor_hash;
+    connector_bool_t const overflow = rci_output_string(rci, hash, strlen(hash));
+
+    if (!overflow)
+        set_rci_output_state(rci, rci_output_state_group_terminator);
+}
+
 STATIC void rci_output_group_terminator(rci_t * const rci)
 {
     connector_remote_config_t const * const remote_config = &rci->shared.callback_data;
@@ -1058,6 +1078,10 @@ STATIC void rci_generate_output(rci_t * const rci)
                 rci_output_field_terminator(rci);
                 break;
 
+            case rci_output_state_descriptor_hash:
+                rci_output_descriptor_hash(rci);
+                break;
+
             case rci_output_state_group_terminator:
                 rci_output_group_terminator(rci);
                 break;
@@ -139,12 +139,18 @@ typedef enum {
 
 typedef enum
 {
-    attribute_type_enum
+    attribute_type_enum,
+    attribute_type_uint32
 #if (defined RCI_LEGACY_COMMANDS)
     ,attribute_type_string
 #endif
 } rci_command_attribute_type_t;
 
+typedef enum {
+    rci_query_state_attribute_id_since, /* 'since' attribute is bin_id=0 in the uploaded descriptor for query_state command */
+    rci_query_state_attribute_id_count
+} rci_query_state_attribute_id_t;
+
 #if (defined RCI_LEGACY_COMMANDS)
 typedef enum {
     rci_do_command_attribute_id_target, /* 'target' attribute is bin_id=0 in the uploaded descriptor for do_command command */
@@ -156,6 +162,7 @@ typedef union
 {
     unsigned int val;
     rci_query_setting_attribute_id_t query_setting;
+    rci_query_state_attribute_id_t query_state;
 #if (defined RCI_LEGACY_COMMANDS)
     rci_do_command_attribute_id_t do_command;
 #endif
@@ -237,6 +244,7 @@ typedef enum
     rci_output_state_field_id,
     rci_output_state_field_value,
     rci_output_state_field_terminator,
+    rci_output_state_descriptor_hash,
     rci_output_state_group_terminator,
 #if (defined RCI_LEGACY_COMMANDS)
     rci_output_state_do_command_payload,
@@ -270,6 +278,15 @@ typedef enum
     rci_traverse_process_next_instance
 } rci_traverse_process_state_t;
 
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+typedef enum
+{
+    rci_group_query_off,
+    rci_group_query_start,
+    rci_group_query_ready
+} rci_group_query_state_t;
+#endif
+
 typedef enum
 {
     rci_error_state_id,
@@ -326,6 +343,7 @@ typedef struct rci
             union
             {
                 uint32_t enum_val; 
+                uint32_t uint32_val;
 #if (defined RCI_LEGACY_COMMANDS)
                 char string_val[RCI_COMMANDS_ATTRIBUTE_MAX_LEN + 1];
 #endif
@@ -364,6 +382,21 @@ typedef struct rci
         connector_bool_t element_skip;
     } output;
 
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+    struct {
+        rci_group_query_state_t state;
+        connector_element_value_t value[CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS];
+    } group_query;
+#endif
+
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+    struct {
+        connector_bool_t active;
+        connector_bool_t have_since;
+        uint32_t since;
+    } tracking;
+#endif
+
     struct {
         rci_error_state_t state;
         connector_bool_t command_error;
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2014 Digi International Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
+ * =======================================================================
+ */
+
+#if (defined CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+#define RCI_TRACKING_FNV_OFFSET     UINT32_C(2166136261)
+#define RCI_TRACKING_FNV_PRIME      UINT32_C(16777619)
+
+STATIC uint32_t rci_tracking_hash(uint32_t hash, void const * const data, size_t const length)
+{
+    uint8_t const * const bytes = data;
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= RCI_TRACKING_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+STATIC uint32_t rci_tracking_fingerprint(connector_element_value_type_t const type, connector_element_value_t const * const value)
+{
+    uint32_t fingerprint = RCI_TRACKING_FNV_OFFSET;
+
+    switch (type)
+    {
+#if defined RCI_PARSER_USES_STRINGS
+
+#if defined RCI_PARSER_USES_STRING
+    case connector_element_type_string:
+#endif
+
+#if defined RCI_PARSER_USES_MULTILINE_STRING
+    case connector_element_type_multiline_string:
+#endif
+
+#if defined RCI_PARSER_USES_PASSWORD
+    case connector_element_type_password:
+#endif
+
+#if defined RCI_PARSER_USES_FQDNV4
+    case connector_element_type_fqdnv4:
+#endif
+
+#if defined RCI_PARSER_USES_FQDNV6
+    case connector_element_type_fqdnv6:
+#endif
+
+#if defined RCI_PARSER_USES_DATETIME
+    case connector_element_type_datetime:
+#endif
+#endif
+
+#if defined RCI_PARSER_USES_IPV4
+    case connector_element_type_ipv4:
+#endif
+
+#if defined RCI_PARSER_USES_MAC_ADDR
+    case connector_element_type_mac_addr:
+#endif
+
+#if (defined RCI_PARSER_USES_STRINGS) || (defined RCI_PARSER_USES_IPV4) || (defined RCI_PARSER_USES_MAC_ADDR)
+        ASSERT(value->string_value != NULL);
+        fingerprint = rci_tracking_hash(fingerprint, value->string_value, strlen(value->string_value));
+        break;
+#endif
+
+#if defined RCI_PARSER_USES_INT32
+    case connector_element_type_int32:
+        fingerprint = rci_tracking_hash(fingerprint, &value->signed_integer_value, sizeof value->signed_integer_value);
+        break;
+#endif
+
+#if (defined RCI_PARSER_USES_UNSIGNED_INTEGER)
+#if defined RCI_PARSER_USES_UINT32
+    case connector_element_type_uint32:
+#endif
+
+#if defined RCI_PARSER_USES_HEX32
+    case connector_element_type_hex32:
+#endif
+
+#if defined RCI_PARSER_USES_0X_HEX32
+    case connector_element_type_0x_hex32:
+#endif
+
+        fingerprint = rci_tracking_hash(fingerprint, &value->unsigned_integer_value, sizeof value->unsigned_integer_value);
+        break;
+#endif
+
+#if defined RCI_PARSER_USES_FLOAT
+    case connector_element_type_float:
+        fingerprint = rci_tracking_hash(fingerprint, &value->float_value, sizeof value->float_value);
+        break;
+#endif
+
+#if defined RCI_PARSER_USES_ENUM
+    case connector_element_type_enum:
+        fingerprint = rci_tracking_hash(fingerprint, &value->enum_value, sizeof value->enum_value);
+        break;
+#endif
+
+#if defined RCI_PARSER_USES_ON_OFF
+    case connector_element_type_on_off:
+        fingerprint = rci_tracking_hash(fingerprint, &value->on_off_value, sizeof value->on_off_value);
+        break;
+#endif
+
+#if defined RCI_PARSER_USES_BOOLEAN
+    case connector_element_type_boolean:
+        fingerprint = rci_tracking_hash(fingerprint, &value->boolean_value, sizeof value->boolean_value);
+        break;
+#endif
+    }
+
+    return fingerprint;
+}
+
+/* State elements are numbered group by group, instance by instance; anything past the end of the table is never tracked */
+STATIC size_t rci_tracking_slot(rci_t const * const rci)
+{
+    connector_remote_config_data_t const * const rci_data = rci->service_data->connector_ptr->rci_data;
+    connector_remote_group_table_t const * const table = rci_data->group_table + connector_remote_group_state;
+    unsigned int const group_id = get_group_id(rci);
+    size_t slot = 0;
+    unsigned int i;
+
+    for (i = 0; i < group_id; i++)
+        slot += table->groups[i].instances * table->groups[i].elements.count;
+
+    slot += (get_group_index(rci) - 1) * table->groups[group_id].elements.count;
+
+    return slot + get_element_id(rci);
+}
+
+/* Record the value about to be reported and tell whether the client already has it */
+STATIC connector_bool_t rci_tracking_unchanged(rci_t const * const rci)
+{
+    connector_rci_tracking_t * const tracking = &rci->service_data->connector_ptr->rci_tracking;
+    size_t const slot = rci_tracking_slot(rci);
+    connector_bool_t unchanged = connector_false;
+
+    if (slot < CONNECTOR_RCI_STATE_TRACKING_ENTRIES)
+    {
+        connector_rci_tracking_entry_t * const entry = &tracking->entry[slot];
+        uint32_t const fingerprint = rci_tracking_fingerprint(get_current_element(rci)->type, get_output_value(rci));
+
+        if (entry->changed == 0 || entry->fingerprint != fingerprint)
+        {
+            entry->fingerprint = fingerprint;
+            entry->changed = tracking->generation;
+        }
+
+        unchanged = connector_bool(rci->tracking.have_since && entry->changed <= rci->tracking.since);
+    }
+
+    return unchanged;
+}
+
+/* The token handed to the client is base + generation; base keeps tokens from before a restart from matching */
+STATIC void rci_tracking_start(rci_t * const rci, uint32_t * const token)
+{
+    connector_data_t * const connector_ptr = rci->service_data->connector_ptr;
+    connector_rci_tracking_t * const tracking = &connector_ptr->rci_tracking;
+    uint32_t const since = *token - tracking->base;
+
+    if (tracking->generation == 0)
+    {
+        unsigned long uptime;
+
+        if (get_system_time_in_milliseconds(connector_ptr, &uptime) == connector_working)
+            tracking->base = (uint32_t)uptime * RCI_TRACKING_FNV_PRIME;
+        rci->tracking.have_since = connector_false;
+    }
+    else
+    {
+        rci->tracking.have_since = connector_bool(since >= 1 && since <= tracking->generation);
+    }
+
+    rci->tracking.since = since;
+    rci->tracking.active = connector_true;
+
+    tracking->generation++;
+    *token = tracking->base + tracking->generation;
+}
+#else
+/* Without a tracking table every query_state is a full one */
+STATIC void rci_tracking_start(rci_t * const rci, uint32_t * const token)
+{
+    UNUSED_PARAMETER(rci);
+    *token = 0;
+}
+#endif
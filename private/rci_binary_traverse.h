@@ -25,8 +25,29 @@ STATIC void traverse_rci_command(rci_t * const rci)
     state_call(rci, rci_parser_state_output);
 
 }
+
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+#define reset_group_query(rci)  ((rci)->group_query.state = rci_group_query_off)
+
+/* A whole group instance can be fetched in one callback when every element is wanted as is */
+STATIC void start_group_query(rci_t * const rci)
+{
+    connector_group_t const * const group = get_current_group(rci);
+    connector_remote_config_t const * const remote_config = &rci->shared.callback_data;
+    connector_bool_t const batch = connector_bool(remote_config->action == connector_remote_action_query &&
+                                                  remote_config->attribute.compare_to == rci_query_setting_attribute_compare_to_none &&
+                                                  group->elements.count <= CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS);
+
+    rci->group_query.state = batch ? rci_group_query_start : rci_group_query_off;
+}
+#else
+#define reset_group_query(rci)  UNUSED_PARAMETER(rci)
+#define start_group_query(rci)  UNUSED_PARAMETER(rci)
+#endif
+
 STATIC void traverse_group_id(rci_t * const rci)
 {
+    reset_group_query(rci);
     trigger_rci_callback(rci, connector_request_id_remote_config_group_start);
 
     set_rci_output_state(rci, rci_output_state_group_id);
@@ -44,7 +65,23 @@ STATIC void traverse_element_id(rci_t * const rci)
         goto done;
     }
 
+#if (defined CONNECTOR_RCI_GROUP_QUERY_MAX_ELEMENTS)
+    switch (rci->group_query.state)
+    {
+        case rci_group_query_off:
+            trigger_rci_callback(rci, connector_request_id_remote_config_group_process);
+            break;
+        case rci_group_query_start:
+            trigger_rci_callback(rci, connector_request_id_remote_config_group_query);
+            rci->group_query.state = rci_group_query_ready;
+            break;
+        case rci_group_query_ready:
+            /* value already returned by the group query callback */
+            break;
+    }
+#else
     trigger_rci_callback(rci, connector_request_id_remote_config_group_process);
+#endif
     set_rci_output_state(rci, rci_output_state_field_id);
     state_call(rci, rci_parser_state_output);
 
@@ -84,6 +121,7 @@ STATIC void traverse_command_set_factory_default(rci_t * const rci)
 
 STATIC void traverse_element_end(rci_t * const rci)
 {
+    reset_group_query(rci);
     trigger_rci_callback(rci, connector_request_id_remote_config_group_end);
 
     set_rci_output_state(rci, rci_output_state_field_terminator);
@@ -106,6 +144,7 @@ STATIC connector_bool_t traverse_all_elements(rci_t * const rci)
     {
         /* all fields */
         set_element_id(rci, 0);
+        start_group_query(rci);
         traverse_element_id(rci);
     }
     else
@@ -57,6 +57,13 @@ typedef struct
         connector_data_service_send_option_transient    /**< Device Cloud need not store the data but can send it to the consumer */
     } option;       /**< what action Device Cloud should take after receiving this request. Applicable only in TCP transport method */
 
+    enum
+    {
+        connector_data_service_send_priority_normal,        /**< scheduled like data points and other sends */
+        connector_data_service_send_priority_interactive,   /**< scheduled with RCI and device requests, for small sends someone waits on */
+        connector_data_service_send_priority_bulk           /**< scheduled with file system transfers, for large uploads */
+    } priority;     /**< how this session shares the connection with other messaging sessions. Applicable only in TCP transport method */
+
     connector_bool_t response_required; /**< set to connector_true if response is needed. If @ref transport is set to @ref connector_transport_tcp
                                              this field is ignored and a response is always received. */
     unsigned long timeout_in_seconds;   /**< outgoing sessions timeout in seconds. Only valid for SM. Use SM_WAIT_FOREVER to wait forever for the complete request/response */
@@ -246,6 +246,26 @@ typedef struct {
 /**
 * @}
 */
+
+
+/**
+* @defgroup connector_firmware_download_stats_t Firmware Download Statistics
+* @{
+*/
+/**
+* Phase timing of the current or last firmware download, returned by connector_get_firmware_download_stats().
+* Times are in milliseconds and are reset when a download is started.
+*/
+typedef struct {
+    unsigned long receive_ms;       /**< Time from the first image block to the download complete request */
+    unsigned long write_ms;         /**< Total time @ref connector_request_id_firmware_download_data callbacks took to accept the image blocks */
+    unsigned long verify_ms;        /**< Time the @ref connector_request_id_firmware_download_complete callback took */
+    uint32_t blocks;                /**< Number of image blocks received */
+    unsigned int queue_high_water;  /**< Largest number of blocks waiting in the @ref CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE queue, 0 when the queue is not used */
+} connector_firmware_download_stats_t;
+/**
+* @}
+*/
 #endif
 
 #if !defined _CONNECTOR_API_H
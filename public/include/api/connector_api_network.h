@@ -36,7 +36,11 @@ typedef enum {
     connector_request_id_network_open,     /**< Requesting callback to set up and make connection to Device Cloud */
     connector_request_id_network_send,     /**< Requesting callback to send data to Device Cloud */
     connector_request_id_network_receive,  /**< Requesting callback to receive data from Device Cloud */
-    connector_request_id_network_close     /**< Requesting callback to close Device Cloud connection */
+    connector_request_id_network_close,    /**< Requesting callback to close Device Cloud connection */
+    connector_request_id_network_send_vector, /**< Requesting callback to send several buffers to Device Cloud in one call (TCP only, optional) */
+    connector_request_id_network_send_file, /**< Requesting callback to send a region of an open file straight to Device Cloud (TCP only, optional) */
+    connector_request_id_network_send_batch, /**< Requesting callback to send several datagrams to Device Cloud in one call (UDP only, optional) */
+    connector_request_id_network_receive_batch /**< Requesting callback to receive several datagrams from Device Cloud in one call (UDP only, optional) */
 } connector_request_id_network_t;
 /**
 * @}
@@ -78,6 +82,70 @@ typedef struct  {
 * @}
 */
 
+/**
+* @defgroup connector_network_send_vector_t Network Send Vector Data Structure
+* @{
+*/
+/**
+* One fragment of a @ref connector_request_id_network_send_vector request.
+*/
+typedef struct  {
+    void const * CONST buffer;                  /**< Pointer to data to be sent */
+    size_t CONST length;                        /**< Number of bytes to send from the buffer */
+} connector_network_iovec_t;
+
+/**
+* Send vector structure for @ref connector_request_id_network_send_vector callback which is called to send
+* several buffers to Device Cloud with a single gather write (for example writev()).
+*/
+typedef struct  {
+    connector_network_handle_t CONST handle;    /**< Network handle associated with a connection through the connector_network_open callback */
+    connector_network_iovec_t const * CONST vector; /**< Fragments to be sent in order */
+    size_t CONST vector_count;                  /**< Number of fragments in the vector */
+    size_t bytes_used;                          /**< Total number of bytes sent, counted from the start of the first fragment */
+} connector_network_send_vector_t;
+/**
+* @}
+*/
+
+/**
+* @defgroup connector_network_send_file_t Network Send File Data Structure
+* @{
+*/
+/**
+* Send file structure for @ref connector_request_id_network_send_file callback which is called to send
+* bytes from the current position of an open file straight to Device Cloud (for example with sendfile()).
+* A request with bytes_available set to zero only asks whether the callback is supported.
+*/
+typedef struct  {
+    connector_network_handle_t CONST handle;    /**< Network handle associated with a connection through the connector_network_open callback */
+    connector_filesystem_file_handle_t CONST file_handle; /**< File handle returned by the file system open callback */
+    size_t CONST bytes_available;               /**< Number of bytes to send from the current file position */
+    size_t bytes_used;                          /**< Number of bytes sent; the file position advances by the same amount */
+} connector_network_send_file_t;
+/**
+* @}
+*/
+
+/**
+* @defgroup connector_network_send_batch_t Network Send Batch Data Structure
+* @{
+*/
+/**
+* Send batch structure for @ref connector_request_id_network_send_batch callback which is called to send
+* several datagrams to Device Cloud with a single call (for example sendmmsg()). Each entry of the
+* datagram list is one complete datagram.
+*/
+typedef struct  {
+    connector_network_handle_t CONST handle;    /**< Network handle associated with a connection through the connector_network_open callback */
+    connector_network_iovec_t const * CONST datagram; /**< Datagrams to be sent in order */
+    size_t CONST datagram_count;                /**< Number of datagrams in the list */
+    size_t datagrams_sent;                      /**< Number of datagrams sent, counted from the first one */
+} connector_network_send_batch_t;
+/**
+* @}
+*/
+
 /**
 * @defgroup connector_network_receive_t Network Receive Request
 * @{
@@ -96,6 +164,28 @@ typedef struct  {
 * @}
 */
 
+/**
+* @defgroup connector_network_receive_batch_t Network Receive Batch Request
+* @{
+*/
+/**
+* Receive batch structure for @ref connector_request_id_network_receive_batch callback which is called to
+* receive several datagrams from Device Cloud with a single call (for example recvmmsg()). The buffer is
+* split in slot_count slots of slot_size bytes each; slot i starts at buffer + (i * slot_size) and holds
+* one datagram.
+*/
+typedef struct  {
+    connector_network_handle_t CONST handle;    /**< Network handle associated with a connection through the connector_network_open callback */
+    void * CONST buffer;                        /**< Pointer to the first slot */
+    size_t CONST slot_size;                     /**< Number of bytes available in each slot */
+    size_t CONST slot_count;                    /**< Number of slots in the buffer */
+    size_t * CONST bytes_used;                  /**< List of slot_count entries where callback writes the number of bytes received in each slot it fills */
+    size_t slots_used;                          /**< Number of slots filled, counted from the first one */
+} connector_network_receive_batch_t;
+/**
+* @}
+*/
+
 /**
 * @defgroup connector_close_status_t Connection Close Status Values
 * @{
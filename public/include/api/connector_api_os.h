@@ -34,7 +34,9 @@ typedef enum {
     connector_request_id_os_realloc,           /**< Callback is called to reallocate data in a different size memory position. */
     connector_request_id_os_system_up_time,    /**< Callback is called to return system up time in seconds. It is the time that a device has been up and running. */
     connector_request_id_os_yield,             /**< Callback is called with @ref connector_status_t to relinquish for other task to run when @ref connector_run is used. */
-    connector_request_id_os_reboot            /**< Callback is called to reboot the system. */
+    connector_request_id_os_reboot,           /**< Callback is called to reboot the system. */
+    connector_request_id_os_wakeup,           /**< Callback is called from @ref connector_initiate_action to wake up a thread blocked in the yield callback. */
+    connector_request_id_os_system_up_time_in_milliseconds  /**< Callback is called to return monotonic system up time in milliseconds. @ref connector_request_id_os_system_up_time is used when unrecognized. */
 } connector_request_id_os_t;
 /**
 * @}
@@ -101,15 +103,40 @@ typedef struct {
 * @}
 */
 
+/**
+* @defgroup connector_os_system_up_time_in_milliseconds_t System Uptime in Milliseconds
+* @{
+*/
+/**
+* Structure passed to connector_request_id_os_system_up_time_in_milliseconds
+* callback. The value must come from a monotonic clock which is not
+* adjusted with the wall clock, and may wrap around.
+*/
+typedef struct {
+    unsigned long sys_uptime_in_milliseconds;   /**< Returned system uptime in milliseconds */
+} connector_os_system_up_time_in_milliseconds_t;
+/**
+* @}
+*/
+
 /**
 * @defgroup connector_os_yield_t  Yield Request
 * @{
 */
+/**
+* Value of timeout_in_milliseconds in @ref connector_os_yield_t when
+* Cloud Connector has no pending timer and may be blocked until a
+* network event or a @ref connector_request_id_os_wakeup callback.
+*/
+#define CONNECTOR_YIELD_WAIT_FOREVER    ((unsigned long)-1)
+
 /**
 * Structure passed to connector_request_id_os_yield callback. 
 */
 typedef struct {
-    connector_status_t CONST status;      /**< System status used to decide how to yield */
+    connector_status_t CONST status;                  /**< System status used to decide how to yield */
+    unsigned long CONST timeout_in_milliseconds;      /**< Maximum time the callback may block when status is @ref connector_idle: 0 when a timer
+                                                           is already due or status is not @ref connector_idle, @ref CONNECTOR_YIELD_WAIT_FOREVER when no timer is pending */
 } connector_os_yield_t;
 /**
 * @}
@@ -576,6 +576,115 @@ typedef connector_callback_status_t (* connector_callback_t) (connector_class_id
  * @see connector_callback_t
  */
 connector_handle_t connector_init(connector_callback_t const callback, void * const context);
+
+#if (defined CONNECTOR_NO_MALLOC)
+/**
+ * @brief Returns the size in bytes of the static memory arena used by one Cloud Connector handle.
+ *
+ * The size is fixed when Cloud Connector is compiled; it depends on the buffer counts selected by
+ * @ref CONNECTOR_MSG_MAX_TRANSACTION, @ref CONNECTOR_NO_MALLOC_MAX_SEND_SESSIONS and the short message
+ * session limits in connector_config.h.
+ *
+ * @retval size  Minimum arena_size to pass to connector_init_static().
+ *
+ * @see connector_init_static()
+ */
+size_t connector_static_arena_size(void);
+
+/**
+ * @brief Initializes Cloud Connector using a caller supplied static memory arena.
+ *
+ * This is the @ref CONNECTOR_NO_MALLOC variant of connector_init() for applications that need
+ * more than one Cloud Connector handle. The handle, its messaging sessions, short message
+ * packets and data point blocks are all allocated from the given arena, so handles
+ * initialized with different arenas do not share any buffers.
+ *
+ * The arena must be aligned for any object type (as memory returned by malloc), must be
+ * at least connector_static_arena_size() bytes and must stay valid until the handle is terminated.
+ * Cloud Connector clears the arena, so it must not be used by a running handle.
+ *
+ * @param [in] callback  Callback function that is used to
+ *        interface between the application and Cloud Connector.
+ * @param [in] context  User-controlled context passed to "callback". Set to NULL if not used.
+ * @param [in] arena  Memory used for all allocations of this handle.
+ * @param [in] arena_size  Size of the arena in bytes.
+ *
+ * @retval NULL         The arena is too small or Cloud Connector was unable to initialize.
+ * @retval "Not NULL"   Success.  A Handle was returned for subsequent Cloud Connector calls.
+ *
+ * Example Usage:
+ * @code
+ *    connector_handle = connector_init_static(application_callback, device_context, device_arena, device_arena_size);
+ * @endcode
+ *
+ * @see connector_init()
+ * @see connector_static_arena_size()
+ */
+connector_handle_t connector_init_static(connector_callback_t const callback, void * const context, void * const arena, size_t const arena_size);
+
+/**
+* Static buffer pools of a @ref CONNECTOR_NO_MALLOC handle, used in connector_get_static_pool_stats().
+*/
+typedef enum {
+    connector_static_pool_msg_facility,         /**< Messaging facilities */
+    connector_static_pool_msg_session,          /**< Messaging sessions started by Device Cloud */
+    connector_static_pool_msg_service,          /**< Data service, file system and RCI session contexts */
+    connector_static_pool_msg_session_client,   /**< Messaging sessions started by the device */
+    connector_static_pool_put_request,          /**< Send data requests */
+    connector_static_pool_sm_session,           /**< Short message sessions */
+    connector_static_pool_sm_data_block,        /**< Short message reassembly blocks */
+    connector_static_pool_sm_packet,            /**< Short message packets */
+    connector_static_pool_data_point_block,     /**< Data point requests */
+    connector_static_pool_zlib_stream,          /**< Compression streams */
+    connector_static_pool_count                 /**< Number of pools, not a valid pool */
+} connector_static_pool_t;
+
+/**
+* Usage statistics of one static buffer pool.
+*/
+typedef struct
+{
+    unsigned int size;          /**< Number of buffers in the pool, 0 if the pool is not used by this configuration */
+    unsigned int in_use;        /**< Number of buffers currently allocated */
+    unsigned int high_water;    /**< Largest number of buffers allocated at the same time */
+    unsigned long failures;     /**< Number of allocations that failed because the pool was full */
+} connector_static_pool_stats_t;
+
+/**
+ * @brief Reads the usage statistics of a static buffer pool.
+ *
+ * The high water mark and failure counter are kept per handle from connector_init() or
+ * connector_init_static() on and can be used to size @ref CONNECTOR_MSG_MAX_TRANSACTION,
+ * @ref CONNECTOR_NO_MALLOC_MAX_SEND_SESSIONS and the short message session limits from field data.
+ *
+ * @param [in] handle  Handle returned from connector_init() or connector_init_static().
+ * @param [in] pool  Pool to read.
+ * @param [out] stats  Statistics of the pool.
+ *
+ * @retval connector_success     The statistics were copied to stats.
+ * @retval connector_init_error  Invalid handle or pool.
+ */
+connector_status_t connector_get_static_pool_stats(connector_handle_t const handle, connector_static_pool_t const pool, connector_static_pool_stats_t * const stats);
+#endif
+
+#if (defined CONNECTOR_FIRMWARE_SERVICE)
+/**
+ * @brief Reads the phase timing of the current or last firmware download.
+ *
+ * Receive and write overlap when @ref CONNECTOR_FIRMWARE_DOWNLOAD_QUEUE_SIZE is defined, so
+ * their sum may be larger than the total download time.
+ *
+ * @param [in] handle  Handle returned from connector_init() or connector_init_static().
+ * @param [out] stats  Timing of the firmware download.
+ *
+ * @retval connector_success        The statistics were copied to stats.
+ * @retval connector_init_error     Invalid handle.
+ * @retval connector_unavailable    The firmware facility is not running.
+ *
+ * @see @ref fw_image_data
+ */
+connector_status_t connector_get_firmware_download_stats(connector_handle_t const handle, connector_firmware_download_stats_t * const stats);
+#endif
 /**
 * @}
 */
@@ -31,6 +31,7 @@
 #include "platform.h"
 #include "connector_config.h"
 #include "connector_debug.h"
+#include "file_hash.h"
 
 #if !defined CONNECTOR_FILE_SYSTEM
 #error "Please define CONNECTOR_FILE_SYSTEM in connector_config.h to run this sample"
@@ -53,21 +54,6 @@
 #define PRIoffset  PRId32
 #endif
 
-#if defined APP_ENABLE_MD5
-#include <openssl/md5.h>
-
-#define APP_MD5_BUFFER_SIZE 1024
-
-typedef struct
-{
-    MD5_CTX md5;
-    char buf[APP_MD5_BUFFER_SIZE];
-    unsigned int flags;
-    int fd;
-
-} app_md5_ctx;
-#endif
-
 #ifndef APP_MIN_VALUE
 #define APP_MIN_VALUE(a,b) (((a)<(b))?(a):(b))
 #endif
@@ -176,104 +162,6 @@ static connector_callback_status_t app_process_file_get_error(connector_file_sys
 }
 
 
-#if defined APP_ENABLE_MD5
-static app_md5_ctx * app_allocate_md5_ctx(unsigned int const flags)
-{
-    app_md5_ctx * ctx = malloc(sizeof *ctx);
-
-    if (ctx != NULL)
-    {
-        ctx->flags = flags;
-        ctx->fd    = -1;
-    }
-    else
-    {
-        APP_DEBUG("app_allocate_md5_ctx: malloc fails\n");
-    }
-    return ctx;
-}
-
-static connector_callback_status_t app_process_file_session_error(connector_file_system_session_error_t * const data)
-{
-     APP_DEBUG("Session Error %d\n", data->session_error);
-
-    /* All application resources, used in the session, must be released in this callback */
-    if (data->user_context != NULL)
-    {
-        app_md5_ctx * ctx = data->user_context;
-
-        if (ctx->fd >= 0)
-            close(ctx->fd);
-
-        free(data->user_context);
-        data->user_context = NULL;
-    }
-    return connector_callback_continue;
-}
-
-static connector_callback_status_t app_process_file_hash(connector_file_system_hash_t * const data)
-{
-    connector_callback_status_t status = connector_callback_continue;
-    app_md5_ctx * ctx = data->user_context;
-    int ret;
-
-    if (ctx == NULL)
-    {
-        ASSERT(0);
-        goto error;
-    }
-
-    if (ctx->fd < 0)
-    {
-        ctx->fd = open(data->path, O_RDONLY);
-        APP_DEBUG("Open %s, returned %d\n", data->path, ctx->fd);
-
-        if (ctx->fd < 0)
-        {
-            ASSERT(0);
-            goto error;
-        }
-
-        MD5_Init(&ctx->md5);
-    }
-
-    while ((ret = read (ctx->fd, ctx->buf, sizeof ctx->buf)) > 0)
-    {
-        MD5_Update(&ctx->md5, ctx->buf, ret);
-    }
-    if (ret == -1 && errno == EAGAIN)
-    {
-        status = connector_callback_busy;
-        goto done;
-    }
-
-    APP_DEBUG("Close %d\n", ctx->fd);
-    close (ctx->fd);
-    ctx->fd = -1;
-
-    if (ret == 0)
-    {
-        MD5_Final (data->hash_value, &ctx->md5);
-        goto done;
-    }
-
-error:
-    memset(data->hash_value, 0, data->bytes_requested);
-
-done:
-    if (ctx != NULL && status == connector_callback_continue)
-    {
-        /* free md5 context here,  if ls was issued a single file */
-        if ((ctx->flags == connector_file_system_file_type_is_dir) == 0)
-        {
-            free(data->user_context);
-            data->user_context = NULL;
-        }
-    }
-    return status;
-}
-#else
-
 static connector_callback_status_t app_process_file_session_error(connector_file_system_session_error_t * const data)
 {
     UNUSED_ARGUMENT(data);
@@ -283,15 +171,11 @@ static connector_callback_status_t app_process_file_session_error(connector_file
     return connector_callback_continue;
 }
 
+/* Hashes come from the cache in file_hash.c, computed on its worker thread while this returns busy */
 static connector_callback_status_t app_process_file_hash(connector_file_system_hash_t * const data)
 {
-
-    /* app_process_file_hash() should not be called if APP_ENABLE_MD5 is not defined */
-    ASSERT(0);
-    UNUSED_ARGUMENT(data);
-    return connector_callback_continue;
+    return app_file_hash_get(data->path, data->hash_algorithm, data->hash_value, data->bytes_requested);
 }
-#endif
 
 static int app_copy_statbuf(connector_file_system_statbuf_t * const pstat, struct stat const * const statbuf)
 {
@@ -363,29 +247,14 @@ static connector_callback_status_t app_process_file_stat(connector_file_system_s
 
     data->hash_algorithm.actual = connector_file_system_hash_none;
 
-#if defined APP_ENABLE_MD5
-    switch (data->hash_algorithm.requested)
+    if (pstat->flags != connector_file_system_file_type_none)
     {
-        case connector_file_system_hash_best:
-        case connector_file_system_hash_md5:
-            if (pstat->flags != connector_file_system_file_type_none)
-            {
-                data->hash_algorithm.actual = connector_file_system_hash_md5;
-                if (data->user_context == NULL)
-                {
-                    data->user_context = app_allocate_md5_ctx(pstat->flags);
-                    if (data->user_context == NULL)
-                    {
-                        status = app_process_file_error(&data->errnum, ENOMEM);
-                    }
-                }
-            }
-            break;
+        data->hash_algorithm.actual = app_file_hash_algorithm(data->hash_algorithm.requested);
 
-        default:
-            break;
+        /* start on the directory's files now, the listing asks for them one by one */
+        if ((pstat->flags == connector_file_system_file_type_is_dir) && (data->hash_algorithm.actual != connector_file_system_hash_none))
+            app_file_hash_prefetch(data->path, data->hash_algorithm.actual);
     }
-#endif
 
 done:
     return status;
@@ -467,15 +336,6 @@ static connector_callback_status_t app_process_file_closedir(connector_file_syst
     free(dir_data);
 
     /* All application resources, used in the session, must be released in this callback */
-
-#if defined APP_ENABLE_MD5
-    if (data->user_context != NULL)
-    {
-        /* free md5 context here, if ls was issued a directory */
-        free(data->user_context);
-        data->user_context = NULL;
-    }
-#endif
     return connector_callback_continue;
 }
 
@@ -538,6 +398,11 @@ static connector_callback_status_t app_process_file_open(connector_file_system_o
     {
         status = app_process_file_error(&data->errnum, errno);
     }
+    else if ((oflag & O_ACCMODE) == O_RDONLY)
+    {
+        /* files opened for a get are read front to back, ask for a larger read-ahead */
+        (void)posix_fadvise((int)fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
 
     APP_DEBUG("Open file %s, %d, returned %ld", data->path, oflag, fd);
     if (fd < 0)
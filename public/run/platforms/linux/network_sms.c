@@ -355,8 +355,6 @@ static connector_callback_status_t app_network_sms_close(connector_network_close
     gammu_sms_handler_t *sms_handle = data->handle;
     GSM_Error error;
 
-    /* app_dns_set_redirected(connector_class_id_network_sms, data->status == connector_close_status_cloud_redirected); */
-
     data->reconnect = app_connector_reconnect(connector_class_id_network_sms, data->status);
 
     /* Terminate connection */
@@ -24,6 +24,8 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include <errno.h>
 
 #include "connector_api.h"
@@ -32,15 +34,28 @@
 
 #if defined CONNECTOR_TRANSPORT_TCP
 
+/* set while app_os_yield() also waits for the socket to become writable */
+static connector_bool_t app_tcp_wait_for_send = connector_false;
+
+static void app_tcp_set_wait_for_send(int const fd, connector_bool_t const enable)
+{
+    if (app_tcp_wait_for_send != enable)
+    {
+        app_os_wait_for_send(fd, enable);
+        app_tcp_wait_for_send = enable;
+    }
+}
+
 static connector_callback_status_t app_network_tcp_close(connector_network_close_t * const data)
 {
     connector_callback_status_t status = connector_callback_continue;
     int * const fd = data->handle;
 
-    app_dns_set_redirected(connector_class_id_network_tcp, data->status == connector_close_status_cloud_redirected);
-
     data->reconnect = app_connector_reconnect(connector_class_id_network_tcp, data->status);
 
+    app_os_wait_remove_fd(*fd);
+    app_tcp_wait_for_send = connector_false;
+
     if (close(*fd) < 0)
     {
         APP_DEBUG("network_tcp_close: close() failed, fd %d, errno %d\n", *fd, errno);
@@ -112,12 +127,14 @@ static connector_callback_status_t app_network_tcp_send(connector_network_send_t
     if (ccode >= 0)
     {
         data->bytes_used = (size_t)ccode;
+        app_tcp_set_wait_for_send(*fd, connector_false);
     }
     else
     {
         int const err = errno;
         if (err == EAGAIN)
         {
+            app_tcp_set_wait_for_send(*fd, connector_true);
             status = connector_callback_busy;
         }
         else
@@ -131,10 +148,96 @@ static connector_callback_status_t app_network_tcp_send(connector_network_send_t
     return status;
 }
 
+/*
+ * Sends several buffers to Device Cloud with a single writev(), this routine must not block.
+ * If it encounters EAGAIN error, return connector_callback_busy and Cloud Connector will
+ * call this function again.
+ */
+#define APP_MAX_SEND_VECTOR 16
 
-static int app_tcp_create_socket(void)
+static connector_callback_status_t app_network_tcp_send_vector(connector_network_send_vector_t * const data)
 {
-    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    connector_callback_status_t status = connector_callback_continue;
+    int * const fd = data->handle;
+    struct iovec iov[APP_MAX_SEND_VECTOR];
+    int const count = (data->vector_count < APP_MAX_SEND_VECTOR) ? (int)data->vector_count : APP_MAX_SEND_VECTOR;
+    ssize_t ccode;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (void *)data->vector[i].buffer;
+        iov[i].iov_len = data->vector[i].length;
+    }
+
+    ccode = writev(*fd, iov, count);
+    if (ccode >= 0)
+    {
+        data->bytes_used = (size_t)ccode;
+        app_tcp_set_wait_for_send(*fd, connector_false);
+    }
+    else
+    {
+        int const err = errno;
+        if (err == EAGAIN)
+        {
+            app_tcp_set_wait_for_send(*fd, connector_true);
+            status = connector_callback_busy;
+        }
+        else
+        {
+            status = connector_callback_error;
+            APP_DEBUG("app_network_tcp_send_vector: writev() failed, errno %d\n", err);
+            app_dns_cache_invalidate(connector_class_id_network_tcp);
+        }
+    }
+
+    return status;
+}
+
+/*
+ * Sends a region of an open file to Device Cloud with sendfile(), so the data never
+ * passes through Cloud Connector buffers. This routine must not block; a request
+ * for zero bytes only checks that the callback is implemented.
+ */
+static connector_callback_status_t app_network_tcp_send_file(connector_network_send_file_t * const data)
+{
+    connector_callback_status_t status = connector_callback_continue;
+    int * const fd = data->handle;
+    ssize_t ccode;
+
+    if (data->bytes_available == 0)
+        goto done;
+
+    ccode = sendfile(*fd, (int)data->file_handle, NULL, data->bytes_available);
+    if (ccode >= 0)
+    {
+        data->bytes_used = (size_t)ccode;
+        app_tcp_set_wait_for_send(*fd, connector_false);
+    }
+    else
+    {
+        int const err = errno;
+        if (err == EAGAIN)
+        {
+            app_tcp_set_wait_for_send(*fd, connector_true);
+            status = connector_callback_busy;
+        }
+        else
+        {
+            status = connector_callback_error;
+            APP_DEBUG("app_network_tcp_send_file: sendfile() failed, errno %d\n", err);
+            app_dns_cache_invalidate(connector_class_id_network_tcp);
+        }
+    }
+
+done:
+    return status;
+}
+
+static int app_tcp_create_socket(int const family)
+{
+    int fd = socket(family, SOCK_STREAM, 0);
 
     if (fd >= 0)
     {
@@ -165,20 +268,18 @@ static int app_tcp_create_socket(void)
     return fd;
 }
 
-static connector_callback_status_t app_tcp_connect(int const fd, in_addr_t const ip_addr)
+static connector_callback_status_t app_tcp_connect(int const fd, app_dns_address_t * const address)
 {
-
-    struct sockaddr_in sin = {0};
     connector_callback_status_t status = connector_callback_continue;
 
-    memcpy(&sin.sin_addr, &ip_addr, sizeof sin.sin_addr);
-    sin.sin_port   = htons(CONNECTOR_PORT);
-    sin.sin_family = AF_INET;
-
-    APP_DEBUG("app_tcp_connect: fd %d\n", fd);
+    if (address->addr.ss_family == AF_INET6)
+        ((struct sockaddr_in6 *)&address->addr)->sin6_port = htons(CONNECTOR_PORT);
+    else
+        ((struct sockaddr_in *)&address->addr)->sin_port = htons(CONNECTOR_PORT);
 
+    APP_DEBUG("app_tcp_connect: fd %d, %s\n", fd, (address->addr.ss_family == AF_INET6) ? "IPv6" : "IPv4");
 
-    if (connect(fd, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+    if (connect(fd, (struct sockaddr *)&address->addr, address->length) < 0)
     {
         int const err = errno;
         switch (err)
@@ -237,14 +338,123 @@ static connector_callback_status_t app_is_tcp_connect_complete(int const fd)
     return status;
 }
 
-static connector_callback_status_t app_network_tcp_open(connector_network_open_t * const data)
+/*
+ * Happy eyeballs (RFC 6555): the resolved addresses come IPv6 first, interleaved with
+ * IPv4. A new attempt is started whenever no attempt is in progress or the previous one
+ * has been pending for APP_CONNECT_ATTEMPT_DELAY milliseconds; the first socket to
+ * connect wins and all the others are closed.
+ */
+#define APP_CONNECT_TIMEOUT         30
+#define APP_CONNECT_ATTEMPT_DELAY   250
+
+typedef struct
 {
-#define APP_CONNECT_TIMEOUT 30
+    app_dns_address_t address[APP_DNS_MAX_ADDRESSES];
+    size_t count;
+    size_t next;
+    int fd[APP_DNS_MAX_ADDRESSES];
+    unsigned long start_time;
+    unsigned long attempt_time;
+} app_tcp_connect_race_t;
 
-    static unsigned long connect_time;
+static app_tcp_connect_race_t app_tcp_race;
+
+static void app_tcp_race_close(size_t const index)
+{
+    int const fd = app_tcp_race.fd[index];
+
+    app_os_wait_remove_fd(fd);
+    close(fd);
+    app_tcp_race.fd[index] = -1;
+}
+
+static void app_tcp_race_reset(void)
+{
+    size_t i;
+
+    for (i = 0; i < app_tcp_race.next; i++)
+    {
+        if (app_tcp_race.fd[i] >= 0)
+            app_tcp_race_close(i);
+    }
+    app_tcp_race.count = 0;
+    app_tcp_race.next = 0;
+}
+
+static size_t app_tcp_race_pending(void)
+{
+    size_t pending = 0;
+    size_t i;
+
+    for (i = 0; i < app_tcp_race.next; i++)
+    {
+        if (app_tcp_race.fd[i] >= 0)
+            pending++;
+    }
+
+    return pending;
+}
+
+static void app_tcp_race_start_next(unsigned long const now)
+{
+    size_t const index = app_tcp_race.next++;
+    app_dns_address_t * const address = &app_tcp_race.address[index];
+    int const fd = app_tcp_create_socket(address->addr.ss_family);
+
+    app_tcp_race.fd[index] = fd;
+    app_tcp_race.attempt_time = now;
+
+    if (fd >= 0)
+    {
+        app_os_wait_add_fd(fd);
+        app_os_wait_for_send(fd, connector_true);
+        if (app_tcp_connect(fd, address) == connector_callback_error)
+            app_tcp_race_close(index);
+    }
+}
+
+/* Returns the connected socket, -1 while the attempts are still pending. */
+static int app_tcp_race_run(unsigned long const now)
+{
+    int connected_fd = -1;
+    size_t i;
+
+    while (app_tcp_race.next < app_tcp_race.count &&
+           (app_tcp_race_pending() == 0 || (now - app_tcp_race.attempt_time) >= APP_CONNECT_ATTEMPT_DELAY))
+    {
+        app_tcp_race_start_next(now);
+        if (app_tcp_race_pending() > 0)
+            break;
+    }
+
+    for (i = 0; i < app_tcp_race.next; i++)
+    {
+        if (app_tcp_race.fd[i] < 0) continue;
+
+        switch (app_is_tcp_connect_complete(app_tcp_race.fd[i]))
+        {
+        case connector_callback_continue:
+            connected_fd = app_tcp_race.fd[i];
+            app_tcp_race.fd[i] = -1;
+            goto done;
+
+        case connector_callback_error:
+            app_tcp_race_close(i);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+done:
+    return connected_fd;
+}
+
+static connector_callback_status_t app_network_tcp_open(connector_network_open_t * const data)
+{
     int * pfd = NULL;
-    struct sockaddr_in interface_addr;
-    socklen_t interface_addr_len;
+    unsigned long now;
 
     connector_callback_status_t status = connector_callback_error;
 
@@ -259,75 +469,55 @@ static connector_callback_status_t app_network_tcp_open(connector_network_open_t
         pfd = data->handle;
     }
 
-    if (*pfd == -1)
+    if (app_tcp_race.count == 0)
     {
-        in_addr_t ip_addr;
+        size_t count = APP_DNS_MAX_ADDRESSES;
 
-        status = app_dns_resolve(connector_class_id_network_tcp, data->device_cloud.url, &ip_addr);
-        if (status != connector_callback_continue)
-        {
-            APP_DEBUG("app_network_tcp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
+        status = app_dns_resolve_all(connector_class_id_network_tcp, data->device_cloud.url, app_tcp_race.address, &count);
+        if (status == connector_callback_busy)
             goto done;
-        }
 
-        *pfd = app_tcp_create_socket();
-        if (*pfd == -1)
+        if (status != connector_callback_continue)
         {
-            status = connector_callback_error;
-            free(pfd);
-            goto done;
+            APP_DEBUG("app_network_tcp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
+            goto error;
         }
 
-        app_os_get_system_time(&connect_time);
-        status = app_tcp_connect(*pfd, ip_addr);
-        if (status != connector_callback_continue)
-            goto error;
+        app_tcp_race.count = count;
+        app_tcp_race.next = 0;
+        app_os_get_system_time_in_milliseconds(&app_tcp_race.start_time);
     }
 
-    /* Get socket info of connected interface */
-    interface_addr_len = sizeof(interface_addr);
-    if (getsockname(*pfd, (struct sockaddr *)&interface_addr, &interface_addr_len))
+    app_os_get_system_time_in_milliseconds(&now);
+    *pfd = app_tcp_race_run(now);
+    if (*pfd >= 0)
     {
-        APP_DEBUG("network_connect: getsockname error, errno %d\n", errno);
+        app_tcp_race_reset();
+        app_os_wait_for_send(*pfd, connector_false);
+        app_tcp_wait_for_send = connector_false;
+        APP_DEBUG("app_network_tcp_open: connected to %s\n", data->device_cloud.url);
+        status = connector_callback_continue;
         goto done;
     }
 
-    status = app_is_tcp_connect_complete(*pfd);
-    if (status == connector_callback_continue)
+    status = connector_callback_busy;
+    if (app_tcp_race.next == app_tcp_race.count && app_tcp_race_pending() == 0)
     {
-         APP_DEBUG("app_network_tcp_open: connected to %s\n", data->device_cloud.url);
-         goto done;
+        status = connector_callback_error;
     }
-
-    if (status == connector_callback_busy)
+    else if ((now - app_tcp_race.start_time) >= (APP_CONNECT_TIMEOUT * 1000))
     {
-        unsigned long elapsed_time;
-
-        app_os_get_system_time(&elapsed_time);
-        elapsed_time -= connect_time;
-
-        if (elapsed_time >= APP_CONNECT_TIMEOUT)
-        {
-            APP_DEBUG("app_network_tcp_open: failed to connect within 30 seconds\n");
-            status = connector_callback_error;
-        }
+        APP_DEBUG("app_network_tcp_open: failed to connect within 30 seconds\n");
+        status = connector_callback_error;
     }
 
 error:
     if (status == connector_callback_error)
     {
         APP_DEBUG("app_network_tcp_open: failed to connect to %s\n", data->device_cloud.url);
-        app_dns_set_redirected(connector_class_id_network_tcp, 0);
-
-        if (pfd != NULL)
-        {
-            if (*pfd >= 0)
-            {
-                close(*pfd);
-                *pfd = -1;
-            }
-            free(pfd);
-        }
+        app_tcp_race_reset();
+        free(pfd);
+        data->handle = NULL;
     }
 
 done:
@@ -353,6 +543,14 @@ connector_callback_status_t app_network_tcp_handler(connector_request_id_network
         status = app_network_tcp_send(data);
         break;
 
+    case connector_request_id_network_send_vector:
+        status = app_network_tcp_send_vector(data);
+        break;
+
+    case connector_request_id_network_send_file:
+        status = app_network_tcp_send_file(data);
+        break;
+
     case connector_request_id_network_receive:
         status = app_network_tcp_receive(data);
         break;
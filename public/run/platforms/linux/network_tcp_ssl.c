@@ -50,10 +50,28 @@ connector_callback_status_t app_get_interface_ip_address(uint8_t ** ip_address,
 typedef struct
 {
     int sfd;
-    SSL_CTX * ctx;
     SSL * ssl;
+    int session_slot;
+    connector_bool_t wait_for_send; /* app_os_yield() also waits for the socket to become writable */
 } app_ssl_t;
 
+/* TLS sessions are kept across reconnects, one per Device Cloud host,
+ * so both a redirect and the way back can be resumed.
+ */
+#define APP_SSL_SESSION_CACHE_SIZE  4
+#define APP_SSL_MAX_HOST_LENGTH     256
+
+typedef struct
+{
+    char host[APP_SSL_MAX_HOST_LENGTH];
+    SSL_SESSION * session;
+} app_ssl_session_t;
+
+/* created on the first connect and kept for the life of the process */
+static SSL_CTX * app_ssl_ctx = NULL;
+static app_ssl_session_t app_ssl_session_cache[APP_SSL_SESSION_CACHE_SIZE];
+static app_ssl_handshake_t app_ssl_handshake;
+
 static int app_setup_socket(void)
 {
     int const protocol = 0;
@@ -210,12 +228,6 @@ static void app_free_ssl_info(app_ssl_t * const ssl_ptr)
         ssl_ptr->ssl = NULL;
     }
 
-    if (ssl_ptr->ctx != NULL)
-    {
-        SSL_CTX_free(ssl_ptr->ctx);
-        ssl_ptr->ctx = NULL;
-    }
-
     if (ssl_ptr->sfd != -1)
     {
         close(ssl_ptr->sfd);
@@ -223,6 +235,120 @@ static void app_free_ssl_info(app_ssl_t * const ssl_ptr)
     }
 }
 
+static int app_ssl_session_slot(char const * const host)
+{
+    static int next_victim = 0;
+    int slot = -1;
+    int i;
+
+    for (i = 0; i < APP_SSL_SESSION_CACHE_SIZE; i++)
+    {
+        if (strcmp(app_ssl_session_cache[i].host, host) == 0)
+            goto done;
+
+        if ((slot < 0) && (app_ssl_session_cache[i].host[0] == '\0'))
+            slot = i;
+    }
+
+    if (slot < 0)
+    {
+        slot = next_victim;
+        next_victim = (next_victim + 1) % APP_SSL_SESSION_CACHE_SIZE;
+    }
+
+    i = slot;
+    if (app_ssl_session_cache[i].session != NULL)
+    {
+        SSL_SESSION_free(app_ssl_session_cache[i].session);
+        app_ssl_session_cache[i].session = NULL;
+    }
+    strncpy(app_ssl_session_cache[i].host, host, sizeof app_ssl_session_cache[i].host - 1);
+    app_ssl_session_cache[i].host[sizeof app_ssl_session_cache[i].host - 1] = '\0';
+
+done:
+    return i;
+}
+
+static void app_ssl_forget_session(int const slot)
+{
+    if (app_ssl_session_cache[slot].session != NULL)
+    {
+        SSL_SESSION_free(app_ssl_session_cache[slot].session);
+        app_ssl_session_cache[slot].session = NULL;
+    }
+}
+
+/*
+ * Called by openssl for every session the server hands out. With TLS 1.3 the
+ * tickets arrive after the handshake, so the latest one replaces the cached one.
+ */
+static int app_ssl_new_session(SSL * ssl, SSL_SESSION * session)
+{
+    app_ssl_t const * const ssl_ptr = SSL_get_app_data(ssl);
+
+    if ((ssl_ptr == NULL) || (ssl_ptr->session_slot < 0))
+        return 0;
+
+    app_ssl_forget_session(ssl_ptr->session_slot);
+    app_ssl_session_cache[ssl_ptr->session_slot].session = session;
+
+    return 1; /* the cache keeps the reference */
+}
+
+static SSL_CTX * app_ssl_get_context(void)
+{
+    SSL_CTX * ctx;
+
+    if (app_ssl_ctx != NULL)
+        goto done;
+
+    SSL_library_init();
+    OpenSSL_add_all_algorithms();
+    SSL_load_error_strings();
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+    ctx = SSL_CTX_new(TLS_client_method());
+#else
+    ctx = SSL_CTX_new(SSLv23_client_method());
+#endif
+    if (ctx == NULL)
+    {
+        ERR_print_errors_fp(stderr);
+        goto done;
+    }
+
+    /* TLS 1.2 or newer only */
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+#else
+    SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_NO_TLSv1 | SSL_OP_NO_TLSv1_1);
+#endif
+    SSL_CTX_set_options(ctx, SSL_OP_ALL);
+
+    /* the socket is non-blocking, a retried write may carry more data from another buffer */
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    /* sessions are stored by app_ssl_new_session(), not by openssl */
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, app_ssl_new_session);
+
+    if (app_load_certificate_and_key(ctx) != 1)
+    {
+        SSL_CTX_free(ctx);
+        goto done;
+    }
+
+    app_ssl_ctx = ctx;
+
+done:
+    return app_ssl_ctx;
+}
+
+void app_ssl_get_handshake(app_ssl_handshake_t * const handshake)
+{
+    *handshake = app_ssl_handshake;
+}
+
 static int app_verify_device_cloud_certificate(SSL * const ssl)
 {
     int ret = -1;
@@ -245,21 +371,18 @@ done:
     return ret;
 }
 
-static int app_ssl_connect(app_ssl_t * const ssl_ptr)
+static int app_ssl_connect(app_ssl_t * const ssl_ptr, char const * const host)
 {
     int ret = -1;
+    SSL_CTX * const ctx = app_ssl_get_context();
+    unsigned long start_time = 0;
+    unsigned long end_time = 0;
 
-    SSL_library_init();
-    OpenSSL_add_all_algorithms();
-    SSL_load_error_strings();
-    ssl_ptr->ctx = SSL_CTX_new(TLSv1_client_method());
-    if (ssl_ptr->ctx == NULL)
-    {
-        ERR_print_errors_fp(stderr);
+    ssl_ptr->session_slot = -1;
+    if (ctx == NULL)
         goto error;
-    }
 
-    ssl_ptr->ssl = SSL_new(ssl_ptr->ctx);
+    ssl_ptr->ssl = SSL_new(ctx);
     if (ssl_ptr->ssl == NULL)
     {
         ERR_print_errors_fp(stderr);
@@ -267,19 +390,37 @@ static int app_ssl_connect(app_ssl_t * const ssl_ptr)
     }
 
     SSL_set_fd(ssl_ptr->ssl, ssl_ptr->sfd);
-    if (app_load_certificate_and_key(ssl_ptr->ctx) != 1)
-        goto error;
+    SSL_set_app_data(ssl_ptr->ssl, ssl_ptr);
+    SSL_set_tlsext_host_name(ssl_ptr->ssl, host);
 
-    SSL_set_options(ssl_ptr->ssl, SSL_OP_ALL);
+    ssl_ptr->session_slot = app_ssl_session_slot(host);
+    if (app_ssl_session_cache[ssl_ptr->session_slot].session != NULL)
+        SSL_set_session(ssl_ptr->ssl, app_ssl_session_cache[ssl_ptr->session_slot].session);
+
+    app_os_get_system_time_in_milliseconds(&start_time);
     if (SSL_connect(ssl_ptr->ssl) <= 0)
     {
         ERR_print_errors_fp(stderr);
+        app_ssl_forget_session(ssl_ptr->session_slot);
         goto error;
     }
+    app_os_get_system_time_in_milliseconds(&end_time);
 
     if (app_verify_device_cloud_certificate(ssl_ptr->ssl) != X509_V_OK)
+    {
+        app_ssl_forget_session(ssl_ptr->session_slot);
         goto error;
+    }
+
+    app_ssl_handshake.handshake_ms = end_time - start_time;
+    app_ssl_handshake.resumed = SSL_session_reused(ssl_ptr->ssl) ? connector_true : connector_false;
+    if (app_ssl_handshake.resumed)
+        app_ssl_handshake.resumed_handshakes++;
+    else
+        app_ssl_handshake.full_handshakes++;
 
+    APP_DEBUG("app_ssl_connect: %s handshake with %s took %lu ms\n",
+              app_ssl_handshake.resumed ? "resumed" : "full", host, app_ssl_handshake.handshake_ms);
     ret = 0;
 
 error:
@@ -293,6 +434,7 @@ static connector_callback_status_t app_tcp_connect(in_addr_t const ip_addr,
     static app_ssl_t ssl_info = {0};
     socklen_t interface_addr_len;
 
+    ssl_info.wait_for_send = connector_false;
     ssl_info.sfd = app_setup_socket();
     if (ssl_info.sfd < 0)
     {
@@ -306,7 +448,7 @@ static connector_callback_status_t app_tcp_connect(in_addr_t const ip_addr,
     if (app_is_connect_complete(ssl_info.sfd) < 0)
         goto error;
 
-    if (app_ssl_connect(&ssl_info) < 0)
+    if (app_ssl_connect(&ssl_info, data->device_cloud.url) < 0)
         goto error;
 
     /* make it non-blocking now */
@@ -329,95 +471,142 @@ static connector_callback_status_t app_tcp_connect(in_addr_t const ip_addr,
     }
 
     APP_DEBUG("network_connect: connected\n");
+    app_os_wait_add_fd(ssl_info.sfd);
     data->handle = &ssl_info;
     status = connector_callback_continue;
     goto done;
 
 error:
     app_free_ssl_info(&ssl_info);
-    app_dns_set_redirected(connector_class_id_network_tcp, 0);
 
 done:
     return status;
 }
 
+static void app_ssl_set_wait_for_send(app_ssl_t * const ssl_ptr, connector_bool_t const enable)
+{
+    if (ssl_ptr->wait_for_send != enable)
+    {
+        app_os_wait_for_send(ssl_ptr->sfd, enable);
+        ssl_ptr->wait_for_send = enable;
+    }
+}
+
 /*
- * Send data to Device Cloud, this routine must not block.
+ * Maps a failed SSL_read() or SSL_write(). Either call may have to wait for
+ * the other direction (a renegotiation or key update), so WANT_READ and
+ * WANT_WRITE are both only busy.
  */
-static connector_callback_status_t app_network_tcp_send(connector_network_send_t * const data)
+static connector_callback_status_t app_ssl_io_status(app_ssl_t * const ssl_ptr, int const ret, char const * const function)
 {
-    connector_callback_status_t status = connector_callback_continue;
-    app_ssl_t * const ssl_ptr = data->handle;
-    int bytes_sent = 0;
+    connector_callback_status_t status;
 
-    bytes_sent = SSL_write(ssl_ptr->ssl, data->buffer, data->bytes_available);
-    if (bytes_sent <= 0)
+    switch (SSL_get_error(ssl_ptr->ssl, ret))
     {
-        APP_DEBUG("SSL_write failed %d\n", bytes_sent);
+    case SSL_ERROR_WANT_WRITE:
+        app_ssl_set_wait_for_send(ssl_ptr, connector_true);
+        status = connector_callback_busy;
+        break;
+
+    case SSL_ERROR_WANT_READ:
+        /* the socket is always watched for input */
+        status = connector_callback_busy;
+        break;
+
+    default:
+        /* EOF on input or a socket error: the connection is gone */
+        APP_DEBUG("%s failed %d\n", function, ret);
         SSL_set_shutdown(ssl_ptr->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
         app_dns_cache_invalidate(connector_class_id_network_tcp);
         status = connector_callback_error;
+        break;
     }
 
-    data->bytes_used = bytes_sent;
     return status;
 }
 
-/*
- * This routine reads a specified number of bytes from Device Cloud.
- */
-static connector_callback_status_t app_network_tcp_receive(connector_network_receive_t * const data)
+static connector_callback_status_t app_ssl_write(app_ssl_t * const ssl_ptr, void const * const buffer, size_t const length, size_t * const bytes_used)
 {
     connector_callback_status_t status = connector_callback_continue;
-    app_ssl_t * const ssl_ptr = data->handle;
-    int bytes_read = 0;
+    int bytes_sent;
 
-    if (SSL_pending(ssl_ptr->ssl) == 0)
+    ERR_clear_error();
+    bytes_sent = SSL_write(ssl_ptr->ssl, buffer, (int)length);
+    if (bytes_sent > 0)
     {
-        int ready;
-        struct timeval timeout;
-        fd_set read_set;
+        *bytes_used = (size_t)bytes_sent;
+        app_ssl_set_wait_for_send(ssl_ptr, connector_false);
+    }
+    else
+    {
+        *bytes_used = 0;
+        status = app_ssl_io_status(ssl_ptr, bytes_sent, "SSL_write");
+    }
 
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 0;
+    return status;
+}
 
-        FD_ZERO(&read_set);
-        FD_SET(ssl_ptr->sfd, &read_set);
+/*
+ * Send data to Device Cloud, this routine must not block.
+ */
+static connector_callback_status_t app_network_tcp_send(connector_network_send_t * const data)
+{
+    return app_ssl_write(data->handle, data->buffer, data->bytes_available, &data->bytes_used);
+}
 
-        ready = select(ssl_ptr->sfd + 1, &read_set, NULL, NULL, &timeout);
-        if (ready == 0)
-        {
-            status = connector_callback_busy;
-            goto done;
-        }
+/*
+ * Send several buffers to Device Cloud, this routine must not block.
+ * SSL has no gather write, so the fragments are packed into one record and
+ * still leave in a single SSL_write().
+ */
+#define APP_SSL_MAX_RECORD_SIZE 16384
 
-        if (ready < 0)
-        {
-           APP_DEBUG("app_network_receive: select failed\n");
-           goto done;
-        }
-    }
+static connector_callback_status_t app_network_tcp_send_vector(connector_network_send_vector_t * const data)
+{
+    static unsigned char record[APP_SSL_MAX_RECORD_SIZE];
+    size_t bytes = 0;
+    size_t i;
 
-    bytes_read = SSL_read(ssl_ptr->ssl, data->buffer, data->bytes_available);
-    if (bytes_read <= 0)
+    for (i = 0; (i < data->vector_count) && (bytes < sizeof record); i++)
     {
-        int ssl_error = SSL_get_error(ssl_ptr->ssl, bytes_read);
-        if (ssl_error == SSL_ERROR_WANT_READ)
-        {
-            status = connector_callback_busy;
-            goto done;
-        }
+        size_t const space = sizeof record - bytes;
+        size_t const length = (data->vector[i].length < space) ? data->vector[i].length : space;
 
-        /* EOF on input: the connection was closed. */
-        SSL_set_shutdown(ssl_ptr->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
-        APP_DEBUG("SSL_read failed %d\n", bytes_read);
-        app_dns_cache_invalidate(connector_class_id_network_tcp);
-        status = connector_callback_error;
+        memcpy(&record[bytes], data->vector[i].buffer, length);
+        bytes += length;
     }
 
-    data->bytes_used = (size_t)bytes_read;
+    return app_ssl_write(data->handle, record, bytes, &data->bytes_used);
+}
+
+/*
+ * This routine reads up to the specified number of bytes from Device Cloud.
+ * The socket is non-blocking, so SSL_read() returns right away when no
+ * complete record is buffered and this routine never waits. Bytes OpenSSL
+ * has already decrypted are not seen by the socket wait, so app_os_yield()
+ * is woken while any are left.
+ */
+static connector_callback_status_t app_network_tcp_receive(connector_network_receive_t * const data)
+{
+    connector_callback_status_t status = connector_callback_continue;
+    app_ssl_t * const ssl_ptr = data->handle;
+    int bytes_read;
+
+    ERR_clear_error();
+    bytes_read = SSL_read(ssl_ptr->ssl, data->buffer, (int)data->bytes_available);
+    if (bytes_read > 0)
+    {
+        data->bytes_used = (size_t)bytes_read;
+        app_ssl_set_wait_for_send(ssl_ptr, connector_false);
+        if (SSL_pending(ssl_ptr->ssl) > 0)
+            app_os_wakeup();
+    }
+    else
+    {
+        data->bytes_used = 0;
+        status = app_ssl_io_status(ssl_ptr, bytes_read, "SSL_read");
+    }
 
-done:
     return status;
 }
 
@@ -430,10 +619,9 @@ static connector_callback_status_t app_network_tcp_close(connector_network_close
     if (SSL_shutdown(ssl_ptr->ssl) == 0)
         SSL_shutdown(ssl_ptr->ssl);  /* wait for peer's close notify */
 
+    app_os_wait_remove_fd(ssl_ptr->sfd);
     app_free_ssl_info(ssl_ptr);
 
-    app_dns_set_redirected(connector_class_id_network_tcp, data->status == connector_close_status_cloud_redirected);
-
     data->reconnect = app_connector_reconnect(connector_class_id_network_tcp, data->status);
     return status;
 }
@@ -446,7 +634,8 @@ static connector_callback_status_t app_network_tcp_open(connector_network_open_t
     status = app_dns_resolve(connector_class_id_network_tcp, data->device_cloud.url, &ip_addr);
     if (status != connector_callback_continue)
     {
-        APP_DEBUG("app_network_tcp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
+        if (status == connector_callback_error)
+            APP_DEBUG("app_network_tcp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
         goto done;
     }
 
@@ -481,6 +670,10 @@ connector_callback_status_t app_network_tcp_handler(connector_request_id_network
         status = app_network_tcp_send(data);
         break;
 
+    case connector_request_id_network_send_vector:
+        status = app_network_tcp_send_vector(data);
+        break;
+
     case connector_request_id_network_receive:
         status = app_network_tcp_receive(data);
         break;
@@ -24,6 +24,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <errno.h>
 
 #include "connector_api.h"
@@ -32,6 +33,18 @@
 
 #if defined CONNECTOR_TRANSPORT_UDP
 
+/* set while app_os_yield() also waits for the socket to become writable */
+static connector_bool_t app_udp_wait_for_send = connector_false;
+
+static void app_udp_set_wait_for_send(int const fd, connector_bool_t const enable)
+{
+    if (app_udp_wait_for_send != enable)
+    {
+        app_os_wait_for_send(fd, enable);
+        app_udp_wait_for_send = enable;
+    }
+}
+
 static connector_callback_status_t app_network_udp_close(connector_network_close_t * const data)
 {
     connector_callback_status_t status = connector_callback_continue;
@@ -39,6 +52,9 @@ static connector_callback_status_t app_network_udp_close(connector_network_close
 
     data->reconnect = app_connector_reconnect(connector_class_id_network_udp, data->status);
 
+    app_os_wait_remove_fd(*fd);
+    app_udp_wait_for_send = connector_false;
+
     if (close(*fd) < 0)
     {
         APP_DEBUG("network_tcp_close: close() failed, errno %d\n", errno);
@@ -86,6 +102,57 @@ static connector_callback_status_t app_network_udp_receive(connector_network_rec
     return status;
 }
 
+/*
+ * Receives several datagrams from Device Cloud with a single recvmmsg(), one per slot.
+ * This routine must not block: the socket is non-blocking, so recvmmsg() returns the
+ * datagrams already queued. If there are none it returns connector_callback_busy.
+ */
+#define APP_MAX_RECEIVE_BATCH 16
+
+static connector_callback_status_t app_network_udp_receive_batch(connector_network_receive_batch_t * const data)
+{
+    connector_callback_status_t status = connector_callback_continue;
+    int * const fd = data->handle;
+    struct mmsghdr msg[APP_MAX_RECEIVE_BATCH];
+    struct iovec iov[APP_MAX_RECEIVE_BATCH];
+    unsigned int const count = (data->slot_count < APP_MAX_RECEIVE_BATCH) ? (unsigned int)data->slot_count : APP_MAX_RECEIVE_BATCH;
+    unsigned int i;
+    int ccode;
+
+    memset(msg, 0, sizeof msg);
+    for (i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (char *)data->buffer + (i * data->slot_size);
+        iov[i].iov_len = data->slot_size;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ccode = recvmmsg(*fd, msg, count, 0, NULL);
+    if (ccode >= 0)
+    {
+        for (i = 0; i < (unsigned int)ccode; i++)
+            data->bytes_used[i] = msg[i].msg_len;
+        data->slots_used = (size_t)ccode;
+    }
+    else
+    {
+        int const err = errno;
+        if (err == EAGAIN)
+        {
+            status = connector_callback_busy;
+        }
+        else
+        {
+            APP_DEBUG("app_network_udp_receive_batch: recvmmsg() failed, errno %d\n", err);
+            app_dns_cache_invalidate(connector_class_id_network_udp);
+            status = connector_callback_error;
+        }
+    }
+
+    return status;
+}
+
 /*
  * Sends data to Device Cloud, this routine must not block.  If it encounters
  * EAGAIN  error, return connector_callback_busy and Cloud Connector will ignore the
@@ -102,6 +169,7 @@ static connector_callback_status_t app_network_udp_send(connector_network_send_t
         int const err = errno;
         if (err == EAGAIN)
         {
+            app_udp_set_wait_for_send(*fd, connector_true);
             status = connector_callback_busy;
         }
         else
@@ -111,11 +179,66 @@ static connector_callback_status_t app_network_udp_send(connector_network_send_t
             app_dns_cache_invalidate(connector_class_id_network_udp);
         }
     }
+    else
+    {
+        app_udp_set_wait_for_send(*fd, connector_false);
+    }
     data->bytes_used = (size_t)bytes_sent;
 
     return status;
 }
 
+/*
+ * Sends several datagrams to Device Cloud with a single sendmmsg(), this routine must not
+ * block. If no datagram can be sent it returns connector_callback_busy and Cloud Connector
+ * will call this function again.
+ */
+#define APP_MAX_SEND_BATCH 16
+
+static connector_callback_status_t app_network_udp_send_batch(connector_network_send_batch_t * const data)
+{
+    connector_callback_status_t status = connector_callback_continue;
+    int * const fd = data->handle;
+    struct mmsghdr msg[APP_MAX_SEND_BATCH];
+    struct iovec iov[APP_MAX_SEND_BATCH];
+    unsigned int const count = (data->datagram_count < APP_MAX_SEND_BATCH) ? (unsigned int)data->datagram_count : APP_MAX_SEND_BATCH;
+    unsigned int i;
+    int ccode;
+
+    memset(msg, 0, sizeof msg);
+    for (i = 0; i < count; i++)
+    {
+        iov[i].iov_base = (void *)data->datagram[i].buffer;
+        iov[i].iov_len = data->datagram[i].length;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ccode = sendmmsg(*fd, msg, count, 0);
+    if (ccode >= 0)
+    {
+        data->datagrams_sent = (size_t)ccode;
+        app_udp_set_wait_for_send(*fd, connector_false);
+    }
+    else
+    {
+        int const err = errno;
+        if (err == EAGAIN)
+        {
+            app_udp_set_wait_for_send(*fd, connector_true);
+            status = connector_callback_busy;
+        }
+        else
+        {
+            status = connector_callback_error;
+            APP_DEBUG("app_network_udp_send_batch: sendmmsg() failed, errno %d\n", err);
+            app_dns_cache_invalidate(connector_class_id_network_udp);
+        }
+    }
+
+    return status;
+}
+
 static int  app_udp_create_socket(void)
 {
     int fd = socket(AF_INET, SOCK_DGRAM, 0);
@@ -175,7 +298,8 @@ static connector_callback_status_t app_network_udp_open(connector_network_open_t
     status = app_dns_resolve(connector_class_id_network_udp, data->device_cloud.url, &ip_addr);
     if (status != connector_callback_continue)
     {
-        APP_DEBUG("app_network_udp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
+        if (status == connector_callback_error)
+            APP_DEBUG("app_network_udp_open: Can't resolve DNS for %s\n", data->device_cloud.url);
         goto done;
     }
 
@@ -190,6 +314,8 @@ static connector_callback_status_t app_network_udp_open(connector_network_open_t
         }
 
         status = app_udp_connect(*pfd, ip_addr);
+        if (status == connector_callback_continue)
+            app_os_wait_add_fd(*pfd);
     }
 
     if ((status == connector_callback_error) && (*pfd >= 0))
@@ -222,10 +348,18 @@ connector_callback_status_t app_network_udp_handler(connector_request_id_network
         status = app_network_udp_send(data);
         break;
 
+    case connector_request_id_network_send_batch:
+        status = app_network_udp_send_batch(data);
+        break;
+
     case connector_request_id_network_receive:
         status = app_network_udp_receive(data);
         break;
 
+    case connector_request_id_network_receive_batch:
+        status = app_network_udp_receive_batch(data);
+        break;
+
     case connector_request_id_network_close:
         status = app_network_udp_close(data);
         break;
@@ -27,11 +27,113 @@
 #include <sys/reboot.h>
 #endif
 #include <sched.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 
+/* connector_run() thread blocks in epoll until a registered socket is ready,
+ * app_os_wakeup() is called or the next connector timer is due.
+ */
+static int app_epoll_fd = -1;
+static int app_wakeup_fd = -1;
+static pthread_once_t app_wait_once = PTHREAD_ONCE_INIT;
+/* set by a callback that stays busy until a worker calls app_os_wakeup(), only the connector_run() thread touches it */
+static connector_bool_t app_wait_for_wakeup = connector_false;
+
+static void app_os_wait_init(void)
+{
+    app_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (app_epoll_fd < 0)
+    {
+        APP_DEBUG("app_os_wait_init: epoll_create1 failed, errno %d\n", errno);
+        goto done;
+    }
+
+    app_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (app_wakeup_fd < 0)
+    {
+        APP_DEBUG("app_os_wait_init: eventfd failed, errno %d\n", errno);
+        goto error;
+    }
+
+    {
+        struct epoll_event event = {0};
+
+        event.events = EPOLLIN;
+        event.data.fd = app_wakeup_fd;
+        if (epoll_ctl(app_epoll_fd, EPOLL_CTL_ADD, app_wakeup_fd, &event) < 0)
+        {
+            APP_DEBUG("app_os_wait_init: epoll_ctl failed, errno %d\n", errno);
+            close(app_wakeup_fd);
+            app_wakeup_fd = -1;
+            goto error;
+        }
+    }
+    goto done;
+
+error:
+    close(app_epoll_fd);
+    app_epoll_fd = -1;
+
+done:
+    return;
+}
+
+static void app_os_wait_control(int const operation, int const fd, uint32_t const events)
+{
+    pthread_once(&app_wait_once, app_os_wait_init);
+
+    if (app_epoll_fd >= 0)
+    {
+        struct epoll_event event = {0};
+
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(app_epoll_fd, operation, fd, &event) < 0)
+            APP_DEBUG("app_os_wait_control: epoll_ctl(%d) failed on fd %d, errno %d\n", operation, fd, errno);
+    }
+}
+
+void app_os_wait_add_fd(int const fd)
+{
+    app_os_wait_control(EPOLL_CTL_ADD, fd, EPOLLIN);
+}
+
+void app_os_wait_remove_fd(int const fd)
+{
+    app_os_wait_control(EPOLL_CTL_DEL, fd, 0);
+}
+
+void app_os_wait_for_send(int const fd, connector_bool_t const enable)
+{
+    app_os_wait_control(EPOLL_CTL_MOD, fd, enable ? (EPOLLIN | EPOLLOUT) : EPOLLIN);
+}
+
+void app_os_wait_for_wakeup(void)
+{
+    app_wait_for_wakeup = connector_true;
+}
+
+static int app_os_wait_timeout(unsigned long const timeout_in_milliseconds)
+{
+    int timeout = (timeout_in_milliseconds == CONNECTOR_YIELD_WAIT_FOREVER) ? -1 : (timeout_in_milliseconds > INT_MAX) ? INT_MAX : (int)timeout_in_milliseconds;
+
+#if (defined CONNECTOR_TRANSPORT_SMS)
+    /* gammu has no descriptor to wait on, keep polling it */
+    if (timeout < 0 || timeout > APP_SMS_POLL_INTERVAL_IN_MILLISECONDS)
+        timeout = APP_SMS_POLL_INTERVAL_IN_MILLISECONDS;
+#endif
+
+    return timeout;
+}
+
 connector_callback_status_t app_os_malloc(size_t const size, void ** ptr)
 {
     connector_callback_status_t status = connector_callback_abort;
@@ -83,31 +185,71 @@ done:
     return status;
 }
 
+/* CLOCK_MONOTONIC does not jump when the wall clock is adjusted */
 connector_callback_status_t app_os_get_system_time(unsigned long * const uptime)
 {
-    static time_t start_system_up_time;
-    time_t present_time;
+    struct timespec present_time;
 
-    time(&present_time);
+    clock_gettime(CLOCK_MONOTONIC, &present_time);
+    *uptime = (unsigned long) present_time.tv_sec;
 
-    if (start_system_up_time == 0)
-       start_system_up_time = present_time;
+    return connector_callback_continue;
+}
 
-    present_time -= start_system_up_time;
-    *uptime = (unsigned long) present_time;
+connector_callback_status_t app_os_get_system_time_in_milliseconds(unsigned long * const uptime)
+{
+    struct timespec present_time;
+
+    clock_gettime(CLOCK_MONOTONIC, &present_time);
+    /* wraps around on 32-bit unsigned long, Cloud Connector only uses differences */
+    *uptime = ((unsigned long) present_time.tv_sec * 1000) + (unsigned long) (present_time.tv_nsec / 1000000);
 
     return connector_callback_continue;
 }
 
-connector_callback_status_t app_os_yield(connector_status_t const * const status)
+static void app_os_wait(int const timeout_in_milliseconds)
 {
-    int error;
+    pthread_once(&app_wait_once, app_os_wait_init);
 
-    if (*status == connector_idle)
+    if (app_epoll_fd >= 0)
+    {
+        struct epoll_event events[APP_MAX_WAIT_EVENTS];
+        int const count = epoll_wait(app_epoll_fd, events, ARRAY_SIZE(events), timeout_in_milliseconds);
+        int i;
+
+        if (count < 0 && errno != EINTR)
+            APP_DEBUG("app_os_yield: epoll_wait failed, errno %d\n", errno);
+
+        for (i = 0; i < count; i++)
+        {
+            if (events[i].data.fd == app_wakeup_fd)
+            {
+                uint64_t value;
+
+                if (read(app_wakeup_fd, &value, sizeof value) < 0 && errno != EAGAIN)
+                    APP_DEBUG("app_os_yield: eventfd read failed, errno %d\n", errno);
+            }
+        }
+    }
+    else
     {
         unsigned int const timeout_in_microseconds =  100000;
         usleep(timeout_in_microseconds);
     }
+}
+
+connector_callback_status_t app_os_yield(connector_os_yield_t const * const data)
+{
+    int error;
+
+    if (data->status == connector_idle)
+        app_os_wait(app_os_wait_timeout(data->timeout_in_milliseconds));
+    else if (app_wait_for_wakeup)
+    {
+        /* connector_pending has no timer to wait for, poll it again at most this late */
+        app_os_wait(app_os_wait_timeout(APP_WAKEUP_WAIT_IN_MILLISECONDS));
+    }
+    app_wait_for_wakeup = connector_false;
 
     error = sched_yield();
     if (error)
@@ -119,6 +261,21 @@ connector_callback_status_t app_os_yield(connector_status_t const * const status
     return connector_callback_continue;
 }
 
+connector_callback_status_t app_os_wakeup(void)
+{
+    pthread_once(&app_wait_once, app_os_wait_init);
+
+    if (app_wakeup_fd >= 0)
+    {
+        uint64_t const value = 1;
+
+        if (write(app_wakeup_fd, &value, sizeof value) < 0 && errno != EAGAIN)
+            APP_DEBUG("app_os_wakeup: eventfd write failed, errno %d\n", errno);
+    }
+
+    return connector_callback_continue;
+}
+
 static connector_callback_status_t app_os_reboot(void)
 {
     APP_DEBUG("app_os_reboot!\n");
@@ -166,13 +323,24 @@ connector_callback_status_t app_os_handler(connector_request_id_os_t const reque
         }
         break;
 
+    case connector_request_id_os_system_up_time_in_milliseconds:
+        {
+            connector_os_system_up_time_in_milliseconds_t * p = data;
+            status = app_os_get_system_time_in_milliseconds(&p->sys_uptime_in_milliseconds);
+        }
+        break;
+
     case connector_request_id_os_yield:
         {
             connector_os_yield_t * p = data;
-            status = app_os_yield(&p->status);
+            status = app_os_yield(p);
         }
         break;
 
+    case connector_request_id_os_wakeup:
+        status = app_os_wakeup();
+        break;
+
     case connector_request_id_os_reboot:
         status = app_os_reboot();
         break;
@@ -171,6 +171,11 @@ connector_callback_status_t app_os_handler(connector_request_id_os_t const reque
         status = app_os_reboot();
         break;
 
+    case connector_request_id_os_wakeup:
+        /* app_os_yield() does not block waiting for events */
+        status = connector_callback_continue;
+        break;
+
     default:
         APP_DEBUG("app_os_handler: unrecognized request [%d]\n", request);
         status = connector_callback_unrecognized;
@@ -188,6 +188,22 @@ connector_callback_status_t app_os_yield(connector_status_t const * const status
     return connector_callback_continue;
 }
 
+/**
+ * @brief   Wake up Cloud Connector thread
+ *
+ * Called from connector_initiate_action() in the application thread to wake up
+ * a connector_run() thread blocked in app_os_yield().
+ *
+ * @retval connector_callback_continue  Continue Cloud Connector
+ *
+ * @see @ref wakeup API Operating System Callback
+ */
+connector_callback_status_t app_os_wakeup(void)
+{
+    /* should signal the thread waiting in app_os_yield() */
+    return connector_callback_continue;
+}
+
 /**
  * @brief   Reboot the system
  *
@@ -255,6 +271,10 @@ connector_callback_status_t app_os_handler(connector_request_id_os_t const reque
         status = app_os_reboot();
         break;
 
+    case connector_request_id_os_wakeup:
+        status = app_os_wakeup();
+        break;
+
     default:
         APP_DEBUG("app_os_handler: unrecognized request [%d]\n", request);
         status = connector_callback_unrecognized;
@@ -567,6 +567,10 @@ static char const * app_network_class_to_string(connector_request_id_network_t c
         enum_to_case(connector_request_id_network_send);
         enum_to_case(connector_request_id_network_receive);
         enum_to_case(connector_request_id_network_close);
+        enum_to_case(connector_request_id_network_send_vector);
+        enum_to_case(connector_request_id_network_send_file);
+        enum_to_case(connector_request_id_network_send_batch);
+        enum_to_case(connector_request_id_network_receive_batch);
     }
     return result;
 }
@@ -582,6 +586,8 @@ static char const * app_os_class_to_string(connector_request_id_os_t const value
         enum_to_case(connector_request_id_os_system_up_time);
         enum_to_case(connector_request_id_os_yield);
         enum_to_case(connector_request_id_os_reboot);
+        enum_to_case(connector_request_id_os_wakeup);
+        enum_to_case(connector_request_id_os_system_up_time_in_milliseconds);
     }
     return result;
 }
@@ -618,6 +624,7 @@ static char const * app_remote_config_class_to_string(connector_request_id_remot
         enum_to_case(connector_request_id_remote_config_action_end);
         enum_to_case(connector_request_id_remote_config_session_end);
         enum_to_case(connector_request_id_remote_config_session_cancel);
+        enum_to_case(connector_request_id_remote_config_group_query);
     }
     return result;
 }
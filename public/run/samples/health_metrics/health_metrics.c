@@ -128,6 +128,7 @@ connector_status_t dev_health_send_metrics(connector_handle_t const connector_ha
     send_request->user_context = dev_health_data_push;
     send_request->content_type = "";
     send_request->option = connector_data_service_send_option_overwrite;
+    send_request->priority = connector_data_service_send_priority_normal;
     send_request->path = dev_health_path;
     send_request->request_id = NULL;
     send_request->timeout_in_seconds = 0;
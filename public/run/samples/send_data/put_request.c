@@ -46,6 +46,7 @@ connector_status_t app_send_put_request(connector_handle_t handle)
     app_data->bytes = strlen(buffer);
     header.transport = connector_transport_tcp;
     header.option = connector_data_service_send_option_append;
+    header.priority = connector_data_service_send_priority_normal;
     header.path  = file_path;
     header.content_type = file_type;
     header.user_context = app_data; /* will be returned in all subsequent callbacks */
@@ -0,0 +1,640 @@
+/*
+ * Copyright (c) 2014 Digi International Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
+ * =======================================================================
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "zlib.h"
+#include "connector_api.h"
+#include "platform.h"
+#include "connector_config.h"
+#include "file_hash.h"
+
+#if defined CONNECTOR_FILE_SYSTEM
+
+#if defined APP_ENABLE_MD5
+#include <openssl/md5.h>
+#endif
+
+/* Hashes are remembered per (device, inode, size, mtime), so a file is read again only
+ * after it changes. Define APP_FILE_HASH_CACHE_PATH to keep them across restarts.
+ */
+/* #define APP_FILE_HASH_CACHE_PATH    "connector_hash.cache" */
+
+/* Answer connector_file_system_hash_best with CRC32, which is much cheaper than MD5 */
+/* #define APP_FILE_HASH_BEST_IS_CRC32 */
+
+#define APP_FILE_HASH_CACHE_SIZE    512
+#define APP_FILE_HASH_BUFFER_SIZE   (64 * 1024)
+#define APP_FILE_HASH_MAX_SIZE      16
+#define APP_FILE_HASH_CACHE_MAGIC   0x43434831  /* "CCH1" */
+#define APP_FILE_HASH_MAX_PASSES    3
+
+#ifndef APP_MIN_VALUE
+#define APP_MIN_VALUE(a,b) (((a)<(b))?(a):(b))
+#endif
+
+#if defined CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH
+#define APP_FILE_HASH_PATH_SIZE     (CONNECTOR_FILE_SYSTEM_MAX_PATH_LENGTH + 1)
+#else
+#define APP_FILE_HASH_PATH_SIZE     257
+#endif
+
+typedef enum
+{
+    app_file_hash_empty,
+    app_file_hash_queued,
+    app_file_hash_ready,
+    app_file_hash_failed,
+    app_file_hash_changing
+} app_file_hash_state_t;
+
+typedef struct
+{
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    connector_file_system_hash_algorithm_t algorithm;
+    app_file_hash_state_t state;
+    unsigned long last_used;
+    unsigned char value[APP_FILE_HASH_MAX_SIZE];
+} app_file_hash_entry_t;
+
+/* File jobs come from a listing that is waiting and go first, a directory job hashes one entry at a time behind them */
+typedef struct app_file_hash_job
+{
+    struct app_file_hash_job * next;
+    connector_file_system_hash_algorithm_t algorithm;
+    DIR * dirp;
+    app_file_hash_entry_t * entry;
+    int is_dir;
+    char path[APP_FILE_HASH_PATH_SIZE];
+} app_file_hash_job_t;
+
+static app_file_hash_entry_t app_file_hash_cache[APP_FILE_HASH_CACHE_SIZE];
+static unsigned long app_file_hash_tick;
+static int app_file_hash_loaded;
+static int app_file_hash_dirty;
+static int app_file_hash_worker_running;
+static app_file_hash_job_t * app_file_hash_queue;
+static pthread_mutex_t app_file_hash_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t app_file_hash_signal = PTHREAD_COND_INITIALIZER;
+
+static size_t app_file_hash_size(connector_file_system_hash_algorithm_t const algorithm)
+{
+    return (algorithm == connector_file_system_hash_md5) ? 16 : 4;
+}
+
+connector_file_system_hash_algorithm_t app_file_hash_algorithm(connector_file_system_hash_algorithm_t const requested)
+{
+    connector_file_system_hash_algorithm_t algorithm = connector_file_system_hash_none;
+
+    switch (requested)
+    {
+        case connector_file_system_hash_best:
+#if defined APP_ENABLE_MD5 && !defined APP_FILE_HASH_BEST_IS_CRC32
+            algorithm = connector_file_system_hash_md5;
+#else
+            algorithm = connector_file_system_hash_crc32;
+#endif
+            break;
+
+        case connector_file_system_hash_crc32:
+            algorithm = connector_file_system_hash_crc32;
+            break;
+
+#if defined APP_ENABLE_MD5
+        case connector_file_system_hash_md5:
+            algorithm = connector_file_system_hash_md5;
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    return algorithm;
+}
+
+static void app_file_hash_load(void)
+{
+#if defined APP_FILE_HASH_CACHE_PATH
+    FILE * const file = fopen(APP_FILE_HASH_CACHE_PATH, "rb");
+    unsigned int header[2];
+
+    if (file == NULL)
+        goto done;
+
+    if ((fread(header, sizeof header, 1, file) == 1) && (header[0] == APP_FILE_HASH_CACHE_MAGIC) && (header[1] <= APP_FILE_HASH_CACHE_SIZE))
+    {
+        size_t const count = fread(app_file_hash_cache, sizeof app_file_hash_cache[0], header[1], file);
+        size_t i;
+
+        for (i = 0; i < count; i++)
+        {
+            if (app_file_hash_cache[i].state != app_file_hash_ready)
+                app_file_hash_cache[i].state = app_file_hash_empty;
+            app_file_hash_cache[i].last_used = 0;
+        }
+        memset(&app_file_hash_cache[count], 0, (APP_FILE_HASH_CACHE_SIZE - count) * sizeof app_file_hash_cache[0]);
+        APP_DEBUG("app_file_hash_load: %zu hashes from %s\n", count, APP_FILE_HASH_CACHE_PATH);
+    }
+    fclose(file);
+
+done:
+#endif
+    app_file_hash_loaded = 1;
+}
+
+/* Called by the worker without the lock, on a snapshot of the ready entries */
+static void app_file_hash_save(app_file_hash_entry_t const * const entries, unsigned int const count)
+{
+#if defined APP_FILE_HASH_CACHE_PATH
+    static char const temp_path[] = APP_FILE_HASH_CACHE_PATH ".tmp";
+    FILE * const file = fopen(temp_path, "wb");
+    unsigned int const header[2] = {APP_FILE_HASH_CACHE_MAGIC, count};
+    int ok;
+
+    if (file == NULL)
+    {
+        APP_DEBUG("app_file_hash_save: cannot create %s, errno %d\n", temp_path, errno);
+        goto done;
+    }
+
+    ok = (fwrite(header, sizeof header, 1, file) == 1) && (fwrite(entries, sizeof entries[0], count, file) == count);
+    if ((fclose(file) != 0) || !ok || (rename(temp_path, APP_FILE_HASH_CACHE_PATH) != 0))
+    {
+        APP_DEBUG("app_file_hash_save: failed, errno %d\n", errno);
+        remove(temp_path);
+    }
+
+done:
+    return;
+#else
+    UNUSED_ARGUMENT(entries);
+    UNUSED_ARGUMENT(count);
+#endif
+}
+
+/* Called with app_file_hash_lock held */
+static app_file_hash_entry_t * app_file_hash_find(struct stat const * const statbuf, connector_file_system_hash_algorithm_t const algorithm)
+{
+    app_file_hash_entry_t * entry = NULL;
+    size_t i;
+
+    for (i = 0; i < APP_FILE_HASH_CACHE_SIZE; i++)
+    {
+        app_file_hash_entry_t * const candidate = &app_file_hash_cache[i];
+
+        if ((candidate->state != app_file_hash_empty) && (candidate->algorithm == algorithm) &&
+            (candidate->ino == statbuf->st_ino) && (candidate->dev == statbuf->st_dev) &&
+            (candidate->size == statbuf->st_size) && (candidate->mtime == statbuf->st_mtime))
+        {
+            entry = candidate;
+            break;
+        }
+    }
+
+    return entry;
+}
+
+/* Called with app_file_hash_lock held: the entry still being hashed for this file, whatever its size and time are now */
+static app_file_hash_entry_t * app_file_hash_find_pending(struct stat const * const statbuf, connector_file_system_hash_algorithm_t const algorithm)
+{
+    app_file_hash_entry_t * entry = NULL;
+    size_t i;
+
+    for (i = 0; i < APP_FILE_HASH_CACHE_SIZE; i++)
+    {
+        app_file_hash_entry_t * const candidate = &app_file_hash_cache[i];
+
+        if (((candidate->state == app_file_hash_queued) || (candidate->state == app_file_hash_changing)) &&
+            (candidate->algorithm == algorithm) && (candidate->ino == statbuf->st_ino) && (candidate->dev == statbuf->st_dev))
+        {
+            entry = candidate;
+            break;
+        }
+    }
+
+    return entry;
+}
+
+/* Called with app_file_hash_lock held: an empty entry or the least recently used one that is not queued */
+static app_file_hash_entry_t * app_file_hash_new_entry(struct stat const * const statbuf, connector_file_system_hash_algorithm_t const algorithm)
+{
+    app_file_hash_entry_t * entry = NULL;
+    size_t i;
+
+    for (i = 0; i < APP_FILE_HASH_CACHE_SIZE; i++)
+    {
+        app_file_hash_entry_t * const candidate = &app_file_hash_cache[i];
+
+        if (candidate->state == app_file_hash_queued)
+            continue;
+
+        /* an older hash of the same file is stale now */
+        if ((candidate->state != app_file_hash_empty) && (candidate->ino == statbuf->st_ino) && (candidate->dev == statbuf->st_dev) &&
+            (candidate->algorithm == algorithm))
+        {
+            entry = candidate;
+            break;
+        }
+
+        if ((entry == NULL) || (candidate->state == app_file_hash_empty) ||
+            ((entry->state != app_file_hash_empty) && (candidate->last_used < entry->last_used)))
+            entry = candidate;
+    }
+
+    if (entry != NULL)
+    {
+        entry->dev = statbuf->st_dev;
+        entry->ino = statbuf->st_ino;
+        entry->size = statbuf->st_size;
+        entry->mtime = statbuf->st_mtime;
+        entry->algorithm = algorithm;
+        entry->state = app_file_hash_queued;
+        entry->last_used = ++app_file_hash_tick;
+    }
+
+    return entry;
+}
+
+static int app_file_hash_compute(char const * const path, connector_file_system_hash_algorithm_t const algorithm, unsigned char * const value)
+{
+    static unsigned char buffer[APP_FILE_HASH_BUFFER_SIZE];
+    int result = -1;
+    uLong crc = crc32(0L, Z_NULL, 0);
+#if defined APP_ENABLE_MD5
+    MD5_CTX md5;
+#endif
+    ssize_t bytes;
+    int const fd = open(path, O_RDONLY);
+
+#if !defined APP_ENABLE_MD5
+    UNUSED_ARGUMENT(algorithm);
+#endif
+    if (fd < 0)
+    {
+        APP_DEBUG("app_file_hash_compute: open %s failed, errno %d\n", path, errno);
+        goto done;
+    }
+
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#if defined APP_ENABLE_MD5
+    MD5_Init(&md5);
+#endif
+
+    while ((bytes = read(fd, buffer, sizeof buffer)) > 0)
+    {
+#if defined APP_ENABLE_MD5
+        if (algorithm == connector_file_system_hash_md5)
+        {
+            MD5_Update(&md5, buffer, (size_t)bytes);
+            continue;
+        }
+#endif
+        crc = crc32(crc, buffer, (uInt)bytes);
+    }
+    close(fd);
+
+    if (bytes < 0)
+    {
+        APP_DEBUG("app_file_hash_compute: read %s failed, errno %d\n", path, errno);
+        goto done;
+    }
+
+#if defined APP_ENABLE_MD5
+    if (algorithm == connector_file_system_hash_md5)
+        MD5_Final(value, &md5);
+    else
+#endif
+    {
+        value[0] = (unsigned char)(crc >> 24);
+        value[1] = (unsigned char)(crc >> 16);
+        value[2] = (unsigned char)(crc >> 8);
+        value[3] = (unsigned char)crc;
+    }
+    result = 0;
+
+done:
+    return result;
+}
+
+/* Hashes a file for the queued entry. A file that changes while it is read is read again, up to
+ * APP_FILE_HASH_MAX_PASSES times; after that the hash of the last pass is answered once and not kept.
+ */
+static void app_file_hash_file(char const * const path, app_file_hash_entry_t * const entry)
+{
+    connector_file_system_hash_algorithm_t const algorithm = entry->algorithm;
+    unsigned char value[APP_FILE_HASH_MAX_SIZE];
+    unsigned int pass;
+
+    for (pass = 1; ; pass++)
+    {
+        struct stat after;
+        int const result = app_file_hash_compute(path, algorithm, value);
+        int const gone = (stat(path, &after) != 0);
+        int again = 0;
+
+        pthread_mutex_lock(&app_file_hash_lock);
+        if (gone || (result != 0))
+            entry->state = app_file_hash_failed;
+        else
+        {
+            memcpy(entry->value, value, sizeof entry->value);
+            if ((after.st_size == entry->size) && (after.st_mtime == entry->mtime))
+            {
+                entry->state = app_file_hash_ready;
+                app_file_hash_dirty = 1;
+            }
+            else
+            {
+                entry->size = after.st_size;
+                entry->mtime = after.st_mtime;
+                if (pass < APP_FILE_HASH_MAX_PASSES)
+                    again = 1;
+                else
+                    entry->state = app_file_hash_changing;
+            }
+        }
+        pthread_mutex_unlock(&app_file_hash_lock);
+
+        if (!again)
+            break;
+    }
+
+    /* let connector_run() call the hash callback again */
+    app_os_wakeup();
+}
+
+/* Takes the next entry of a directory job and hashes it unless it is known already. Returns 0 when the directory is done. */
+static int app_file_hash_dir_entry(app_file_hash_job_t * const job)
+{
+    struct dirent * dir_entry;
+    char path[APP_FILE_HASH_PATH_SIZE];
+    struct stat statbuf;
+    app_file_hash_entry_t * entry = NULL;
+
+    if (job->dirp == NULL)
+    {
+        job->dirp = opendir(job->path);
+        if (job->dirp == NULL)
+            return 0;
+    }
+
+    dir_entry = readdir(job->dirp);
+    if (dir_entry == NULL)
+        return 0;
+
+    if ((snprintf(path, sizeof path, "%s/%s", job->path, dir_entry->d_name) >= (int)sizeof path) ||
+        (stat(path, &statbuf) != 0) || !S_ISREG(statbuf.st_mode))
+        return 1;
+
+    pthread_mutex_lock(&app_file_hash_lock);
+    if ((app_file_hash_find(&statbuf, job->algorithm) == NULL) && (app_file_hash_find_pending(&statbuf, job->algorithm) == NULL))
+        entry = app_file_hash_new_entry(&statbuf, job->algorithm);
+    pthread_mutex_unlock(&app_file_hash_lock);
+
+    if (entry != NULL)
+        app_file_hash_file(path, entry);
+
+    return 1;
+}
+
+static void app_file_hash_remove_job(app_file_hash_job_t * const job)
+{
+    app_file_hash_job_t ** link = &app_file_hash_queue;
+
+    while (*link != job)
+        link = &(*link)->next;
+    *link = job->next;
+}
+
+static void * app_file_hash_worker(void * arg)
+{
+    static app_file_hash_entry_t snapshot[APP_FILE_HASH_CACHE_SIZE];
+
+    UNUSED_ARGUMENT(arg);
+    pthread_mutex_lock(&app_file_hash_lock);
+
+    for (;;)
+    {
+        app_file_hash_job_t * const job = app_file_hash_queue;
+
+        if (job == NULL)
+        {
+            if (app_file_hash_dirty)
+            {
+                unsigned int count = 0;
+                size_t i;
+
+                for (i = 0; i < APP_FILE_HASH_CACHE_SIZE; i++)
+                {
+                    if (app_file_hash_cache[i].state == app_file_hash_ready)
+                        snapshot[count++] = app_file_hash_cache[i];
+                }
+                app_file_hash_dirty = 0;
+
+                pthread_mutex_unlock(&app_file_hash_lock);
+                app_file_hash_save(snapshot, count);
+                pthread_mutex_lock(&app_file_hash_lock);
+                continue;
+            }
+
+            pthread_cond_wait(&app_file_hash_signal, &app_file_hash_lock);
+            continue;
+        }
+
+        /* the job stays queued while it runs, new file jobs go in front of it */
+        pthread_mutex_unlock(&app_file_hash_lock);
+
+        if (job->is_dir)
+        {
+            int const more = app_file_hash_dir_entry(job);
+
+            pthread_mutex_lock(&app_file_hash_lock);
+            if (more)
+                continue;
+            if (job->dirp != NULL)
+                closedir(job->dirp);
+        }
+        else
+        {
+            app_file_hash_file(job->path, job->entry);
+            pthread_mutex_lock(&app_file_hash_lock);
+        }
+
+        app_file_hash_remove_job(job);
+        free(job);
+    }
+
+    return NULL;
+}
+
+/* Called with app_file_hash_lock held */
+static int app_file_hash_queue_job(char const * const path, connector_file_system_hash_algorithm_t const algorithm, app_file_hash_entry_t * const entry)
+{
+    app_file_hash_job_t * const job = malloc(sizeof *job);
+    int result = -1;
+
+    if ((job == NULL) || (strlen(path) >= sizeof job->path))
+        goto error;
+
+    strcpy(job->path, path);
+    job->algorithm = algorithm;
+    job->entry = entry;
+    job->is_dir = (entry == NULL);
+    job->dirp = NULL;
+
+    if (!app_file_hash_worker_running)
+    {
+        pthread_attr_t attr;
+        pthread_t thread;
+        int error;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        error = pthread_create(&thread, &attr, app_file_hash_worker, NULL);
+        pthread_attr_destroy(&attr);
+        if (error != 0)
+        {
+            APP_DEBUG("app_file_hash_queue_job: pthread_create failed, error %d\n", error);
+            goto error;
+        }
+        app_file_hash_worker_running = 1;
+    }
+
+    if (job->is_dir)
+    {
+        app_file_hash_job_t ** link = &app_file_hash_queue;
+
+        while (*link != NULL)
+            link = &(*link)->next;
+        job->next = NULL;
+        *link = job;
+    }
+    else
+    {
+        job->next = app_file_hash_queue;
+        app_file_hash_queue = job;
+    }
+
+    pthread_cond_signal(&app_file_hash_signal);
+    result = 0;
+    goto done;
+
+error:
+    free(job);
+done:
+    return result;
+}
+
+void app_file_hash_prefetch(char const * const dir_path, connector_file_system_hash_algorithm_t const algorithm)
+{
+    app_file_hash_job_t const * job;
+
+    pthread_mutex_lock(&app_file_hash_lock);
+    if (!app_file_hash_loaded)
+        app_file_hash_load();
+
+    for (job = app_file_hash_queue; job != NULL; job = job->next)
+    {
+        if (job->is_dir && (job->algorithm == algorithm) && (strcmp(job->path, dir_path) == 0))
+            break;
+    }
+
+    if (job == NULL)
+        app_file_hash_queue_job(dir_path, algorithm, NULL);
+    pthread_mutex_unlock(&app_file_hash_lock);
+}
+
+connector_callback_status_t app_file_hash_get(char const * const path, connector_file_system_hash_algorithm_t const algorithm,
+                                              void * const value, size_t const bytes)
+{
+    connector_callback_status_t status = connector_callback_continue;
+    size_t const hash_bytes = APP_MIN_VALUE(bytes, app_file_hash_size(algorithm));
+    struct stat statbuf;
+    app_file_hash_entry_t * entry;
+
+    memset(value, 0, bytes);
+    if (stat(path, &statbuf) != 0)
+    {
+        APP_DEBUG("app_file_hash_get: stat %s failed, errno %d\n", path, errno);
+        goto done;
+    }
+
+    pthread_mutex_lock(&app_file_hash_lock);
+    if (!app_file_hash_loaded)
+        app_file_hash_load();
+
+    entry = app_file_hash_find(&statbuf, algorithm);
+    if (entry == NULL)
+        entry = app_file_hash_find_pending(&statbuf, algorithm);
+    if (entry == NULL)
+    {
+        entry = app_file_hash_new_entry(&statbuf, algorithm);
+        if (entry == NULL)
+            status = connector_callback_busy;
+        else if (app_file_hash_queue_job(path, algorithm, entry) == 0)
+            status = connector_callback_busy;
+        else
+            entry->state = app_file_hash_empty;
+    }
+    else
+    {
+        switch (entry->state)
+        {
+            case app_file_hash_ready:
+                memcpy(value, entry->value, hash_bytes);
+                entry->last_used = ++app_file_hash_tick;
+                break;
+
+            case app_file_hash_failed:
+                /* answer zeros this time, the next listing tries again */
+                entry->state = app_file_hash_empty;
+                break;
+
+            case app_file_hash_changing:
+                /* kept changing while it was read, answer the last pass once */
+                memcpy(value, entry->value, hash_bytes);
+                entry->state = app_file_hash_empty;
+                break;
+
+            default:
+                status = connector_callback_busy;
+                break;
+        }
+    }
+    pthread_mutex_unlock(&app_file_hash_lock);
+    /* the worker calls app_os_wakeup() when the hash is done */
+    if (status == connector_callback_busy)
+        app_os_wait_for_wakeup();
+
+done:
+    return status;
+}
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2014 Digi International Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+ * REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+ * INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+ * LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+ * OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+ * PERFORMANCE OF THIS SOFTWARE.
+ *
+ * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
+ * =======================================================================
+ */
+
+#ifndef _FILE_HASH_H
+#define _FILE_HASH_H
+
+/* Algorithm used for a listing, connector_file_system_hash_none if it cannot be served */
+extern connector_file_system_hash_algorithm_t app_file_hash_algorithm(connector_file_system_hash_algorithm_t const requested);
+
+/* Starts hashing the regular files of a directory in the background, ahead of the listing */
+extern void app_file_hash_prefetch(char const * const dir_path, connector_file_system_hash_algorithm_t const algorithm);
+
+/* Returns connector_callback_busy until the hash of the file is known, then fills value */
+extern connector_callback_status_t app_file_hash_get(char const * const path, connector_file_system_hash_algorithm_t const algorithm,
+                                                     void * const value, size_t const bytes);
+
+#endif
@@ -61,6 +61,11 @@ int main (void)
         {
             usleep(1000);
         }
+        else if (status == connector_pending)
+        {
+            /* blocks only while a callback waits for a worker thread */
+            app_os_yield(&status);
+        }
     }
 
 done:
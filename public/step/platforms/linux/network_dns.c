@@ -16,13 +16,15 @@
  * Digi International Inc. 11001 Bren Road East, Minnetonka, MN 55343
  * =======================================================================
  */
+#include <stdlib.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
-#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
+#include <arpa/nameser.h>
+#include <resolv.h>
+#include <pthread.h>
 #include <errno.h>
 
 #include "connector_api.h"
@@ -31,145 +33,422 @@
 
 #if defined (CONNECTOR_TRANSPORT_TCP) || (defined CONNECTOR_TRANSPORT_UDP)
 
-#define APP_DNS_CACHE_TIMEOUT   (24 * 3600)
-#define APP_MAX_HOST_NAME   64
+/* A few names per transport: the EDP URL, the SM URL and a redirect target
+ * can all be cached at once. Entries expire with the smallest TTL of their
+ * records, clamped to the limits below. Names only found through
+ * getaddrinfo() (e.g. /etc/hosts) have no TTL and use the default.
+ */
+#define APP_DNS_CACHE_SIZE      4
+#define APP_DNS_MIN_TTL         30
+#define APP_DNS_MAX_TTL         (24 * 3600)
+#define APP_DNS_DEFAULT_TTL     300
+#define APP_MAX_HOST_NAME       256  /* a DNS name is at most 253 characters */
+#define APP_DNS_ANSWER_SIZE     1024
+
+typedef enum
+{
+    app_dns_empty,
+    app_dns_pending,
+    app_dns_ready,
+    app_dns_failed
+} app_dns_state_t;
 
 typedef struct
 {
+    connector_class_id_t class_id;
     char name[APP_MAX_HOST_NAME];
-    in_addr_t ip_addr;
-    unsigned long sys_time;
-    int is_redirected;
-} app_dns_cache_t;
-
-static app_dns_cache_t app_dns_cache = {"", INADDR_NONE, 0, 0};
-#define app_dns_is_redirected(class_id) ((class_id) == connector_class_id_network_udp ? 0 : app_dns_cache.is_redirected)
+    app_dns_state_t state;
+    app_dns_address_t address[APP_DNS_MAX_ADDRESSES];
+    size_t count;
+    unsigned long expires;
+    unsigned long last_used;
+} app_dns_entry_t;
 
-static int app_dns_cache_is_valid(connector_class_id_t const class_id,
-                                   char const * const device_cloud_url,
-                                   in_addr_t * const ip_addr)
+/* a lookup owns its entry until it is done, pending entries are never reused */
+typedef struct
 {
-    int valid = 0;
+    app_dns_entry_t * entry;
+    char name[APP_MAX_HOST_NAME];
+} app_dns_job_t;
 
-    if (!app_dns_is_redirected(class_id))
+static app_dns_entry_t app_dns_cache[APP_DNS_CACHE_SIZE];
+static pthread_mutex_t app_dns_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void app_dns_add_address(app_dns_address_t * const list, size_t * const count, int const family, void const * const addr)
+{
+    if (*count < APP_DNS_MAX_ADDRESSES)
     {
-        if ((app_dns_cache.ip_addr != INADDR_NONE) && (strncmp(app_dns_cache.name, device_cloud_url, APP_MAX_HOST_NAME) == 0))
+        app_dns_address_t * const entry = &list[*count];
+
+        memset(entry, 0, sizeof *entry);
+        if (family == AF_INET6)
         {
-            unsigned long elapsed_time;
+            struct sockaddr_in6 * const sin6 = cast_for_alignment(struct sockaddr_in6 *, &entry->addr);
 
-            app_os_get_system_time(&elapsed_time);
-            if ((elapsed_time - app_dns_cache.sys_time) < APP_DNS_CACHE_TIMEOUT)
-            {
-                *ip_addr = app_dns_cache.ip_addr;
-                valid = 1;
-            }
+            sin6->sin6_family = AF_INET6;
+            memcpy(&sin6->sin6_addr, addr, sizeof sin6->sin6_addr);
+            entry->length = sizeof *sin6;
+        }
+        else
+        {
+            struct sockaddr_in * const sin = cast_for_alignment(struct sockaddr_in *, &entry->addr);
+
+            sin->sin_family = AF_INET;
+            memcpy(&sin->sin_addr, addr, sizeof sin->sin_addr);
+            entry->length = sizeof *sin;
         }
+        (*count)++;
+    }
+}
+
+/* Asks the resolver for one record type, keeping the addresses and the smallest TTL. */
+static void app_dns_query(res_state const res, char const * const name, int const type,
+                          app_dns_address_t * const list, size_t * const count, unsigned long * const ttl)
+{
+    unsigned char answer[APP_DNS_ANSWER_SIZE];
+    int const length = res_nsearch(res, name, ns_c_in, type, answer, sizeof answer);
+    ns_msg msg;
+    int i;
+
+    if ((length < 0) || (ns_initparse(answer, length, &msg) < 0))
+        goto done;
+
+    for (i = 0; i < ns_msg_count(msg, ns_s_an); i++)
+    {
+        ns_rr rr;
+
+        if (ns_parserr(&msg, ns_s_an, i, &rr) < 0)
+            break;
+
+        /* the TTL of a CNAME on the way limits the answer too */
+        if (ns_rr_ttl(rr) < *ttl)
+            *ttl = ns_rr_ttl(rr);
+
+        if ((type == ns_t_a) && (ns_rr_type(rr) == ns_t_a) && (ns_rr_rdlen(rr) == sizeof(struct in_addr)))
+            app_dns_add_address(list, count, AF_INET, ns_rr_rdata(rr));
+        else if ((type == ns_t_aaaa) && (ns_rr_type(rr) == ns_t_aaaa) && (ns_rr_rdlen(rr) == sizeof(struct in6_addr)))
+            app_dns_add_address(list, count, AF_INET6, ns_rr_rdata(rr));
     }
 
-    return valid;
+done:
+    return;
 }
 
-static void app_dns_cache_update(connector_class_id_t const class_id,
-                                 char const * const device_cloud_url,
-                                 in_addr_t const ip_addr)
+static void app_dns_getaddrinfo(char const * const name, app_dns_address_t * const list, size_t * const count)
 {
-    if (!app_dns_is_redirected(class_id))
+    struct addrinfo hint = {0};
+    struct addrinfo * res_list;
+    struct addrinfo * res;
+
+    hint.ai_socktype = SOCK_STREAM;
+    hint.ai_family = AF_UNSPEC;
+    if (getaddrinfo(name, NULL, &hint, &res_list) != 0)
+        goto done;
+
+    for (res = res_list; res != NULL; res = res->ai_next)
     {
-        strncpy(app_dns_cache.name, device_cloud_url, APP_MAX_HOST_NAME - 1);
-        app_dns_cache.name[APP_MAX_HOST_NAME - 1] = '\0';
-        app_dns_cache.ip_addr = ip_addr;
-        app_os_get_system_time(&app_dns_cache.sys_time);
+        if (res->ai_family == AF_INET6)
+        {
+            struct sockaddr_in6 const * const sin6 = cast_for_alignment(struct sockaddr_in6 const *, res->ai_addr);
+
+            app_dns_add_address(list, count, AF_INET6, &sin6->sin6_addr);
+        }
+        else if (res->ai_family == AF_INET)
+        {
+            struct sockaddr_in const * const sin = cast_for_alignment(struct sockaddr_in const *, res->ai_addr);
+
+            app_dns_add_address(list, count, AF_INET, &sin->sin_addr);
+        }
     }
+
+    freeaddrinfo(res_list);
+
+done:
+    return;
 }
 
-static int app_dns_resolve_name(char const * const domain_name, in_addr_t * const ip_addr)
+static void * app_dns_worker(void * arg)
 {
-    int ret = -1;
-    struct addrinfo *res_list;
-    struct addrinfo *res;
-
-   {
-        struct addrinfo hint = {0};
-        int error;
-
-        hint.ai_socktype = SOCK_STREAM;
-        hint.ai_family   = AF_INET;
-        error = getaddrinfo(domain_name, NULL, &hint, &res_list);
-        if (error != 0)
+    app_dns_job_t * const job = arg;
+    app_dns_address_t ipv6[APP_DNS_MAX_ADDRESSES];
+    app_dns_address_t ipv4[APP_DNS_MAX_ADDRESSES];
+    app_dns_address_t all[APP_DNS_MAX_ADDRESSES];
+    size_t ipv6_count = 0;
+    size_t ipv4_count = 0;
+    size_t count = 0;
+    unsigned long ttl = APP_DNS_MAX_TTL;
+
+    {
+        struct __res_state res;
+
+        memset(&res, 0, sizeof res);
+        if (res_ninit(&res) == 0)
         {
-            APP_DEBUG("dns_resolve_name: DNS resolution failed for [%s]\n", domain_name);
-            goto done;
+            app_dns_query(&res, job->name, ns_t_aaaa, ipv6, &ipv6_count, &ttl);
+            app_dns_query(&res, job->name, ns_t_a, ipv4, &ipv4_count, &ttl);
+            res_nclose(&res);
         }
     }
 
-    /* loop over all returned results and look for a IPv4 address */
-    for (res = res_list; res; res = res->ai_next)
+    if ((ipv6_count + ipv4_count) == 0)
     {
-        if (res->ai_family == PF_INET)
+        app_dns_address_t found[APP_DNS_MAX_ADDRESSES];
+        size_t found_count = 0;
+        size_t i;
+
+        app_dns_getaddrinfo(job->name, found, &found_count);
+        for (i = 0; i < found_count; i++)
         {
-            struct sockaddr_in * const sa = cast_for_alignment(struct sockaddr_in *, res->ai_addr);
-            struct in_addr const ipv4_addr = sa->sin_addr;
+            if (found[i].addr.ss_family == AF_INET6)
+                ipv6[ipv6_count++] = found[i];
+            else
+                ipv4[ipv4_count++] = found[i];
+        }
+        ttl = APP_DNS_DEFAULT_TTL;
+    }
 
-            *ip_addr = ipv4_addr.s_addr;
-            APP_DEBUG("dns_resolve_name: ip address = [%s]\n", inet_ntoa(ipv4_addr));
-            ret = 0;
-            break;
+    /* alternate the families, IPv6 first (RFC 8305) */
+    {
+        size_t i;
+
+        for (i = 0; (i < APP_DNS_MAX_ADDRESSES) && (count < APP_DNS_MAX_ADDRESSES); i++)
+        {
+            if (i < ipv6_count)
+                all[count++] = ipv6[i];
+            if ((i < ipv4_count) && (count < APP_DNS_MAX_ADDRESSES))
+                all[count++] = ipv4[i];
         }
     }
 
-    freeaddrinfo(res_list);
+    if (ttl < APP_DNS_MIN_TTL)
+        ttl = APP_DNS_MIN_TTL;
 
-done:
-    return ret;
+    pthread_mutex_lock(&app_dns_lock);
+    {
+        app_dns_entry_t * const entry = job->entry;
+        unsigned long now;
+
+        app_os_get_system_time(&now);
+        memcpy(entry->address, all, count * sizeof all[0]);
+        entry->count = count;
+        entry->expires = now + ttl;
+        entry->state = (count > 0) ? app_dns_ready : app_dns_failed;
+        APP_DEBUG("app_dns_worker: %s has %lu addresses for %lu seconds\n", job->name, (unsigned long)count, ttl);
+    }
+    pthread_mutex_unlock(&app_dns_lock);
+
+    free(job);
+    /* let the connector call the open callback again */
+    app_os_wakeup();
+    return NULL;
 }
 
+static connector_callback_status_t app_dns_start_lookup(app_dns_entry_t * const entry)
+{
+    connector_callback_status_t status = connector_callback_busy;
+    app_dns_job_t * const job = malloc(sizeof *job);
+    pthread_attr_t attr;
+    pthread_t thread;
+    int error;
+
+    if (job == NULL)
+    {
+        status = connector_callback_error;
+        goto done;
+    }
+
+    job->entry = entry;
+    memcpy(job->name, entry->name, sizeof job->name);
+    entry->state = app_dns_pending;
 
-void app_dns_set_redirected(connector_class_id_t const class_id, int const state)
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    error = pthread_create(&thread, &attr, app_dns_worker, job);
+    pthread_attr_destroy(&attr);
+    if (error != 0)
+    {
+        APP_DEBUG("app_dns_start_lookup: pthread_create failed, error %d\n", error);
+        entry->state = app_dns_empty;
+        free(job);
+        status = connector_callback_error;
+    }
+
+done:
+    return status;
+}
+
+/* Called with app_dns_lock held, name fits in an entry: the entry for the name, or the least recently used one without a lookup in flight. */
+static app_dns_entry_t * app_dns_get_entry(connector_class_id_t const class_id, char const * const name)
 {
-    UNUSED_ARGUMENT(class_id);
-    app_dns_cache.is_redirected = state;
+    app_dns_entry_t * entry = NULL;
+    size_t i;
+
+    for (i = 0; i < APP_DNS_CACHE_SIZE; i++)
+    {
+        app_dns_entry_t * const candidate = &app_dns_cache[i];
+
+        if ((candidate->state != app_dns_empty) && (candidate->class_id == class_id) &&
+            (strcmp(candidate->name, name) == 0))
+        {
+            entry = candidate;
+            goto done;
+        }
+
+        if (candidate->state == app_dns_pending)
+            continue;
+
+        if ((entry == NULL) || (candidate->state == app_dns_empty) ||
+            ((entry->state != app_dns_empty) && (candidate->last_used < entry->last_used)))
+            entry = candidate;
+    }
+
+    if (entry != NULL)
+    {
+        entry->class_id = class_id;
+        strcpy(entry->name, name);
+        entry->state = app_dns_empty;
+        entry->count = 0;
+    }
+
+done:
+    return entry;
 }
 
-void app_dns_cache_invalidate(connector_class_id_t const class_id)
+connector_callback_status_t app_dns_resolve_all(connector_class_id_t const class_id,
+                                                char const * const device_cloud_url,
+                                                app_dns_address_t * const addresses,
+                                                size_t * const count)
 {
-    if (!app_dns_is_redirected(class_id))
+    connector_callback_status_t status = connector_callback_busy;
+    app_dns_entry_t * entry;
+    unsigned long now;
+
+    if ((device_cloud_url == NULL) || (addresses == NULL) || (count == NULL))
+    {
+        status = connector_callback_abort;
+        goto done;
+    }
+
+    /* numeric addresses need no lookup */
+    *count = 0;
+    {
+        struct in6_addr numeric;
+
+        if (inet_pton(AF_INET6, device_cloud_url, &numeric) == 1)
+            app_dns_add_address(addresses, count, AF_INET6, &numeric);
+        else if (inet_pton(AF_INET, device_cloud_url, &numeric) == 1)
+            app_dns_add_address(addresses, count, AF_INET, &numeric);
+
+        if (*count > 0)
+        {
+            status = connector_callback_continue;
+            goto done;
+        }
+    }
+
+    /* a truncated name would never match its own entry */
+    if (strlen(device_cloud_url) >= APP_MAX_HOST_NAME)
+    {
+        APP_DEBUG("app_dns_resolve: %s is too long\n", device_cloud_url);
+        status = connector_callback_error;
+        goto done;
+    }
+
+    app_os_get_system_time(&now);
+    pthread_mutex_lock(&app_dns_lock);
+
+    entry = app_dns_get_entry(class_id, device_cloud_url);
+    if (entry == NULL)
+        goto unlock; /* every entry has a lookup in flight */
+
+    switch (entry->state)
     {
-        app_dns_cache.ip_addr = INADDR_NONE;
+    case app_dns_ready:
+        if (now < entry->expires)
+        {
+            memcpy(addresses, entry->address, entry->count * sizeof entry->address[0]);
+            *count = entry->count;
+            entry->last_used = now;
+            status = connector_callback_continue;
+            break;
+        }
+        /* expired, look it up again */
+        entry->state = app_dns_empty;
+        /* fall through */
+    case app_dns_empty:
+        entry->last_used = now;
+        status = app_dns_start_lookup(entry);
+        break;
+
+    case app_dns_pending:
+        break;
+
+    case app_dns_failed:
+        /* report it once, the next call starts over */
+        APP_DEBUG("app_dns_resolve: Can't resolve DNS for %s\n", device_cloud_url);
+        entry->state = app_dns_empty;
+        status = connector_callback_error;
+        break;
     }
+
+unlock:
+    pthread_mutex_unlock(&app_dns_lock);
+    /* a lookup in flight calls app_os_wakeup() when it is done */
+    if (status == connector_callback_busy)
+        app_os_wait_for_wakeup();
+
+done:
+    return status;
 }
 
 connector_callback_status_t app_dns_resolve(connector_class_id_t const class_id,
                                        char const * const device_cloud_url,
                                        in_addr_t * const ip_addr)
 {
-    connector_callback_status_t status = connector_callback_error;
+    app_dns_address_t address[APP_DNS_MAX_ADDRESSES];
+    size_t count;
+    connector_callback_status_t status;
 
-    if ((device_cloud_url == NULL) || (ip_addr == NULL))
+    if (ip_addr == NULL)
     {
         status = connector_callback_abort;
         goto done;
     }
-    *ip_addr = inet_addr(device_cloud_url);
 
-    if (*ip_addr == INADDR_NONE)
+    status = app_dns_resolve_all(class_id, device_cloud_url, address, &count);
+    if (status == connector_callback_continue)
     {
-        if (!app_dns_cache_is_valid(class_id, device_cloud_url, ip_addr))
+        size_t i;
+
+        /* callers of this one only speak IPv4 */
+        status = connector_callback_error;
+        for (i = 0; i < count; i++)
         {
-            if (app_dns_resolve_name(device_cloud_url, ip_addr) == 0)
+            if (address[i].addr.ss_family == AF_INET)
             {
-                app_dns_cache_update(class_id, device_cloud_url, *ip_addr);
-            }
-            else
-            {
-                APP_DEBUG("app_dns_resolve: Can't resolve DNS for %s\n", device_cloud_url);
-                goto done;
+                struct sockaddr_in const * const sin = cast_for_alignment(struct sockaddr_in const *, &address[i].addr);
+
+                *ip_addr = sin->sin_addr.s_addr;
+                status = connector_callback_continue;
+                break;
             }
         }
     }
-    status = connector_callback_continue;
 
 done:
     return status;
 }
-#endif
 
+void app_dns_cache_invalidate(connector_class_id_t const class_id)
+{
+    size_t i;
+
+    pthread_mutex_lock(&app_dns_lock);
+    for (i = 0; i < APP_DNS_CACHE_SIZE; i++)
+    {
+        if ((app_dns_cache[i].class_id == class_id) && (app_dns_cache[i].state == app_dns_ready))
+            app_dns_cache[i].state = app_dns_empty;
+    }
+    pthread_mutex_unlock(&app_dns_lock);
+}
+#endif
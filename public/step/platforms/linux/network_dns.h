@@ -20,10 +20,26 @@
 #ifndef _NETWORK_DNS_H
 #define _NETWORK_DNS_H
 
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* addresses kept per name, IPv6 and IPv4 interleaved for happy eyeballs */
+#define APP_DNS_MAX_ADDRESSES   4
+
+typedef struct
+{
+    struct sockaddr_storage addr;
+    socklen_t length;
+} app_dns_address_t;
+
+/* Name lookups run in the background; both return connector_callback_busy until the answer arrives. */
 extern connector_callback_status_t app_dns_resolve(connector_class_id_t const class_id,
                                                char const * const domain_name,
                                                in_addr_t * const ip_addr);
-extern void app_dns_set_redirected(connector_class_id_t const class_id, int const state);
+extern connector_callback_status_t app_dns_resolve_all(connector_class_id_t const class_id,
+                                                       char const * const domain_name,
+                                                       app_dns_address_t * const addresses,
+                                                       size_t * const count);
 extern void app_dns_cache_invalidate(connector_class_id_t const class_id);
 
 #endif
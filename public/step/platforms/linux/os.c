@@ -20,6 +20,8 @@
 #include <malloc.h>
 #include <time.h>
 #include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
 #include "connector_api.h"
 #include "platform.h"
 #ifdef ENV_LINUX
@@ -82,29 +84,85 @@ done:
     return status;
 }
 
+/* CLOCK_MONOTONIC does not jump when the wall clock is adjusted */
 connector_callback_status_t app_os_get_system_time(unsigned long * const uptime)
 {
-    static time_t start_system_up_time;
-    time_t present_time;
+    struct timespec present_time;
 
-    time(&present_time);
+    clock_gettime(CLOCK_MONOTONIC, &present_time);
+    *uptime = (unsigned long) present_time.tv_sec;
 
-    if (start_system_up_time == 0)
-       start_system_up_time = present_time;
+    return connector_callback_continue;
+}
+
+connector_callback_status_t app_os_get_system_time_in_milliseconds(unsigned long * const uptime)
+{
+    struct timespec present_time;
 
-    present_time -= start_system_up_time;
-    *uptime = (unsigned long) present_time;
+    clock_gettime(CLOCK_MONOTONIC, &present_time);
+    /* wraps around on 32-bit unsigned long, Cloud Connector only uses differences */
+    *uptime = ((unsigned long) present_time.tv_sec * 1000) + (unsigned long) (present_time.tv_nsec / 1000000);
 
     return connector_callback_continue;
 }
 
+/* An idle connector sleeps until app_os_wakeup() is called or the timeout passes */
+static pthread_mutex_t app_wakeup_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t app_wakeup_cond = PTHREAD_COND_INITIALIZER;
+static int app_wakeup_pending;
+/* set by a callback that stays busy until a worker calls app_os_wakeup(), only the connector thread touches it */
+static connector_bool_t app_wait_for_wakeup = connector_false;
+
+void app_os_wait_for_wakeup(void)
+{
+    app_wait_for_wakeup = connector_true;
+}
+
+static void app_os_wait(long const timeout_in_milliseconds)
+{
+    struct timespec deadline;
+    int error = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_in_milliseconds / 1000;
+    deadline.tv_nsec += (timeout_in_milliseconds % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&app_wakeup_lock);
+    while (!app_wakeup_pending && error != ETIMEDOUT)
+        error = pthread_cond_timedwait(&app_wakeup_cond, &app_wakeup_lock, &deadline);
+    app_wakeup_pending = 0;
+    pthread_mutex_unlock(&app_wakeup_lock);
+}
+
 connector_callback_status_t app_os_yield(connector_status_t const * const status)
 {
     if (*status == connector_idle)
     {
-        unsigned int const timeout_in_microseconds =  100000;
-        usleep(timeout_in_microseconds);
+        long const timeout_in_milliseconds = 100;
+
+        app_os_wait(timeout_in_milliseconds);
+    }
+    else if (app_wait_for_wakeup)
+    {
+        /* connector_pending has no timer to wait for, poll it again at most this late */
+        app_os_wait(APP_WAKEUP_WAIT_IN_MILLISECONDS);
     }
+    app_wait_for_wakeup = connector_false;
+
+    return connector_callback_continue;
+}
+
+connector_callback_status_t app_os_wakeup(void)
+{
+    pthread_mutex_lock(&app_wakeup_lock);
+    app_wakeup_pending = 1;
+    pthread_cond_signal(&app_wakeup_cond);
+    pthread_mutex_unlock(&app_wakeup_lock);
 
     return connector_callback_continue;
 }
@@ -156,6 +214,13 @@ connector_callback_status_t app_os_handler(connector_request_id_os_t const reque
         }
         break;
 
+    case connector_request_id_os_system_up_time_in_milliseconds:
+        {
+            connector_os_system_up_time_in_milliseconds_t * p = data;
+            status = app_os_get_system_time_in_milliseconds(&p->sys_uptime_in_milliseconds);
+        }
+        break;
+
     case connector_request_id_os_yield:
         {
             connector_os_yield_t * p = data;
@@ -167,6 +232,10 @@ connector_callback_status_t app_os_handler(connector_request_id_os_t const reque
         status = app_os_reboot();
         break;
 
+    case connector_request_id_os_wakeup:
+        status = app_os_wakeup();
+        break;
+
     default:
         APP_DEBUG("app_os_handler: unrecognized request [%d]\n", request);
         status = connector_callback_unrecognized;
@@ -65,11 +65,28 @@ extern connector_callback_status_t app_file_system_handler(connector_request_id_
 extern int application_step(connector_handle_t handle);
 
 extern connector_callback_status_t app_os_get_system_time(unsigned long * const uptime);
+extern connector_callback_status_t app_os_get_system_time_in_milliseconds(unsigned long * const uptime);
+#define APP_WAKEUP_WAIT_IN_MILLISECONDS 100
+
+extern connector_callback_status_t app_os_yield(connector_status_t const * const status);
+/* the next app_os_yield() also blocks when the connector is pending, until app_os_wakeup() */
+extern void app_os_wait_for_wakeup(void);
+extern connector_callback_status_t app_os_wakeup(void);
 
 extern connector_bool_t app_connector_reconnect(connector_class_id_t const class_id, connector_close_status_t const status);
 extern connector_callback_status_t app_status_handler(connector_request_id_status_t const request,
                                                       void * const data);
 
+/* TLS handshake of the last connection, kept by network_tcp_ssl.c */
+typedef struct {
+    unsigned long handshake_ms;
+    connector_bool_t resumed;
+    unsigned long full_handshakes;
+    unsigned long resumed_handshakes;
+} app_ssl_handshake_t;
+
+extern void app_ssl_get_handshake(app_ssl_handshake_t * const handshake);
+
 #if !(defined APP_SSL_CA_CERT_PATH)
 #define APP_SSL_CA_CERT_PATH   "../../../../public/certificates/Digi_Int-ca-cert-public.crt"
 #endif
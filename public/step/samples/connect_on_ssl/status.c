@@ -29,9 +29,16 @@ static connector_callback_status_t app_tcp_status(connector_status_tcp_event_t c
     switch (tcp_event->status)
     {
     case connector_tcp_communication_started:
+    {
+        app_ssl_handshake_t handshake;
+
         keepalive_missed_count = 0;
-        APP_DEBUG("connector_tcp_communication_started\n");
+        app_ssl_get_handshake(&handshake);
+        APP_DEBUG("connector_tcp_communication_started: %s TLS handshake in %lu ms (%lu full, %lu resumed)\n",
+                  handshake.resumed ? "resumed" : "full", handshake.handshake_ms,
+                  handshake.full_handshakes, handshake.resumed_handshakes);
         break;
+    }
     case connector_tcp_keepalive_missed:
         if (keepalive_missed_count > 0)
             APP_DEBUG("connector_tcp_keepalive_missed\n");
@@ -674,6 +674,9 @@ public class ConfigGenerator {
                 Descriptors descriptors = new Descriptors(username, password,
                         vendorId, deviceType, fwVersion);
 
+                /* the generated files carry the descriptor hash */
+                descriptors.generateDescriptors(configData);
+
                 FileNone fileNone = new FileNone(directoryPath);
                 fileNone.generateFile(configData);
 
@@ -689,6 +692,9 @@ public class ConfigGenerator {
                 Descriptors descriptorsSource = new Descriptors(username, password,
                         vendorId, deviceType, fwVersion);
 
+                /* the generated files carry the descriptor hash */
+                descriptorsSource.generateDescriptors(configData);
+
                 if (useCcapi())
                 {
                     FileSourceCcapi ccapiSource = new FileSourceCcapi(directoryPath);
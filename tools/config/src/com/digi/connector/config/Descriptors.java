@@ -8,8 +8,10 @@ import java.io.IOException;
 import java.io.InputStreamReader;
 import java.io.OutputStreamWriter;
 import java.net.URL;
+import java.security.MessageDigest;
 import java.util.LinkedHashMap;
 import java.util.LinkedList;
+import java.util.Map;
 
 import javax.net.ssl.HttpsURLConnection;
 import javax.xml.bind.DatatypeConverter;
@@ -36,6 +38,8 @@ public class Descriptors {
     private final long fwVersion;
     private Boolean callDeleteFlag;
     private int responseCode;
+    private final LinkedHashMap<String, String> descriptorSet = new LinkedHashMap<String, String>();
+    private static String descriptorHash;
 
     public Descriptors(final String username, final String password,
                        final String vendorId, final String deviceType, 
@@ -63,40 +67,62 @@ public class Descriptors {
         this.responseCode = 0;
     }
 
+    public void generateDescriptors(ConfigData configData) throws Exception {
+        int id = 1;
+
+        descriptorSet.clear();
+        for (GroupType type : GroupType.values()) {
+            LinkedList<Group> groups = null;
+
+            String configType = type.toString().toLowerCase();
+            
+            try {
+                groups = configData.getConfigGroup(configType);
+
+            } catch (Exception e) {
+                /* end of the ConfigData ConfigType */
+                break;
+            }
+
+            /* Descriptors must be uploaded even if the group is empty */
+            sendDescriptors(configType, groups, configData, id);
+            /* add 2 because sendDescriptors uploads 2 sets of descriptors (query and set ). */
+            id += 2;
+        }
+
+        if(ConfigGenerator.rciLegacyEnabled()){
+            sendRebootDescriptor();
+            sendDoCommandDescriptor();
+            sendSetFactoryDefaultDescriptor();
+        }
+
+        sendRciDescriptors(configData);
+
+        /* The hash only covers the descriptor contents so firmware versions sharing descriptors share the hash */
+        MessageDigest digest = MessageDigest.getInstance("SHA-1");
+        for (Map.Entry<String, String> descriptor : descriptorSet.entrySet()) {
+            digest.update(descriptor.getKey().getBytes("UTF-8"));
+            digest.update((byte)0);
+            digest.update(descriptor.getValue().getBytes("UTF-8"));
+            digest.update((byte)0);
+        }
+        descriptorHash = DatatypeConverter.printHexBinary(digest.digest()).toLowerCase();
+        ConfigGenerator.debug_log("Descriptor hash: " + descriptorHash);
+    }
+
     public void processDescriptors(ConfigData configData) throws Exception {
 
         if (ConfigGenerator.deleteDescriptorOption()) {
             deleteDescriptors();
         } else {
             ConfigGenerator.log("\nProcessing Descriptors, please wait...");
-            int id = 1;
-            for (GroupType type : GroupType.values()) {
-                LinkedList<Group> groups = null;
-
-                String configType = type.toString().toLowerCase();
-                
-                try {
-                    groups = configData.getConfigGroup(configType);
-
-                } catch (Exception e) {
-                    /* end of the ConfigData ConfigType */
-                    break;
-                }
-
-                /* Descriptors must be uploaded even if the group is empty */
-                sendDescriptors(configType, groups, configData, id);
-                /* add 2 because sendDescriptors uploads 2 sets of descriptors (query and set ). */
-                id += 2;
-            }
+            if (descriptorSet.isEmpty())
+                generateDescriptors(configData);
 
-            if(ConfigGenerator.rciLegacyEnabled()){
-                sendRebootDescriptor();
-                sendDoCommandDescriptor();
-                sendSetFactoryDefaultDescriptor();
+            for (Map.Entry<String, String> descriptor : descriptorSet.entrySet()) {
+                uploadDescriptor(descriptor.getKey(), descriptor.getValue());
             }
 
-            sendRciDescriptors(configData);
-
             if(!ConfigGenerator.noUploadOption())
                 ConfigGenerator.log("\nDescriptors were uploaded successfully.");
             if(ConfigGenerator.saveDescriptorOption())
@@ -163,7 +189,7 @@ public class Descriptors {
 
         reboot_descriptor = reboot_descriptor.replace('`', '"');
 
-        uploadDescriptor("descriptor/reboot", reboot_descriptor);
+        addDescriptor("descriptor/reboot", reboot_descriptor);
     }
 
     private void sendDoCommandDescriptor() throws Exception {
@@ -176,7 +202,7 @@ public class Descriptors {
 
         do_command_descriptor = do_command_descriptor.replace('`', '"');
 
-        uploadDescriptor("descriptor/do_command", do_command_descriptor);
+        addDescriptor("descriptor/do_command", do_command_descriptor);
     }
 
     private void sendSetFactoryDefaultDescriptor() throws Exception {
@@ -187,7 +213,7 @@ public class Descriptors {
 
         set_factory_default_descriptor = set_factory_default_descriptor.replace('`', '"');
 
-        uploadDescriptor("descriptor/set_factory_default", set_factory_default_descriptor);
+        addDescriptor("descriptor/set_factory_default", set_factory_default_descriptor);
     }
 
     private int getBinId(BufferedReader bin_id_reader, String BinIdKey) throws IOException {
@@ -243,6 +269,8 @@ public class Descriptors {
                                + "      <value value=`stored` desc=`Settings stored in flash` bin_id=`2` />"
                                + "      <value value=`defaults` desc=`Device defaults` bin_id=`3` />"
                                + "  </attr>";
+        else
+            query_descriptors += "  <attr name=`since` type=`uint32` desc=`Return only state changed since the query that returned this token` bin_id=`0` default=`0` />";
 
         query_descriptors += String.format("<format_define name=`all_%ss_groups`>\n", config_type);
 
@@ -356,8 +384,8 @@ public class Descriptors {
         query_descriptors = query_descriptors.replace('`', '"');
         set_descriptors = set_descriptors.replace('`', '"');
 
-        uploadDescriptor("descriptor/query_" + config_type, query_descriptors);
-        uploadDescriptor("descriptor/set_" + config_type, set_descriptors);
+        addDescriptor("descriptor/query_" + config_type, query_descriptors);
+        addDescriptor("descriptor/set_" + config_type, set_descriptors);
 
         if (createBinIdLog) {
             try {
@@ -410,7 +438,7 @@ public class Descriptors {
 
         descriptors = descriptors.replace('`', '"');
 
-        uploadDescriptor("descriptor", descriptors);
+        addDescriptor("descriptor", descriptors);
     }
 
     private String sendCloudData(String target, String method, String message) {
@@ -569,6 +597,10 @@ public class Descriptors {
         return buffer.replace("<", "&lt;").replace(">", "&gt;");
     }
 
+    private void addDescriptor(String descName, String buffer) {
+        descriptorSet.put(descName, buffer);
+    }
+
     private void uploadDescriptor(String descName, String buffer) {
 
         if(!ConfigGenerator.noUploadOption())
@@ -652,4 +684,8 @@ public class Descriptors {
         return deviceType;
     }
 
+    public static String descriptorHash(){
+        return descriptorHash;
+    }
+
 }
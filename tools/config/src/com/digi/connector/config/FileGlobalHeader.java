@@ -19,6 +19,7 @@ public class FileGlobalHeader extends FileGenerator {
     "    uint32_t firmware_target_zero_version;\n" +
     "    uint32_t vendor_id;\n" +
     "    char const * device_type;\n" +
+    "    char const * descriptor_hash;\n" +
     "} connector_remote_config_data_t;\n";
     
 	public FileGlobalHeader(String directoryPath) throws IOException {
@@ -40,6 +40,7 @@ public class FileNone extends FileGenerator {
     "    uint32_t firmware_target_zero_version;\n" +
     "    uint32_t vendor_id;\n" +
     "    char const * device_type;\n" +
+    "    char const * descriptor_hash;\n" +
     "} connector_remote_config_data_t;\n";
 
 
@@ -158,10 +159,11 @@ public class FileNone extends FileGenerator {
             "    %d,\n"+
             "    0x%X,\n"+
             "    %s,\n"+
+            "    \"%s\",\n"+
             "    \"%s\"\n"+
             "};\n"+
             "\n"+
             "connector_remote_config_data_t const * const rci_descriptor_data = &%srci_internal_data;"
-            , prefix, GlobalErrorCount, ConfigGenerator.getFirmware(), Descriptors.vendorId(),Descriptors.deviceType(), prefix));
+            , prefix, GlobalErrorCount, ConfigGenerator.getFirmware(), Descriptors.vendorId(),Descriptors.deviceType(), Descriptors.descriptorHash(), prefix));
     }
 }
\ No newline at end of file
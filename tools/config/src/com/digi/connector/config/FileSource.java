@@ -94,11 +94,12 @@ public class FileSource extends FileGenerator {
                     "    %d,\n"+
                     "    %d,\n"+
                     "    %s,\n"+
+                    "    \"%s\",\n"+
                     "    \"%s\"\n"+
                     "};\n"+
                     "\n"+
                     "connector_remote_config_data_t const * const %srci_descriptor_data = &%srci_internal_data;"
-                    , prefix, GlobalErrorCount, ConfigGenerator.getFirmware(), Descriptors.vendorId(),Descriptors.deviceType(), prefix, prefix));
+                    , prefix, GlobalErrorCount, ConfigGenerator.getFirmware(), Descriptors.vendorId(),Descriptors.deviceType(), Descriptors.descriptorHash(), prefix, prefix));
             
             headerWriter.write(String.format("\n#endif\n"));
  
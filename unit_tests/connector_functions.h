@@ -16,7 +16,7 @@ connector_status_t malloc_data(connector_data_t *const connector_ptr, size_t con
 connector_status_t free_data(connector_data_t *const connector_ptr, void *const ptr);
 connector_status_t malloc_data_buffer(connector_data_t *const connector_ptr, size_t const length, connector_static_buffer_id_t id, void **ptr);
 connector_status_t free_data_buffer(connector_data_t *const connector_ptr, connector_static_buffer_id_t id, void *const ptr);
-connector_status_t yield_process(connector_data_t *const connector_ptr, connector_status_t const status);
+connector_status_t yield_process(connector_data_t *const connector_ptr, connector_status_t const status, unsigned long const timeout_in_milliseconds);
 connector_status_t connector_reboot(connector_data_t *const connector_ptr);
 connector_status_t notify_error_status(connector_callback_t const callback, connector_class_id_t const class_number, connector_request_id_t const request_number, connector_status_t const status, void *const context);
 connector_status_t get_config_device_id(connector_data_t *const connector_ptr);
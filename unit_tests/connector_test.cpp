@@ -1,5 +1,6 @@
 #include "CppUTest/CommandLineTestRunner.h"
 #include "CppUTestExt/MockSupport.h"
+#include <unistd.h>
 
 extern "C"
 {
@@ -7,6 +8,12 @@ extern "C"
 
 size_t dp_process_string(char * const string, char * const buffer, size_t const bytes_available, size_t * bytes_used_ptr, connector_bool_t need_quotes, connector_bool_t first_chunk);
 connector_bool_t string_needs_quotes(char const * const string);
+uint16_t sm_calculate_crc16(uint16_t crc, uint8_t const * const data, size_t const bytes);
+int sm_encode85(uint8_t * dest, size_t dest_len, uint8_t const * const src, size_t const src_len);
+int sm_decode85(uint8_t * dest, size_t dest_len, uint8_t const * const src, size_t const src_len);
+size_t msg_next_recv_window(size_t const window, size_t const bytes, unsigned long const elapsed_ms, unsigned long const rtt_ms, size_t const limit);
+unsigned long msg_next_rtt(unsigned long const rtt_ms, unsigned long const sample_ms);
+#include "network_dns.h"
 
 }
 
@@ -215,3 +222,254 @@ TEST(dp_process_string_test, testBufferOverrun)
 
     CHECK(buffer[bytes_processed] != '\0');
 }
+
+TEST_GROUP(sm_crc16_test) {};
+
+static uint16_t crc16_bitwise(uint16_t crc, uint8_t const * const data, size_t const bytes)
+{
+    for (size_t i = 0; i < bytes; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+
+    return crc;
+}
+
+TEST(sm_crc16_test, testCheckValue)
+{
+    char const check[] = "123456789";
+
+    CHECK_EQUAL(0xBB3D, sm_calculate_crc16(0, (uint8_t const *)check, strlen(check)));
+}
+
+TEST(sm_crc16_test, testMatchesBitwise)
+{
+    uint8_t data[300];
+
+    for (size_t i = 0; i < sizeof data; i++)
+        data[i] = (uint8_t)((i * 131) ^ (i >> 3));
+
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t bytes = 0; bytes + offset <= sizeof data; bytes += 7)
+        {
+            uint16_t const seed = (uint16_t)(bytes * 0x9E37);
+
+            CHECK_EQUAL(crc16_bitwise(seed, data + offset, bytes), sm_calculate_crc16(seed, data + offset, bytes));
+        }
+    }
+}
+
+TEST_GROUP(sm_base85_test) {};
+
+TEST(sm_base85_test, testEncode)
+{
+    uint8_t const data[] = {0x00, 0x01, 0x02, 0x03, 0xFF, 0xFE, 0xFD, 0x80, 0x7F};
+    uint8_t encoded[32];
+    int bytes;
+
+    bytes = sm_encode85(encoded, sizeof encoded, data, sizeof data);
+    CHECK_EQUAL(12, bytes);
+    MEMCMP_EQUAL("!!*-'x8MyIIk", encoded, 12);
+
+    bytes = sm_encode85(encoded, 7, data, sizeof data);
+    CHECK_EQUAL(7, bytes);
+    MEMCMP_EQUAL("!!*-'x8", encoded, 7);
+}
+
+TEST(sm_base85_test, testRoundTrip)
+{
+    uint8_t data[130];
+    uint8_t encoded[200];
+    uint8_t decoded[200];
+
+    for (size_t i = 0; i < sizeof data; i++)
+        data[i] = (uint8_t)(255 - (i * 37));
+
+    for (size_t bytes = 0; bytes <= sizeof data; bytes++)
+    {
+        int const encoded_bytes = sm_encode85(encoded, sizeof encoded, data, bytes);
+        int decoded_bytes;
+
+        CHECK_EQUAL(bytes + (bytes + 3) / 4, (size_t)encoded_bytes);
+        decoded_bytes = sm_decode85(decoded, sizeof decoded, encoded, encoded_bytes);
+        CHECK_EQUAL(bytes, (size_t)decoded_bytes);
+        MEMCMP_EQUAL(data, decoded, bytes);
+    }
+}
+
+TEST_GROUP(msg_recv_window_test) {};
+
+/* Device Cloud sends at link_rate bytes per ms while it has window, the device acks every half window
+ * and samples the round trip the way msg_sample_rtt() does. Returns the bytes delivered in duration_ms,
+ * the ack count goes to acks and the window of the last ack to last_window.
+ */
+static unsigned long msg_window_model(unsigned long const rtt_ms, size_t const limit, unsigned long const duration_ms,
+                                      unsigned long * const acks, size_t * const last_window)
+{
+    enum { link_rate = 125, max_delay = 1000 };
+    size_t arriving[max_delay / 2 + 1] = {0};
+    size_t window = 4 * 1460;
+    size_t cloud_edge = window;
+    size_t pending_edge = 0;
+    unsigned long pending_time = 0;
+    size_t sent = 0, received = 0, ack_count = 0;
+    unsigned long ack_time = 0;
+    size_t probe_edge = 0;
+    unsigned long probe_time = 0;
+    unsigned long rtt_estimate = 0;
+    unsigned long const one_way = rtt_ms / 2;
+
+    *acks = 0;
+    for (unsigned long now = 1; now <= duration_ms; now++)
+    {
+        size_t const slot = now % (one_way + 1);
+
+        received += arriving[slot];
+        arriving[slot] = 0;
+        if ((probe_edge != 0) && (received > probe_edge))
+        {
+            rtt_estimate = msg_next_rtt(rtt_estimate, now - probe_time);
+            probe_edge = 0;
+        }
+        if ((pending_edge != 0) && (now >= pending_time + one_way))
+        {
+            cloud_edge = pending_edge;
+            pending_edge = 0;
+        }
+
+        if (sent < cloud_edge)
+        {
+            size_t const bytes = (cloud_edge - sent < link_rate) ? cloud_edge - sent : link_rate;
+
+            arriving[(now + one_way) % (one_way + 1)] += bytes;
+            sent += bytes;
+        }
+
+        if (received - ack_count > window / 2)
+        {
+            if (probe_edge == 0)
+            {
+                probe_edge = ack_count + window;
+                probe_time = now;
+            }
+            if (ack_time != 0)
+                window = msg_next_recv_window(window, received - ack_count, now - ack_time, rtt_estimate, limit);
+            ack_count = received;
+            ack_time = now;
+            pending_edge = ack_count + window;
+            pending_time = now;
+            (*acks)++;
+        }
+    }
+
+    *last_window = window;
+    return received;
+}
+
+TEST(msg_recv_window_test, testBounds)
+{
+    size_t const min_window = 4 * 1460;
+
+    CHECK_EQUAL(min_window, msg_next_recv_window(min_window, 100, 1000, 1000, 16 * 1460));
+    CHECK_EQUAL(2 * min_window, msg_next_recv_window(min_window, min_window, 10, 1000, 16 * 1460));
+    CHECK_EQUAL(16 * 1460, msg_next_recv_window(12 * 1460, min_window, 10, 1000, 16 * 1460));
+    CHECK_EQUAL(6 * 1460, msg_next_recv_window(12 * 1460, 1, 1000, 1, 16 * 1460));
+    CHECK_EQUAL(min_window, msg_next_recv_window(min_window, min_window, 10, 1000, min_window));
+    CHECK_EQUAL(min_window, msg_next_recv_window(min_window, min_window, 0, 0, 16 * 1460));
+}
+
+TEST(msg_recv_window_test, testThroughputGain)
+{
+    unsigned long const rtts[] = {50, 300, 1000};
+    unsigned long const min_gain_percent[] = {150, 300, 300};
+
+    for (size_t i = 0; i < sizeof rtts / sizeof rtts[0]; i++)
+    {
+        unsigned long fixed_acks, adaptive_acks;
+        size_t fixed_window, adaptive_window;
+        unsigned long const fixed = msg_window_model(rtts[i], 4 * 1460, 60000, &fixed_acks, &fixed_window);
+        unsigned long const adaptive = msg_window_model(rtts[i], 16 * 1460, 60000, &adaptive_acks, &adaptive_window);
+
+        CHECK_EQUAL((size_t)(4 * 1460), fixed_window);
+        CHECK_EQUAL((size_t)(16 * 1460), adaptive_window);
+        CHECK(adaptive * 100 >= fixed * min_gain_percent[i]);
+        CHECK((adaptive / adaptive_acks) >= (fixed / fixed_acks));
+    }
+}
+
+TEST(msg_recv_window_test, testRttSamples)
+{
+    size_t const limit = 16 * 1460;
+    size_t const bytes = 2 * 1460;  /* arrived between two acks */
+    unsigned long const elapsed_ms = 100;
+    size_t window = 4 * 1460;
+    unsigned long rtt_ms = 0;
+
+    /* no sample yet, nothing to size the window with */
+    CHECK_EQUAL(window, msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit));
+
+    rtt_ms = msg_next_rtt(rtt_ms, 300);
+    CHECK_EQUAL(300UL, rtt_ms);
+    CHECK_EQUAL(400UL, msg_next_rtt(rtt_ms, 1100));
+
+    /* 300ms round trips use the window up before the ack is back: it grows up to the limit */
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL((size_t)(8 * 1460), window);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL(limit, window);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL(limit, window);
+
+    /* one short round trip barely moves the estimate, the window is kept */
+    rtt_ms = msg_next_rtt(rtt_ms, 10);
+    CHECK_EQUAL(263UL, rtt_ms);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL(limit, window);
+
+    /* once the estimate follows the short round trips the window is far more than needed and shrinks */
+    for (int i = 0; i < 32; i++)
+        rtt_ms = msg_next_rtt(rtt_ms, 10);
+    CHECK(rtt_ms < 20);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL((size_t)(8 * 1460), window);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL((size_t)(4 * 1460), window);
+    window = msg_next_recv_window(window, bytes, elapsed_ms, rtt_ms, limit);
+    CHECK_EQUAL((size_t)(4 * 1460), window);
+}
+
+TEST_GROUP(dns_cache_test) {};
+
+TEST(dns_cache_test, testNameTooLong)
+{
+    char name[300];
+    app_dns_address_t addresses[APP_DNS_MAX_ADDRESSES];
+    size_t count;
+
+    memset(name, 'a', sizeof name - 1);
+    name[sizeof name - 1] = '\0';
+    CHECK_EQUAL(connector_callback_error, app_dns_resolve_all(connector_class_id_network_tcp, name, addresses, &count));
+    CHECK_EQUAL((size_t)0, count);
+}
+
+/* a name longer than 64 characters has to find its own lookup again, the label is too long to reach a server */
+TEST(dns_cache_test, testLongNameHitsItsEntry)
+{
+    char name[100];
+    app_dns_address_t addresses[APP_DNS_MAX_ADDRESSES];
+    size_t count;
+    connector_callback_status_t status = connector_callback_busy;
+
+    memset(name, 'a', 80);
+    strcpy(&name[80], ".invalid");
+    for (int i = 0; (i < 500) && (status == connector_callback_busy); i++)
+    {
+        status = app_dns_resolve_all(connector_class_id_network_tcp, name, addresses, &count);
+        if (status == connector_callback_busy)
+            usleep(10000);
+    }
+    CHECK_EQUAL(connector_callback_error, status);
+}